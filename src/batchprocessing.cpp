@@ -0,0 +1,619 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "batchprocessing.h"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <map>
+#include <cstring>
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDirIterator>
+#include <QTextStream>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+
+#include <opencv/cv.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include <octdata/datastruct/oct.h>
+#include <octdata/datastruct/series.h>
+#include <octdata/datastruct/bscan.h>
+#include <octdata/octfileread.h>
+#include <octdata/filereadoptions.h>
+
+#include <data_structure/programoptions.h>
+#include <data_structure/slobscandistancemap.h>
+#include <helper/ptreehelper.h>
+#include <manager/octdatamanager.h>
+#include <manager/octmarkerio.h>
+#include <markermodules/bscanlayersegmentation/bscanlayersegmentation.h>
+#include <markermodules/bscanlayersegmentation/bscanlayersegptree.h>
+#include <markermodules/bscanlayersegmentation/layersegmentationio.h>
+#include <markermodules/bscanlayersegmentation/thicknessmap.h>
+#include <markermodules/bscanlayersegmentation/thicknessmaptemplates.h>
+#include <markermodules/bscanlayersegmentation/colormaphsv.h>
+
+#include <buildconstants.h>
+
+namespace bpt = boost::property_tree;
+
+
+namespace
+{
+	const char* layerSegmentationId = "LayerSegmentation";
+
+	struct BatchConfig
+	{
+		BatchProcessing::Operation operation = BatchProcessing::Operation::Unknown;
+		OctMarkerFileformat format = OctMarkerFileformat::Json;
+		QString outputDir;
+		std::size_t thicknessmapTemplate = 0;
+	};
+
+	struct InputFile
+	{
+		QString filename;
+		QString relativeDir; // of the file in an input directory, recreated in the output directory
+	};
+
+	struct JobResult
+	{
+		QString filename;
+		QString outputBase; // output filename without the suffix of the operation
+		bool    success = false;
+		QString error;
+		qint64  time    = 0;
+	};
+
+
+	BatchProcessing::Operation string2Operation(const QString& str)
+	{
+		if(str == "convert"         ) return BatchProcessing::Operation::Convert;
+		if(str == "export-layerseg" ) return BatchProcessing::Operation::ExportLayerSeg;
+		if(str == "thicknessmap"    ) return BatchProcessing::Operation::Thicknessmap;
+		return BatchProcessing::Operation::Unknown;
+	}
+
+	OctMarkerFileformat string2Format(const QString& str)
+	{
+		const QString lower = str.toLower();
+		if(lower == "json" || lower == OctMarkerIO::getFileExtension(OctMarkerFileformat::Json)) return OctMarkerFileformat::Json;
+		if(lower == "xml"  || lower == OctMarkerIO::getFileExtension(OctMarkerFileformat::XML )) return OctMarkerFileformat::XML;
+		if(lower == "info" || lower == OctMarkerIO::getFileExtension(OctMarkerFileformat::INFO)) return OctMarkerFileformat::INFO;
+		if(lower == "bin"  || lower == OctMarkerIO::getFileExtension(OctMarkerFileformat::Binary)) return OctMarkerFileformat::Binary;
+		return OctMarkerFileformat::Unknown;
+	}
+
+
+	bool isMarkerFile(const QString& filename)
+	{
+		switch(OctMarkerIO::getFormatFromExtension(filename.toStdString()))
+		{
+			case OctMarkerFileformat::XML:
+			case OctMarkerFileformat::Json:
+			case OctMarkerFileformat::INFO:
+			case OctMarkerFileformat::Binary:
+				return true;
+			case OctMarkerFileformat::Unknown:
+			case OctMarkerFileformat::Auto:
+			case OctMarkerFileformat::NoExtension:
+				break;
+		}
+		return false;
+	}
+
+	bool isOctFile(const QString& filename)
+	{
+		const QString name = QFileInfo(filename).fileName().toLower();
+		for(const OctData::OctExtension& ext : OctData::OctFileRead::supportedExtensions())
+		{
+			for(const std::string& str : ext.extensions)
+			{
+				if(str.empty())
+					continue;
+
+				const QString extStr = QString::fromStdString(str).toLower();
+				if(str[0] == '.')
+				{
+					if(name.endsWith(extStr))
+						return true;
+				}
+				else if(name == extStr)
+					return true;
+			}
+		}
+		return false;
+	}
+
+	bool acceptFile(const QString& filename, BatchProcessing::Operation operation)
+	{
+		if(operation == BatchProcessing::Operation::Convert)
+			return isMarkerFile(filename);
+		return isOctFile(filename);
+	}
+
+
+	void addInput(std::vector<InputFile>& files, const QString& input, BatchProcessing::Operation operation, bool recursive)
+	{
+		QFileInfo info(input);
+		if(!info.isDir())
+		{
+			files.push_back(InputFile{input, QString()});
+			return;
+		}
+
+		QDirIterator::IteratorFlags flags = recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags;
+		QDirIterator it(input, QDir::Files, flags);
+		QStringList dirFiles;
+		while(it.hasNext())
+		{
+			const QString filename = it.next();
+			if(acceptFile(filename, operation))
+				dirFiles << filename;
+		}
+		dirFiles.sort();
+
+		const QDir inputDir(input);
+		for(const QString& filename : dirFiles)
+			files.push_back(InputFile{filename, inputDir.relativeFilePath(QFileInfo(filename).path())});
+	}
+
+	bool readFileList(std::vector<InputFile>& files, const QString& listFilename)
+	{
+		QFile listFile(listFilename);
+		if(!listFile.open(QIODevice::ReadOnly | QIODevice::Text))
+			return false;
+
+		QTextStream stream(&listFile);
+		while(!stream.atEnd())
+		{
+			const QString line = stream.readLine().trimmed();
+			if(!line.isEmpty() && !line.startsWith('#'))
+				files.push_back(InputFile{line, QString()});
+		}
+		return true;
+	}
+
+
+	QString outputBaseFilename(const BatchConfig& config, const InputFile& input)
+	{
+		QString filename = input.filename;
+		if(config.operation == BatchProcessing::Operation::Convert && isMarkerFile(filename))
+			filename = QFileInfo(filename).dir().filePath(QFileInfo(filename).completeBaseName());
+
+		if(config.outputDir.isEmpty())
+			return filename;
+		const QDir outputDir(QDir(config.outputDir).filePath(input.relativeDir));
+		return QDir::cleanPath(outputDir.filePath(QFileInfo(filename).fileName()));
+	}
+
+	QString seriesFilename(const QString& outputBase, std::size_t seriesNr, std::size_t numSeries, const char* suffix)
+	{
+		QString filename = outputBase;
+		if(numSeries > 1)
+			filename += QString(".series%1").arg(seriesNr);
+		return filename + suffix;
+	}
+
+
+	bool convertMarkers(const BatchConfig& config, const QString& filename, const QString& outputBase, QString& error)
+	{
+		bpt::ptree markers;
+		OctMarkerIO markerIO(&markers);
+
+		std::string markersFilename = filename.toStdString();
+		OctMarkerFileformat inFormat = OctMarkerFileformat::Auto;
+		if(!isMarkerFile(filename))
+		{
+			markersFilename = OctMarkerIO::getDefaultMarkerFilename(filename.toStdString(), inFormat);
+			if(markersFilename.empty())
+			{
+				error = "no marker file found";
+				return false;
+			}
+		}
+
+		if(!markerIO.loadMarkers(markersFilename, inFormat))
+		{
+			error = QString("could not read %1").arg(QString::fromStdString(markersFilename));
+			return false;
+		}
+
+		const std::string outFilename = OctMarkerIO::addMarkerExtension(outputBase.toStdString(), config.format);
+		if(!markerIO.saveMarkers(outFilename, config.format))
+		{
+			error = QString("could not write %1").arg(QString::fromStdString(outFilename));
+			return false;
+		}
+		return true;
+	}
+
+
+	bool createThicknessmap(const BatchConfig& config
+	                      , const OctData::Series& series
+	                      , const std::vector<BScanLayerSegmentation::BScanSegData>& lines
+	                      , const std::string& filename
+	                      , QString& error)
+	{
+		const ThicknessmapTemplates::Configuration& tmConfig = ThicknessmapTemplates::getInstance().getConfigurations().at(config.thicknessmapTemplate);
+
+		const OctData::BScan* bscan = series.getBScan(0);
+		if(!bscan)
+		{
+			error = "series without bscans";
+			return false;
+		}
+
+		ColormapHSV    colormapHSV;
+		ColormapYellow colormapYellow;
+		Colormap* colormap = &colormapHSV;
+		if(tmConfig.getUseColorMap() == ThicknessmapTemplates::UseColorMap::yellow)
+			colormap = &colormapYellow;
+		colormap->setMaxValue(tmConfig.getMaxValue());
+		colormap->setMinValue(tmConfig.getMinValue());
+
+		SloBScanDistanceMap distMap;
+		distMap.createData(&series);
+
+		double factor = bscan->getScaleFactor().getZ()*1000; // milli meter -> micro meter
+
+		ThicknessMap tm;
+		tm.createMap(distMap, lines, tmConfig.getLine1(), tmConfig.getLine2(), factor, *colormap);
+		if(tm.getThicknessMap().empty())
+		{
+			error = "no slo image for thickness map";
+			return false;
+		}
+
+		if(!cv::imwrite(filename, tm.getThicknessMap()))
+		{
+			error = QString("could not write %1").arg(QString::fromStdString(filename));
+			return false;
+		}
+		return true;
+	}
+
+	bool processOctFile(const BatchConfig& config, const QString& filename, const QString& outputBase, QString& error)
+	{
+		OctData::FileReadOptions octOptions;
+		OctDataManager::fillFileReadOptions(octOptions);
+		octOptions.readBScans  = true;
+		octOptions.holdRawData = false;
+
+		OctData::OCT oct;
+		oct = OctData::OctFileRead::openFile(filename.toStdString(), octOptions, nullptr);
+		if(oct.size() == 0)
+		{
+			error = "could not load oct file";
+			return false;
+		}
+
+		bpt::ptree markers;
+		OctMarkerIO markerIO(&markers);
+		markerIO.setSectionFilter({layerSegmentationId});
+		markerIO.loadDefaultMarker(filename.toStdString());
+
+		std::size_t numSeries = 0;
+		for(const OctData::OCT::SubstructurePair& patientPair : oct)
+			for(const OctData::Patient::SubstructurePair& studyPair : *patientPair.second)
+				for(const OctData::Study::SubstructurePair& seriesPair : *studyPair.second)
+					if(seriesPair.second)
+						++numSeries;
+
+		std::size_t seriesNr = 0;
+		for(const OctData::OCT::SubstructurePair& patientPair : oct)
+		{
+			const OctData::Patient* patient = patientPair.second;
+			bpt::ptree& patNode = PTreeHelper::getNodeWithId(markers, "Patient", patient->getInternalId());
+
+			for(const OctData::Patient::SubstructurePair& studyPair : *patient)
+			{
+				const OctData::Study* study = studyPair.second;
+				bpt::ptree& studyNode = PTreeHelper::getNodeWithId(patNode, "Study", study->getInternalId());
+
+				for(const OctData::Study::SubstructurePair& seriesPair : *study)
+				{
+					const OctData::Series* series = seriesPair.second;
+					bpt::ptree& seriesNode = PTreeHelper::getNodeWithId(studyNode, "Series", series->getInternalId());
+
+					std::vector<BScanLayerSegmentation::BScanSegData> lines(series->bscanCount());
+					for(std::size_t bscanNr = 0; bscanNr < lines.size(); ++bscanNr)
+					{
+						const OctData::BScan* bscan = series->getBScan(bscanNr);
+						if(bscan)
+							BScanLayerSegmentation::resetSegData(lines[bscanNr], *bscan);
+					}
+
+					boost::optional<bpt::ptree&> layerSegNode = seriesNode.get_child_optional(layerSegmentationId);
+					if(layerSegNode && !BScanLayerSegPTree::parsePTree(*layerSegNode, lines))
+					{
+						error = "invalid layer segmentation";
+						return false;
+					}
+
+					bool result = false;
+					switch(config.operation)
+					{
+						case BatchProcessing::Operation::ExportLayerSeg:
+						{
+							const std::string outFilename = seriesFilename(outputBase, seriesNr, numSeries, ".segmentation.bin").toStdString();
+							result = LayerSegmentationIO::saveSegmentation2Bin(lines, BScanLayerSegmentation::getMaxBscanWidth(series), outFilename);
+							if(!result)
+								error = QString("could not write %1").arg(QString::fromStdString(outFilename));
+							break;
+						}
+						case BatchProcessing::Operation::Thicknessmap:
+						{
+							const std::string outFilename = seriesFilename(outputBase, seriesNr, numSeries, ".thicknessmap.png").toStdString();
+							result = createThicknessmap(config, *series, lines, outFilename, error);
+							break;
+						}
+						case BatchProcessing::Operation::Convert:
+						case BatchProcessing::Operation::Unknown:
+							error = "unhandled operation";
+							break;
+					}
+
+					if(!result)
+						return false;
+					++seriesNr;
+				}
+			}
+		}
+		return true;
+	}
+
+
+	class BatchJob : public QRunnable
+	{
+		const BatchConfig& config;
+		JobResult& result;
+		const int jobNr;
+		const int numJobs;
+
+		static QMutex outputMutex;
+
+		void printResult() const
+		{
+			QMutexLocker locker(&outputMutex);
+			std::cout << '[' << std::setw(5) << jobNr << '/' << numJobs << "] "
+			          << (result.success ? "ok    " : "failed")
+			          << std::setw(9) << result.time << " ms  "
+			          << result.filename.toStdString();
+			if(!result.success)
+				std::cout << ": " << result.error.toStdString();
+			std::cout << std::endl;
+		}
+
+	public:
+		BatchJob(const BatchConfig& config, JobResult& result, int jobNr, int numJobs)
+		: config (config )
+		, result (result )
+		, jobNr  (jobNr  )
+		, numJobs(numJobs)
+		{}
+
+		void run() override
+		{
+			QElapsedTimer timer;
+			timer.start();
+
+			try
+			{
+				if(config.operation == BatchProcessing::Operation::Convert)
+					result.success = convertMarkers(config, result.filename, result.outputBase, result.error);
+				else
+					result.success = processOctFile(config, result.filename, result.outputBase, result.error);
+			}
+			catch(boost::exception& e)
+			{
+				result.error = QString::fromStdString(boost::diagnostic_information(e));
+			}
+			catch(std::exception& e)
+			{
+				result.error = e.what();
+			}
+			catch(const char* str)
+			{
+				result.error = str;
+			}
+			catch(...)
+			{
+				result.error = "unknown error";
+			}
+
+			result.time = timer.elapsed();
+			printResult();
+		}
+	};
+
+	QMutex BatchJob::outputMutex;
+}
+
+
+bool BatchProcessing::isBatchCall(int argc, char** argv)
+{
+	for(int i = 1; i < argc; ++i)
+	{
+		if(std::strcmp(argv[i], "--batch") == 0 || std::strncmp(argv[i], "--batch=", 8) == 0)
+			return true;
+	}
+	return false;
+}
+
+
+int BatchProcessing::exec(int argc, char** argv)
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("OCT-Marker");
+	QCoreApplication::setApplicationVersion(BuildConstants::gitSha1);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("OCT-Marker batch mode: process many files without a gui.\n\n"
+	                                 "operations:\n"
+	                                 "  convert          write the markers of marker or oct files in another format\n"
+	                                 "  export-layerseg  write the layer segmentation of oct files as <file>.segmentation.bin\n"
+	                                 "  thicknessmap     write the thickness map of oct files as <file>.thicknessmap.png");
+	parser.addOptions({
+		{"batch"               , QCoreApplication::translate("main", "run batch operation"), QCoreApplication::translate("main", "operation")},
+		{{"f", "format"}       , QCoreApplication::translate("main", "marker format for convert (json, xml, info, bin)"), QCoreApplication::translate("main", "format"), "json"},
+		{{"o", "output-dir"}   , QCoreApplication::translate("main", "write the results to this directory"), QCoreApplication::translate("main", "dir")},
+		{{"l", "file-list"}    , QCoreApplication::translate("main", "read the input files from this file (one per line)"), QCoreApplication::translate("main", "file")},
+		{{"j", "jobs"}         , QCoreApplication::translate("main", "number of parallel jobs"), QCoreApplication::translate("main", "n"), QString::number(QThread::idealThreadCount())},
+		{{"r", "recursive"}    , QCoreApplication::translate("main", "search input directories recursive")},
+		{"thicknessmap-template", QCoreApplication::translate("main", "thickness map template number (0 = full retina)"), QCoreApplication::translate("main", "n"), "0"},
+		{{"i", "ini-file"}     , QCoreApplication::translate("main", "use config from ini file"), QCoreApplication::translate("main", "ini file")},
+	});
+	parser.addHelpOption();
+	parser.addVersionOption();
+	parser.addPositionalArgument("files", QCoreApplication::translate("main", "files or directories to process"), "[files...]");
+
+	parser.process(app);
+
+	BatchConfig config;
+	config.operation = string2Operation(parser.value("batch"));
+	if(config.operation == Operation::Unknown)
+	{
+		std::cerr << "Error: unknown batch operation \"" << parser.value("batch").toStdString() << "\"\n";
+		return 2;
+	}
+
+	config.format = string2Format(parser.value("format"));
+	if(config.format == OctMarkerFileformat::Unknown)
+	{
+		std::cerr << "Error: unknown marker format \"" << parser.value("format").toStdString() << "\"\n";
+		return 2;
+	}
+
+	bool ok = true;
+	int jobs = parser.value("jobs").toInt(&ok);
+	if(!ok || jobs < 1)
+	{
+		std::cerr << "Error: invalid number of jobs\n";
+		return 2;
+	}
+
+	config.outputDir = parser.value("output-dir");
+	if(!config.outputDir.isEmpty() && !QDir().mkpath(config.outputDir))
+	{
+		std::cerr << "Error: can't create output directory " << config.outputDir.toStdString() << '\n';
+		return 2;
+	}
+
+	ProgramOptions::setSaveOptions(false);
+	if(parser.isSet("ini-file"))
+		ProgramOptions::setIniFile(parser.value("ini-file"));
+	ProgramOptions::readAllOptions();
+
+	// the templates can depend on the options of the ini file
+	int thicknessmapTemplate = parser.value("thicknessmap-template").toInt(&ok);
+	if(!ok || thicknessmapTemplate < 0
+	|| static_cast<std::size_t>(thicknessmapTemplate) >= ThicknessmapTemplates::getInstance().getConfigurations().size())
+	{
+		std::cerr << "Error: invalid thickness map template\n";
+		return 2;
+	}
+	config.thicknessmapTemplate = static_cast<std::size_t>(thicknessmapTemplate);
+
+
+	std::vector<InputFile> files;
+	if(parser.isSet("file-list") && !readFileList(files, parser.value("file-list")))
+	{
+		std::cerr << "Error: can't read file list " << parser.value("file-list").toStdString() << '\n';
+		return 2;
+	}
+
+	const bool recursive = parser.isSet("recursive");
+	for(const QString& input : parser.positionalArguments())
+		addInput(files, input, config.operation, recursive);
+
+	if(files.empty())
+	{
+		std::cerr << "Error: no input files\n";
+		return 2;
+	}
+
+	const int numJobs = static_cast<int>(files.size());
+	std::vector<JobResult> results(files.size());
+
+	std::map<QString, QString> outputFiles;
+	for(std::size_t i = 0; i < files.size(); ++i)
+	{
+		JobResult& result = results[i];
+		result.filename   = files[i].filename;
+		result.outputBase = outputBaseFilename(config, files[i]);
+
+		std::pair<std::map<QString, QString>::iterator, bool> inserted = outputFiles.emplace(result.outputBase, result.filename);
+		if(!inserted.second)
+		{
+			std::cerr << "Error: " << inserted.first->second.toStdString() << " and " << result.filename.toStdString() << " have the same output file\n";
+			return 2;
+		}
+
+		const QString outputDir = QFileInfo(result.outputBase).path();
+		if(!config.outputDir.isEmpty() && !QDir().mkpath(outputDir))
+		{
+			std::cerr << "Error: can't create output directory " << outputDir.toStdString() << '\n';
+			return 2;
+		}
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+
+	QThreadPool pool;
+	pool.setMaxThreadCount(jobs);
+	for(int i = 0; i < numJobs; ++i)
+	{
+		pool.start(new BatchJob(config, results[static_cast<std::size_t>(i)], i+1, numJobs));
+	}
+	pool.waitForDone();
+
+
+	int failed = 0;
+	for(const JobResult& result : results)
+	{
+		if(!result.success)
+			++failed;
+	}
+
+	std::cout << "processed " << numJobs << " files in " << timer.elapsed() << " ms, " << failed << " failed" << std::endl;
+	if(failed > 0)
+	{
+		std::cerr << "failed files:\n";
+		for(const JobResult& result : results)
+			if(!result.success)
+				std::cerr << "  " << result.filename.toStdString() << ": " << result.error.toStdString() << '\n';
+		return 1;
+	}
+	return 0;
+}
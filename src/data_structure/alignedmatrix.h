@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include<cstdint>
+#include<cassert>
+#include<memory>
+#include<algorithm>
+#include<type_traits>
+
+// matrix with 64 byte aligned rows, for plain value types
+template<typename T>
+class AlignedMatrix
+{
+public:
+	constexpr static const std::size_t alignment = 64;
+private:
+	static_assert(std::is_pod<T>::value            , "AlignedMatrix only supports plain value types");
+	static_assert(alignment % sizeof(T) == 0       , "AlignedMatrix element size must divide the alignment");
+
+	std::size_t sizeX  = 0;
+	std::size_t sizeY  = 0;
+	std::size_t stride = 0;
+	std::unique_ptr<uint8_t[]> buffer;
+	T* field = nullptr;
+public:
+	typedef T value_type;
+
+	AlignedMatrix() = default;
+	AlignedMatrix(std::size_t x, std::size_t y, const T& value = T())
+	{
+		resize(x, y, value);
+	}
+
+	AlignedMatrix(AlignedMatrix&& other)                 = default;
+	AlignedMatrix& operator=(AlignedMatrix&& other)      = default;
+	AlignedMatrix(const AlignedMatrix& other)            = delete;
+	AlignedMatrix& operator=(const AlignedMatrix& other) = delete;
+
+
+	T* scanLine(std::size_t y)                                      { assert(y < sizeY); return field+stride*y; }
+	const T* scanLine(std::size_t y)                          const { assert(y < sizeY); return field+stride*y; }
+
+	T& operator()(std::size_t x, std::size_t y)                     { assert(y < sizeY); assert(x < sizeX); return field[x + y*stride]; }
+	const T& operator()(std::size_t x, std::size_t y)         const { assert(y < sizeY); assert(x < sizeX); return field[x + y*stride]; }
+	std::size_t getSizeX()                                    const { return sizeX; }
+	std::size_t getSizeY()                                    const { return sizeY; }
+	std::size_t getStride()                                   const { return stride; }
+	std::size_t memorySize()                                  const { return stride*sizeY*sizeof(T); }
+
+	static std::size_t calcStride(std::size_t x)                    { return (x*sizeof(T) + alignment - 1)/alignment*alignment/sizeof(T); }
+	static std::size_t calcMemorySize(std::size_t x, std::size_t y) { return calcStride(x)*y*sizeof(T); }
+
+	void resize(std::size_t x, std::size_t y, const T& value = T())
+	{
+		stride = calcStride(x);
+		buffer.reset(new uint8_t[stride*y*sizeof(T) + alignment]);
+
+		const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(buffer.get());
+		field = reinterpret_cast<T*>((address + alignment - 1)/alignment*alignment);
+		std::fill(field, field + stride*y, value);
+
+		sizeX = x;
+		sizeY = y;
+	}
+
+	// use calcMemorySize(x, y) bytes of external 64 byte aligned memory, the memory is not copied and has to outlive the matrix
+	// a read only memory (e.g. a mapped file) must only be accessed by the const functions
+	void setView(const uint8_t* data, std::size_t x, std::size_t y)
+	{
+		assert(reinterpret_cast<std::uintptr_t>(data) % alignment == 0);
+
+		buffer.reset();
+		field  = reinterpret_cast<T*>(const_cast<uint8_t*>(data));
+		stride = calcStride(x);
+		sizeX  = x;
+		sizeY  = y;
+	}
+};
@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include<cstddef>
+
 
 class MarkerCommand
 {
@@ -29,6 +31,16 @@ public:
 	virtual void apply() = 0;
 	int getBScan() const { return bscan; }
 
+	// approximated heap and object size, used for the undo memory budget
+	virtual std::size_t getMemorySize() const                       { return sizeof(MarkerCommand); }
+	// increasing with the creation order over all marker modules
+	std::size_t getCreationNumber() const                           { return creationNumber; }
+
 protected:
 	int bscan = -1;
+
+private:
+	static std::size_t nextCreationNumber()                         { static std::size_t counter = 0; return ++counter; }
+
+	const std::size_t creationNumber = nextCreationNumber();
 };
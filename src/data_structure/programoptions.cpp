@@ -48,6 +48,13 @@ OptionBool   ProgramOptions::saveOctBinFlat     (false, "saveOctBinFlat"     , "
 
 OptionBool   ProgramOptions::holdOCTRawData     (false, "holdOCTRawData"     , "ProgramOptions");
 OptionBool   ProgramOptions::readBScans         (true , "readBScans"         , "ProgramOptions");
+OptionBool   ProgramOptions::progressiveLoading (false, "progressiveLoading" , "ProgramOptions");
+OptionInt    ProgramOptions::prefetchMaxMemory  (1024 , "prefetchMaxMemory"  , "ProgramOptions", 0, 65536, 256); // MB, 0 disables the prefetch
+OptionBool   ProgramOptions::prefetchPreviousFile(false, "prefetchPreviousFile", "ProgramOptions");
+OptionInt    ProgramOptions::octCacheMaxMemory  (2048 , "octCacheMaxMemory"  , "ProgramOptions", 0, 65536, 256); // MB, 0 disables the cache
+OptionInt    ProgramOptions::undoMaxMemory      (256  , "undoMaxMemory"      , "ProgramOptions", 0, 65536, 64 ); // MB, 0 disables the limit
+OptionInt    ProgramOptions::distanceMapCacheMaxSize  (512, "distanceMapCacheMaxSize"  , "ProgramOptions", 0, 65536, 64); // MB, 0 disables the disk cache
+OptionString ProgramOptions::distanceMapCacheDirectory("" , "distanceMapCacheDirectory", "ProgramOptions"); // empty: cache location of the user
 
 OptionInt    ProgramOptions::e2eGrayTransform   (1    , "e2eGrayTransform"   , "ProgramOptions");
 
@@ -66,6 +73,10 @@ OptionString ProgramOptions::octDirectory      (".", "octDirectory"      , "Prog
 OptionString ProgramOptions::loadOctdataAtStart("" , "loadOctDataAtStart", "ProgramOptions");
 
 OptionBool   ProgramOptions::autoSaveOctMarkers         (true, "autoSaveOctMarkers", "ProgramOptions");
+OptionInt    ProgramOptions::autoSaveMarkersInterval    (5   , "autoSaveMarkersInterval", "ProgramOptions", 0, 120, 1); // minutes, 0 saves only on file change
+OptionBool   ProgramOptions::autoSaveMarkersJournal     (true, "autoSaveMarkersJournal", "ProgramOptions");
+OptionInt    ProgramOptions::markerJournalMaxSize       (16  , "markerJournalMaxSize", "ProgramOptions", 0, 1024, 4); // MB, a larger journal is written into the marker file
+OptionBool   ProgramOptions::compressOctMarkers         (false, "compressOctMarkers", "ProgramOptions");
 OptionInt    ProgramOptions::defaultFileformatOctMarkers(static_cast<int>(OctMarkerFileformat::INFO), "defaultFileformatOctMarkers", "ProgramOptions");
 
 OptionInt    ProgramOptions::bscanMarkerToolId(-1, "bscanMarkerToolId", "ProgramOptions");
@@ -86,10 +97,12 @@ OptionInt    ProgramOptions::layerSegSplinePointSize     (8         , "SplinePoi
 OptionBool   ProgramOptions::layerSegThicknessmapBlend   (true      , "ThicknessmapBlend", "LayerSeg");
 OptionBool   ProgramOptions::layerSegSloMapsAutoUpdate   (true      , "SloMapsAutoUpdate", "LayerSeg");
 OptionBool   ProgramOptions::layerSegHighlightSegLine    (true      , "HighlightSegLine", "LayerSeg");
+OptionInt    ProgramOptions::layerSegLineEncoding        (0         , "LineEncoding"     , "LayerSeg", 0, 2);
 
 
 OptionInt    ProgramOptions::freeFormedSegmetationLineThickness(1      , "bscanSegmetationLineThickness", "FreeFormedSegmentation", 1, 10);
 OptionBool   ProgramOptions::freeFormedSegmetationShowArea     (true   , "showArea"                     , "FreeFormedSegmentation");
+OptionBool   ProgramOptions::freeFormedSegmetationBinaryStorage(false  , "binaryStorage"                , "FreeFormedSegmentation");
 
 
 OptionBool   ProgramOptions::intervallMarkSloMapAuteGenerate(false    , "SloMapAuteGenerate", "IntervallMark");
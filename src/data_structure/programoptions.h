@@ -68,6 +68,13 @@ public:
 
 	static OptionBool   holdOCTRawData;
 	static OptionBool   readBScans;
+	static OptionBool   progressiveLoading;
+	static OptionInt    prefetchMaxMemory;
+	static OptionBool   prefetchPreviousFile;
+	static OptionInt    octCacheMaxMemory;
+	static OptionInt    undoMaxMemory;
+	static OptionInt    distanceMapCacheMaxSize;
+	static OptionString distanceMapCacheDirectory;
 
 	static OptionInt    e2eGrayTransform;
 
@@ -83,6 +90,10 @@ public:
 	static OptionString loadOctdataAtStart;
 	
 	static OptionBool   autoSaveOctMarkers;
+	static OptionInt    autoSaveMarkersInterval;
+	static OptionBool   autoSaveMarkersJournal;
+	static OptionInt    markerJournalMaxSize;
+	static OptionBool   compressOctMarkers;
 	static OptionInt    defaultFileformatOctMarkers;
 
 	static OptionInt    bscanMarkerToolId;
@@ -103,10 +114,12 @@ public:
 	static OptionBool   layerSegThicknessmapBlend;
 	static OptionBool   layerSegSloMapsAutoUpdate;
 	static OptionBool   layerSegHighlightSegLine;
+	static OptionInt    layerSegLineEncoding;
 
 
 	static OptionInt    freeFormedSegmetationLineThickness;
 	static OptionBool   freeFormedSegmetationShowArea;
+	static OptionBool   freeFormedSegmetationBinaryStorage;
 
 	static OptionBool   intervallMarkSloMapAuteGenerate;
 	
@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "seglinecodec.h"
+
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+
+#include <boost/spirit/include/qi.hpp>
+namespace qi = boost::spirit::qi;
+
+#include <helper/base64.h>
+
+
+namespace
+{
+	namespace LineCodec
+	{
+		const char*  float32Prefix    = "f32:";
+		const char*  fixedPointPrefix = "q100:";
+		const double fixedPointScale  = 100.;
+		const double fixedPointMax    = 4503599627370496.; // 2^52, the sum of the differences can't overflow
+	}
+
+	bool hasPrefix(const std::string& str, const char* prefix)
+	{
+		const std::size_t length = std::strlen(prefix);
+		return str.size() >= length && str.compare(0, length, prefix) == 0;
+	}
+
+	void putHeader(const char* prefix, std::size_t count, std::string& out)
+	{
+		out = prefix;
+		out += std::to_string(count);
+		out += ':';
+	}
+
+	// reads "<prefix><count>:", pos is the begin of the base64 data
+	bool readHeader(const std::string& str, const char* prefix, std::size_t& count, std::size_t& pos)
+	{
+		pos   = std::strlen(prefix);
+		count = 0;
+		const std::size_t digitsBegin = pos;
+		while(pos < str.size() && str[pos] >= '0' && str[pos] <= '9')
+		{
+			if(pos - digitsBegin >= 9) // more values than a line can have
+				return false;
+			count = count*10 + static_cast<std::size_t>(str[pos] - '0');
+			++pos;
+		}
+		if(pos == digitsBegin || pos >= str.size() || str[pos] != ':')
+			return false;
+		++pos;
+		return true;
+	}
+
+	bool encodeFloat32(const std::vector<double>& vec, std::string& out)
+	{
+		std::string bytes(vec.size()*4, '\0');
+		for(std::size_t i = 0; i < vec.size(); ++i)
+		{
+			if(std::isfinite(vec[i]) && std::abs(vec[i]) > std::numeric_limits<float>::max())
+				return false; // would be stored as infinity
+
+			const float value = static_cast<float>(vec[i]);
+			std::uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			for(std::size_t b = 0; b < 4; ++b)
+				bytes[i*4 + b] = static_cast<char>(bits >> (8*b));
+		}
+
+		putHeader(LineCodec::float32Prefix, vec.size(), out);
+		Base64::encode(bytes.data(), bytes.size(), out);
+		return true;
+	}
+
+	bool decodeFloat32(const std::string& str, std::vector<double>& vec)
+	{
+		std::size_t count;
+		std::size_t pos;
+		if(!readHeader(str, LineCodec::float32Prefix, count, pos))
+			return false;
+
+		std::string bytes;
+		if(!Base64::decode(str.data() + pos, str.size() - pos, bytes) || bytes.size() != count*4)
+			return false;
+
+		vec.resize(count);
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			std::uint32_t bits = 0;
+			for(std::size_t b = 0; b < 4; ++b)
+				bits |= static_cast<std::uint32_t>(static_cast<std::uint8_t>(bytes[i*4 + b])) << (8*b);
+			float value;
+			std::memcpy(&value, &bits, sizeof(value));
+			vec[i] = value;
+		}
+		return true;
+	}
+
+	bool encodeFixedPoint(const std::vector<double>& vec, std::string& out)
+	{
+		std::string bytes;
+		bytes.reserve(vec.size()*2);
+
+		std::int64_t last = 0;
+		for(double value : vec)
+		{
+			std::uint64_t code = 0; // NaN
+			if(!std::isnan(value))
+			{
+				const double scaled = value*LineCodec::fixedPointScale;
+				if(!(std::abs(scaled) <= LineCodec::fixedPointMax))
+					return false; // infinity or out of range
+
+				const std::int64_t q     = std::llround(scaled);
+				const std::int64_t delta = q - last;
+				code = ((static_cast<std::uint64_t>(delta) << 1) ^ static_cast<std::uint64_t>(delta >> 63)) + 1;
+				last = q;
+			}
+
+			while(code >= 0x80)
+			{
+				bytes.push_back(static_cast<char>(code | 0x80));
+				code >>= 7;
+			}
+			bytes.push_back(static_cast<char>(code));
+		}
+
+		putHeader(LineCodec::fixedPointPrefix, vec.size(), out);
+		Base64::encode(bytes.data(), bytes.size(), out);
+		return true;
+	}
+
+	bool decodeFixedPoint(const std::string& str, std::vector<double>& vec)
+	{
+		std::size_t count;
+		std::size_t pos;
+		if(!readHeader(str, LineCodec::fixedPointPrefix, count, pos))
+			return false;
+
+		std::string bytes;
+		if(!Base64::decode(str.data() + pos, str.size() - pos, bytes) || bytes.size() < count)
+			return false;
+
+		const std::int64_t maxValue = static_cast<std::int64_t>(LineCodec::fixedPointMax);
+
+		vec.clear();
+		vec.reserve(count);
+		std::int64_t last = 0;
+		pos = 0;
+		while(pos < bytes.size())
+		{
+			std::uint64_t code = 0;
+			bool complete = false;
+			for(int shift = 0; pos < bytes.size() && shift < 64; shift += 7)
+			{
+				const std::uint8_t b = static_cast<std::uint8_t>(bytes[pos++]);
+				code |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+				if((b & 0x80) == 0)
+				{
+					complete = true;
+					break;
+				}
+			}
+			if(!complete || vec.size() == count)
+				return false; // truncated varint or trailing data
+
+			if(code == 0)
+			{
+				vec.push_back(std::numeric_limits<double>::quiet_NaN());
+				continue;
+			}
+
+			--code;
+			const std::int64_t delta = static_cast<std::int64_t>(code >> 1) ^ -static_cast<std::int64_t>(code & 1);
+			if(delta < -2*maxValue || delta > 2*maxValue)
+				return false;
+			last += delta;
+			if(last < -maxValue || last > maxValue)
+				return false;
+
+			vec.push_back(static_cast<double>(last)/LineCodec::fixedPointScale);
+		}
+		return vec.size() == count;
+	}
+
+	bool decodeText(const std::string& str, std::vector<double>& vec)
+	{
+		std::string::const_iterator f(str.begin()), l(str.end());
+		return qi::phrase_parse(f, l, *qi::double_, qi::space, vec) && f == l;
+	}
+}
+
+
+namespace SegLineCodec
+{
+	bool encode(const std::vector<double>& line, Encoding encoding, std::string& out)
+	{
+		switch(encoding)
+		{
+			case Encoding::Float32:
+				return encodeFloat32(line, out);
+			case Encoding::FixedPoint:
+				return encodeFixedPoint(line, out);
+			case Encoding::Text:
+				break;
+		}
+
+		std::stringstream sstream;
+		for(double val : line)
+			sstream << val << ' ';
+
+		out = sstream.str();
+		return true;
+	}
+
+	bool decode(const std::string& str, std::vector<double>& line)
+	{
+		line.clear();
+
+		bool result;
+		if(hasPrefix(str, LineCodec::float32Prefix))
+			result = decodeFloat32(str, line);
+		else if(hasPrefix(str, LineCodec::fixedPointPrefix))
+			result = decodeFixedPoint(str, line);
+		else
+			result = decodeText(str, line);
+
+		if(!result)
+			line.clear();
+		return result;
+	}
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * encoding of a segmentation line in the marker tree
+ * Text: space separated numbers, readable by all versions
+ * Float32: "f32:<count>:" + base64 of little endian float32 values
+ * FixedPoint: "q100:<count>:" + base64 of zigzag varint differences in 1/100 px (0 for NaN), lossy
+ * the prefix makes every value self-describing, decode handles all forms
+ * encoded lines are stored under the node "EncodedLines" instead of "Lines",
+ * older versions ignore that node (the segmentation is not visible there and lost by a save)
+ */
+namespace SegLineCodec
+{
+	enum class Encoding { Text = 0, Float32 = 1, FixedPoint = 2 };
+
+	const int encodedVersion = 2;                                   // module "Version" for encoded lines
+
+	const char* const textLinesNode    = "Lines";
+	const char* const encodedLinesNode = "EncodedLines";
+
+	inline const char* linesNodeName(Encoding encoding)             { return encoding == Encoding::Text ? textLinesNode : encodedLinesNode; }
+
+	// false if the encoding can't hold the values (Float32: finite values beyond the float range, FixedPoint: infinity or |value| > 2^52/100)
+	bool encode(const std::vector<double>& line, Encoding encoding, std::string& out);
+	// false (and an empty line) for invalid base64, a wrong value count, trailing data or values out of range
+	bool decode(const std::string& str, std::vector<double>& line);
+}
@@ -35,6 +35,76 @@ void SimpleCvMatCompress::writeToMat(cv::Mat& mat) const
 }
 
 
+bool SimpleCvMatCompress::findChangedRows(const cv::Mat& mat, int& firstRow, int& endRow) const
+{
+	if(!mat.isContinuous())
+		return false;
+	return SimpleMatCompress::findChangedRows(mat.ptr<uint8_t>(), mat.rows, mat.cols, firstRow, endRow);
+}
+
+bool SimpleCvMatCompress::patchRows(const cv::Mat& mat, int firstRow, int endRow)
+{
+	if(mat.rows != getRows() || mat.cols != getCols() || firstRow < 0 || endRow > mat.rows)
+		return false;
+	return SimpleMatCompress::patchRect(mat.ptr<uint8_t>(firstRow), static_cast<int>(mat.step[0]), 0, firstRow, mat.cols, endRow - firstRow);
+}
+
+bool SimpleCvMatCompress::createXorDiff(const cv::Mat& mat, int& x, int& y, SimpleCvMatCompress& diff) const
+{
+	int firstRow;
+	int endRow;
+	if(!findChangedRows(mat, firstRow, endRow))
+		return false;
+
+	x = 0;
+	y = firstRow;
+	if(firstRow == endRow)
+	{
+		diff = SimpleCvMatCompress();
+		return true;
+	}
+
+	const int height = endRow - firstRow;
+	cv::Mat oldRows(height, mat.cols, cv::DataType<uint8_t>::type);
+	SimpleMatCompress::writeRectToMat(oldRows.ptr<uint8_t>(), static_cast<int>(oldRows.step[0]), 0, firstRow, mat.cols, height);
+
+	cv::Mat xorRows;
+	cv::bitwise_xor(oldRows, mat.rowRange(firstRow, endRow), xorRows);
+
+	cv::Mat colMax;
+	cv::reduce(xorRows, colMax, 0, CV_REDUCE_MAX);
+	const uint8_t* colPtr = colMax.ptr<uint8_t>();
+
+	int firstCol = 0;
+	while(colPtr[firstCol] == 0)
+		++firstCol;
+	int endCol = mat.cols;
+	while(colPtr[endCol - 1] == 0)
+		--endCol;
+
+	x = firstCol;
+	diff.readFromMat(xorRows.colRange(firstCol, endCol).clone());
+	return true;
+}
+
+bool SimpleCvMatCompress::applyXorDiff(cv::Mat& mat, int x, int y, const SimpleCvMatCompress& diff)
+{
+	const cv::Rect rect(x, y, diff.getCols(), diff.getRows());
+	if(mat.rows != getRows() || mat.cols != getCols() || (rect & cv::Rect(0, 0, mat.cols, mat.rows)) != rect)
+		return false;
+
+	cv::Mat region(rect.height, rect.width, cv::DataType<uint8_t>::type);
+	SimpleMatCompress::writeRectToMat(region.ptr<uint8_t>(), static_cast<int>(region.step[0]), x, y, rect.width, rect.height);
+
+	cv::Mat diffMat;
+	diff.writeToMat(diffMat);
+	cv::bitwise_xor(region, diffMat, region);
+
+	SimpleMatCompress::patchRect(region.ptr<uint8_t>(), static_cast<int>(region.step[0]), x, y, rect.width, rect.height);
+	region.copyTo(mat(rect));
+	return true;
+}
+
 bool SimpleCvMatCompress::operator==(const cv::Mat& mat) const
 {
 	return SimpleMatCompress::isEqual(mat.ptr<uint8_t>(), mat.rows, mat.cols);
@@ -34,6 +34,14 @@ public:
 
 	void writeToMat(cv::Mat& mat) const;
 
+	bool findChangedRows(const cv::Mat& mat, int& firstRow, int& endRow) const;
+	bool patchRows(const cv::Mat& mat, int firstRow, int endRow);
+
+	// diff: xor of this and mat in the bounding rect (x, y, diff size) of the changes, empty if equal; false if the size differs
+	bool createXorDiff(const cv::Mat& mat, int& x, int& y, SimpleCvMatCompress& diff) const;
+	// applies the diff on this and on the same rect of mat
+	bool applyXorDiff(cv::Mat& mat, int x, int y, const SimpleCvMatCompress& diff);
+
 	bool operator==(const cv::Mat& mat) const;
 	bool operator!=(const cv::Mat& mat) const                       { return !(this->operator==(mat)); }
 
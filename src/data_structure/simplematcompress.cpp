@@ -18,6 +18,99 @@
 
 #include "simplematcompress.h"
 
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SIMPLEMATCOMPRESS_SSE2
+	#include <emmintrin.h>
+	#ifdef __AVX2__
+		#define SIMPLEMATCOMPRESS_AVX2
+		#include <immintrin.h>
+	#endif
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#endif
+#endif
+
+
+namespace
+{
+#ifdef SIMPLEMATCOMPRESS_SSE2
+	inline int firstSetBit(unsigned int mask)
+	{
+	#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return static_cast<int>(index);
+	#else
+		return __builtin_ctz(mask);
+	#endif
+	}
+#endif
+
+	const uint8_t binaryVersion = 1;
+
+	void writeVarUInt(std::string& out, uint32_t value)
+	{
+		while(value >= 0x80)
+		{
+			out.push_back(static_cast<char>(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back(static_cast<char>(value));
+	}
+
+	bool readVarUInt(const uint8_t*& ptr, const uint8_t* end, uint32_t& value)
+	{
+		value = 0;
+		for(int shift = 0; shift < 35; shift += 7)
+		{
+			if(ptr == end)
+				return false;
+			const uint8_t b = *ptr++;
+			value |= static_cast<uint32_t>(b & 0x7f) << shift;
+			if((b & 0x80) == 0)
+				return true;
+		}
+		return false;
+	}
+
+	// returns the first position in [begin, end) with a value unequal to value, or end
+	const uint8_t* findRunEnd(const uint8_t* begin, const uint8_t* end, uint8_t value)
+	{
+		const uint8_t* ptr = begin;
+
+#ifdef SIMPLEMATCOMPRESS_AVX2
+		const __m256i value32 = _mm256_set1_epi8(static_cast<char>(value));
+		while(end - ptr >= 32)
+		{
+			const __m256i    block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+			const unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, value32)));
+			if(mask != 0xFFFFFFFFu)
+				return ptr + firstSetBit(~mask);
+			ptr += 32;
+		}
+#endif
+
+#ifdef SIMPLEMATCOMPRESS_SSE2
+		const __m128i value16 = _mm_set1_epi8(static_cast<char>(value));
+		while(end - ptr >= 16)
+		{
+			const __m128i    block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+			const unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, value16)));
+			if(mask != 0xFFFFu)
+				return ptr + firstSetBit(~mask & 0xFFFFu);
+			ptr += 16;
+		}
+#endif
+
+		while(ptr < end && *ptr == value)
+			++ptr;
+		return ptr;
+	}
+}
 
 
 SimpleMatCompress::SimpleMatCompress(int rows, int cols, uint8_t initValue)
@@ -25,6 +118,7 @@ SimpleMatCompress::SimpleMatCompress(int rows, int cols, uint8_t initValue)
 , cols(cols)
 {
 	addSegment(rows*cols, initValue);
+	buildRowIndex();
 }
 
 bool SimpleMatCompress::readFromMat(const uint8_t* mat, int rows, int cols)
@@ -32,35 +126,28 @@ bool SimpleMatCompress::readFromMat(const uint8_t* mat, int rows, int cols)
 	this->rows = rows;
 	this->cols = cols;
 	segmentsChange.clear();
+	rowIndex.clear();
 
 	sumSegments = 0;
 
 	if(mat == nullptr)
 		return false;
 
-	int     actSegmentLengt = 0;
-	uint8_t actSegmentValue = *mat;
-
 	const uint8_t* dataPtr = mat;
-	for(int row = 0; row < rows; ++row)
+	const uint8_t* dataEnd = mat + rows*cols;
+	if(dataPtr == dataEnd)
+		addSegment(0, *mat);
+
+	while(dataPtr < dataEnd)
 	{
-		for(int col = 0; col < cols; ++col)
-		{
-			if(actSegmentValue != *dataPtr)
-			{
-				addSegment(actSegmentLengt, actSegmentValue);
-				actSegmentValue = *dataPtr;
-				actSegmentLengt = 1;
-			}
-			else
-				++actSegmentLengt;
-
-			++dataPtr;
-		}
+		const uint8_t  actSegmentValue = *dataPtr;
+		const uint8_t* segmentEnd      = findRunEnd(dataPtr + 1, dataEnd, actSegmentValue);
+		addSegment(static_cast<int>(segmentEnd - dataPtr), actSegmentValue);
+		dataPtr = segmentEnd;
 	}
-	addSegment(actSegmentLengt, actSegmentValue);
 
 	assert(sumSegments == rows*cols);
+	buildRowIndex();
 	return true;
 }
 
@@ -71,9 +158,8 @@ bool SimpleMatCompress::writeToMat(uint8_t* mat, int rows, int cols) const
 
 	for(const MatSegment& segment : segmentsChange)
 	{
-		uint8_t segmentValue = segment.value;
-		for(int i=0; i<segment.length; ++i, ++mat)
-			*mat = segmentValue;
+		std::memset(mat, segment.value, static_cast<std::size_t>(segment.length));
+		mat += segment.length;
 	}
 	return true;
 }
@@ -84,6 +170,13 @@ inline void SimpleMatCompress::addSegment(int length, uint8_t value)
 	sumSegments += length;
 }
 
+std::size_t SimpleMatCompress::getMemorySize() const
+{
+	return sizeof(SimpleMatCompress)
+	     + segmentsChange.capacity()*sizeof(MatSegment)
+	     + rowIndex      .capacity()*sizeof(RowStart);
+}
+
 bool SimpleMatCompress::isEmpty(uint8_t defaultValue) const
 {
 	if(segmentsChange.empty())
@@ -100,10 +193,10 @@ bool SimpleMatCompress::isEqual(const uint8_t* mat, int rows, int cols) const
 
 	for(const MatSegment& segment : segmentsChange)
 	{
-		uint8_t segmentValue = segment.value;
-		for(int i=0; i<segment.length; ++i, ++mat)
-			if(*mat != segmentValue)
-				return false;
+		const uint8_t* segmentEnd = mat + segment.length;
+		if(findRunEnd(mat, segmentEnd, segment.value) != segmentEnd)
+			return false;
+		mat = segmentEnd;
 	}
 	return true;
 }
@@ -115,3 +208,250 @@ bool SimpleMatCompress::operator==(const SimpleMatCompress& other) const
 	    && segmentsChange == other.segmentsChange;
 }
 
+
+void SimpleMatCompress::writeBinary(std::string& out) const
+{
+	out.reserve(out.size() + 16 + segmentsChange.size()*3);
+
+	out.push_back(static_cast<char>(binaryVersion));
+	writeVarUInt(out, static_cast<uint32_t>(rows));
+	writeVarUInt(out, static_cast<uint32_t>(cols));
+	writeVarUInt(out, static_cast<uint32_t>(segmentsChange.size()));
+
+	for(const MatSegment& segment : segmentsChange)
+	{
+		writeVarUInt(out, static_cast<uint32_t>(segment.length));
+		out.push_back(static_cast<char>(segment.value));
+	}
+}
+
+bool SimpleMatCompress::readBinary(const char* data, std::size_t size)
+{
+	const uint8_t* ptr = reinterpret_cast<const uint8_t*>(data);
+	const uint8_t* end = ptr + size;
+
+	if(size == 0 || *ptr++ != binaryVersion)
+		return false;
+
+	uint32_t binRows;
+	uint32_t binCols;
+	uint32_t numSegments;
+	if(!readVarUInt(ptr, end, binRows) || !readVarUInt(ptr, end, binCols) || !readVarUInt(ptr, end, numSegments))
+		return false;
+
+	// check the header against the payload before anything is allocated
+	const uint64_t numValues = static_cast<uint64_t>(binRows)*binCols;
+	if(numValues > static_cast<uint64_t>(INT32_MAX))
+		return false;
+	if((binRows == 0 || binCols == 0) && (binRows != binCols || numSegments != 0))
+		return false; // only a matrix without rows and cols has no values
+
+	// every segment needs at least two bytes and holds at least one value
+	if(numSegments > static_cast<std::size_t>(end - ptr)/2 || numSegments > numValues)
+		return false;
+
+	std::vector<MatSegment> segments;
+	segments.reserve(numSegments);
+	uint64_t sum = 0;
+	for(uint32_t i = 0; i < numSegments; ++i)
+	{
+		uint32_t length;
+		if(!readVarUInt(ptr, end, length) || ptr == end)
+			return false;
+		if(length == 0 || length > numValues - sum)
+			return false;
+		segments.push_back(MatSegment(static_cast<int>(length), *ptr++));
+		sum += length;
+	}
+
+	if(sum != numValues || ptr != end)
+		return false;
+
+	rows           = static_cast<int>(binRows);
+	cols           = static_cast<int>(binCols);
+	segmentsChange = std::move(segments);
+	buildRowIndex();
+	return true;
+}
+
+
+void SimpleMatCompress::appendMergedSegment(std::vector<MatSegment>& segments, int length, uint8_t value)
+{
+	if(length <= 0)
+		return;
+	if(!segments.empty() && segments.back().value == value)
+		segments.back().length += length;
+	else
+		segments.push_back(MatSegment(length, value));
+}
+
+void SimpleMatCompress::buildRowIndex()
+{
+	rowIndex.clear();
+
+	sumSegments = 0;
+	for(const MatSegment& segment : segmentsChange)
+		sumSegments += segment.length;
+
+	if(rows <= 0 || cols <= 0 || sumSegments != rows*cols)
+		return;
+
+	rowIndex.reserve(static_cast<std::size_t>(rows) + 1);
+
+	std::size_t segment      = 0;
+	int         segmentStart = 0;
+	for(int row = 0; row <= rows; ++row)
+	{
+		const int pos = row*cols;
+		while(segment < segmentsChange.size() && segmentStart + segmentsChange[segment].length <= pos)
+		{
+			segmentStart += segmentsChange[segment].length;
+			++segment;
+		}
+		rowIndex.push_back(RowStart(static_cast<uint32_t>(segment), pos - segmentStart));
+	}
+}
+
+bool SimpleMatCompress::validRect(int x, int y, int width, int height) const
+{
+	return hasRowIndex()
+	    && x >= 0 && y >= 0 && width >= 0 && height >= 0
+	    && x + width <= cols && y + height <= rows;
+}
+
+void SimpleMatCompress::decodeRowPart(int row, int x, int width, uint8_t* out) const
+{
+	const RowStart& start = rowIndex[static_cast<std::size_t>(row)];
+
+	std::size_t segment = start.segment;
+	int         skip    = start.offset + x;
+	while(width > 0 && skip >= segmentsChange[segment].length)
+	{
+		skip -= segmentsChange[segment].length;
+		++segment;
+	}
+
+	while(width > 0)
+	{
+		const MatSegment& actSegment = segmentsChange[segment];
+		const int length = std::min(width, actSegment.length - skip);
+		std::memset(out, actSegment.value, static_cast<std::size_t>(length));
+		out   += length;
+		width -= length;
+		skip   = 0;
+		++segment;
+	}
+}
+
+bool SimpleMatCompress::isEqualRowPart(int row, int x, int width, const uint8_t* in) const
+{
+	const RowStart& start = rowIndex[static_cast<std::size_t>(row)];
+
+	std::size_t segment = start.segment;
+	int         skip    = start.offset + x;
+	while(width > 0 && skip >= segmentsChange[segment].length)
+	{
+		skip -= segmentsChange[segment].length;
+		++segment;
+	}
+
+	while(width > 0)
+	{
+		const MatSegment& actSegment = segmentsChange[segment];
+		const int length = std::min(width, actSegment.length - skip);
+		if(findRunEnd(in, in + length, actSegment.value) != in + length)
+			return false;
+		in    += length;
+		width -= length;
+		skip   = 0;
+		++segment;
+	}
+	return true;
+}
+
+void SimpleMatCompress::replaceRows(const uint8_t* mat, int stride, int firstRow, int endRow)
+{
+	const RowStart head = rowIndex[static_cast<std::size_t>(firstRow)];
+	const RowStart tail = rowIndex[static_cast<std::size_t>(endRow  )];
+
+	std::vector<MatSegment> newSegments;
+	newSegments.reserve(segmentsChange.size() + static_cast<std::size_t>(endRow - firstRow)*2);
+	newSegments.assign(segmentsChange.begin(), segmentsChange.begin() + head.segment);
+	if(head.offset > 0)
+		appendMergedSegment(newSegments, head.offset, segmentsChange[head.segment].value);
+
+	for(int row = firstRow; row < endRow; ++row, mat += stride)
+	{
+		const uint8_t* dataPtr = mat;
+		const uint8_t* dataEnd = mat + cols;
+		while(dataPtr < dataEnd)
+		{
+			const uint8_t  value      = *dataPtr;
+			const uint8_t* segmentEnd = findRunEnd(dataPtr + 1, dataEnd, value);
+			appendMergedSegment(newSegments, static_cast<int>(segmentEnd - dataPtr), value);
+			dataPtr = segmentEnd;
+		}
+	}
+
+	if(tail.segment < segmentsChange.size())
+	{
+		const MatSegment& tailSegment = segmentsChange[tail.segment];
+		appendMergedSegment(newSegments, tailSegment.length - tail.offset, tailSegment.value);
+		newSegments.insert(newSegments.end(), segmentsChange.begin() + tail.segment + 1, segmentsChange.end());
+	}
+
+	segmentsChange.swap(newSegments);
+	buildRowIndex();
+}
+
+bool SimpleMatCompress::writeRectToMat(uint8_t* mat, int stride, int x, int y, int width, int height) const
+{
+	if(mat == nullptr || !validRect(x, y, width, height))
+		return false;
+
+	for(int row = y; row < y + height; ++row, mat += stride)
+		decodeRowPart(row, x, width, mat);
+	return true;
+}
+
+bool SimpleMatCompress::patchRect(const uint8_t* mat, int stride, int x, int y, int width, int height)
+{
+	if(mat == nullptr || !validRect(x, y, width, height))
+		return false;
+	if(height == 0)
+		return true;
+
+	if(x == 0 && width == cols)
+	{
+		replaceRows(mat, stride, y, y + height);
+		return true;
+	}
+
+	// complete the rows around the rect
+	std::vector<uint8_t> buffer(static_cast<std::size_t>(height)*static_cast<std::size_t>(cols));
+	uint8_t* bufferRow = buffer.data();
+	for(int row = y; row < y + height; ++row, bufferRow += cols, mat += stride)
+	{
+		decodeRowPart(row, 0, cols, bufferRow);
+		std::memcpy(bufferRow + x, mat, static_cast<std::size_t>(width));
+	}
+
+	replaceRows(buffer.data(), cols, y, y + height);
+	return true;
+}
+
+bool SimpleMatCompress::findChangedRows(const uint8_t* mat, int rows, int cols, int& firstRow, int& endRow) const
+{
+	if(this->rows != rows || this->cols != cols || mat == nullptr || !hasRowIndex())
+		return false;
+
+	firstRow = 0;
+	while(firstRow < rows && isEqualRowPart(firstRow, 0, cols, mat + firstRow*cols))
+		++firstRow;
+
+	endRow = rows;
+	while(endRow > firstRow && isEqualRowPart(endRow - 1, 0, cols, mat + (endRow - 1)*cols))
+		--endRow;
+
+	return true;
+}
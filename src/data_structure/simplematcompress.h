@@ -20,6 +20,7 @@
 #define SIMPLEMATCOMPRESS_H
 
 #include <vector>
+#include <string>
 #include <cstdint>
 
 #include <boost/serialization/vector.hpp>
@@ -55,7 +56,17 @@ class SimpleMatCompress
 		}
 	};
 
+	// segment containing the first pixel of a row and the offset of the pixel in it
+	struct RowStart
+	{
+		RowStart(uint32_t segment, int offset) : segment(segment), offset(offset) {}
+
+		uint32_t segment;
+		int      offset;
+	};
+
 	std::vector<MatSegment> segmentsChange;
+	std::vector<RowStart>   rowIndex;                                // rows+1 entries, not serialized
 	int rows = 0;
 	int cols = 0;
 	int sumSegments = 0;
@@ -66,8 +77,19 @@ class SimpleMatCompress
 		ar & rows;
 		ar & cols;
 		ar & segmentsChange;
+		if(Archive::is_loading::value)
+			buildRowIndex();
 	}
 	void addSegment(int length, uint8_t value);
+	static void appendMergedSegment(std::vector<MatSegment>& segments, int length, uint8_t value);
+
+	void buildRowIndex();
+	bool hasRowIndex() const                                        { return !rowIndex.empty(); }
+	bool validRect(int x, int y, int width, int height) const;
+
+	void decodeRowPart (int row, int x, int width,       uint8_t* out) const;
+	bool isEqualRowPart(int row, int x, int width, const uint8_t* in ) const;
+	void replaceRows(const uint8_t* mat, int stride, int firstRow, int endRow);
 
 public:
 	SimpleMatCompress() = default;
@@ -78,11 +100,27 @@ public:
 	int getRows() const { return rows; }
 	int getCols() const { return cols; }
 
+	std::size_t getMemorySize() const;
+
 	bool readFromMat(const uint8_t* mat, int rows, int cols);
 	bool writeToMat (      uint8_t* mat, int rows, int cols) const;
 
 	bool isEqual(const uint8_t* mat, int rows, int cols) const;
 	bool operator==(const SimpleMatCompress& other) const;
+
+	/**
+	 * compact form: version byte, varint rows, cols, number of segments
+	 * and per segment varint length and value byte
+	 */
+	void writeBinary(std::string& out) const;                        // appends to out
+	bool readBinary (const char* data, std::size_t size);
+
+	// partial access through the row index, mat points to the top left pixel of the rect
+	bool writeRectToMat(      uint8_t* mat, int stride, int x, int y, int width, int height) const;
+	bool patchRect     (const uint8_t* mat, int stride, int x, int y, int width, int height);
+
+	// rows [firstRow, endRow) differ from mat, firstRow == endRow if equal; false if the size differs
+	bool findChangedRows(const uint8_t* mat, int rows, int cols, int& firstRow, int& endRow) const;
 };
 
 
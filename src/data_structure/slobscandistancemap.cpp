@@ -24,17 +24,28 @@
 #include<map>
 #include<limits>
 #include<cmath>
+#include<cstdint>
+#include<iterator>
+#include<algorithm>
+#include<type_traits>
 
 #include<opencv/cv.hpp>
 
+#include<QFile>
+#include<QSaveFile>
+
 #include<octdata/datastruct/series.h>
 #include<octdata/datastruct/bscan.h>
 #include<octdata/datastruct/sloimage.h>
 
+#include<oct_cpp_framework/callback.h>
+
 
-#include<data_structure/matrx.h>
+#include<data_structure/alignedmatrix.h>
+#include<data_structure/slointerpolationoperator.h>
 #include<data_structure/point2d.h>
 #include <helper/slocoordtranslator.h>
+#include <helper/parallelfor.h>
 
 
 namespace
@@ -42,85 +53,186 @@ namespace
 
 	typedef double DistanceType;
 
-	class TrailMap
+	// increase on every change of the file layout or of the map calculation
+	constexpr const uint64_t cacheFileVersion    = 1;
+	constexpr const char     cacheFileMagic[8]   = {'O', 'M', 'D', 'I', 'S', 'T', 'M', 'P'};
+	constexpr const qint64   cacheFileHeaderSize = AlignedMatrix<float>::alignment;
+
+	struct CacheFileHeader
+	{
+		char     magic[8];
+		uint64_t version;
+		uint64_t geometryHash;
+		uint64_t sizeX;
+		uint64_t sizeY;
+		uint64_t dataSize;
+	};
+	static_assert(sizeof(CacheFileHeader) <= cacheFileHeaderSize, "cache file header exceeds the reserved space");
+
+	// FNV-1a
+	class GeometryHash
 	{
-		std::vector<PixtureElement> actTrailDist;
-		std::vector<PixtureElement> nextTrailDist;
-		DistanceType actDist = 0;
+		uint64_t hash = 14695981039346656037ull;
 	public:
-		void clear()
+		template<typename T>
+		void add(const T& value)
 		{
-			actTrailDist.clear();
-			nextTrailDist.clear();
-			actDist = 0;
+			static_assert(std::is_arithmetic<T>::value, "GeometryHash only supports arithmetic types");
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+			for(std::size_t i = 0; i < sizeof(T); ++i)
+			{
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
 		}
 
-		void emplace(DistanceType dist, const PixtureElement& ele)
+		void add(const OctData::CoordSLOpx& coord)                  { add(coord.getXf()); add(coord.getYf()); }
+
+		uint64_t getHash()                                    const { return hash; }
+	};
+
+	template<typename T>
+	bool writePlane(QIODevice& device, const AlignedMatrix<T>& plane)
+	{
+		const qint64 size = static_cast<qint64>(plane.memorySize());
+		if(size == 0)
+			return true;
+		return device.write(reinterpret_cast<const char*>(plane.scanLine(0)), size) == size;
+	}
+
+	enum class PixelStatus : uint8_t { FAR_AWAY, BRODER };
+
+
+	// pixels reached by one b-scan with the euclidean distance to its nearest a-scan, calculated independent of the other b-scans
+	class BScanTrail
+	{
+	public:
+		struct TrailPixel
 		{
-			if(dist == actDist)
-				actTrailDist.push_back(ele);
-			else
-				nextTrailDist.push_back(ele);
-		}
+			uint32_t                       x;
+			SloBScanDistanceMap::IndexType ascan;
+			float                          distance;
+		};
 
-		void getElement(PixtureElement& ele, DistanceType& dist)
+		std::vector<TrailPixel>  trailPixels;                       // row by row
+		std::vector<std::size_t> rowOffsets;                        // trail pixels of row minY+i: [rowOffsets[i], rowOffsets[i+1])
+		std::size_t              minY = 0;
+
+		void clear()
 		{
-			if(actTrailDist.size() == 0)
-			{
-				actTrailDist.swap(nextTrailDist);
-				actDist += 1;
-			}
-			dist = actDist;
-			ele  = actTrailDist.back();
-			actTrailDist.pop_back();
+			trailPixels.clear();
+			rowOffsets .clear();
+			minY = 0;
 		}
-		std::size_t size() const { return actTrailDist.size() + nextTrailDist.size(); }
+
+		std::size_t endY()                                    const { return rowOffsets.empty() ? minY : minY + rowOffsets.size() - 1; }
 	};
 
 
-	struct SlideInfo
+	// a-scan positions of a b-scan in slo pixel
+	class ScanGeometry
 	{
-		SlideInfo() = default;
+		OctData::BScan::BScanType type = OctData::BScan::BScanType::Unknown;
+		std::size_t bscanWidth = 0;
 
-		SlideInfo(DistanceType distance, std::size_t bscanId, std::size_t ascanId)
-		: distance(distance)
-		, bscanId (bscanId)
-		, ascanId (ascanId)
-		{}
+		// line scan
+		OctData::CoordSLOpx start_px;
+		OctData::CoordSLOpx end_px;
 
-		bool operator<(const SlideInfo& info)                   const { return distance < info.distance; }
-		operator bool()                                         const { return distance != std::numeric_limits<DistanceType>::infinity(); }
+		// circle scan
+		double radius    = 0;
+		double nullAngle = 0;
+		double mX        = 0;
+		double mY        = 0;
+		int rotationFactor = 1;
 
+		double ascanFraction(std::size_t i)                   const { return static_cast<double>(i)/static_cast<double>(bscanWidth-1); }
 
-		DistanceType distance = std::numeric_limits<DistanceType>::infinity();
-		std::size_t bscanId   = std::numeric_limits<std::size_t>::max();
-		std::size_t ascanId   = std::numeric_limits<std::size_t>::max();
-	};
+		std::size_t nearestLineAScan(const OctData::CoordSLOpx& pos) const
+		{
+			const double lengthX = end_px.getXf() - start_px.getXf();
+			const double lengthY = end_px.getYf() - start_px.getYf();
+			const double lengthQuad = lengthX*lengthX + lengthY*lengthY;
+			if(lengthQuad <= 0)
+				return 0;
+
+			const double frac  = ((pos.getXf() - start_px.getXf())*lengthX + (pos.getYf() - start_px.getYf())*lengthY)/lengthQuad;
+			const double ascan = std::round(frac*static_cast<double>(bscanWidth-1));
+			if(ascan <= 0)
+				return 0;
+			if(ascan >= static_cast<double>(bscanWidth-1))
+				return bscanWidth-1;
+			return static_cast<std::size_t>(ascan);
+		}
 
+		std::size_t nearestCircleAScan(const OctData::CoordSLOpx& pos) const
+		{
+			// invert angle = (v+nullAngle)*2*pi*rotationFactor, the nearest a-scan is one of the two a-scans around v
+			const double angle = std::atan2(pos.getYf() - mY, pos.getXf() - mX);
+			double v = angle/(2.*M_PI)*rotationFactor - nullAngle;
+			v -= std::floor(v);
+
+			const std::size_t ascan1 = std::min(static_cast<std::size_t>(v*static_cast<double>(bscanWidth-1)), bscanWidth-1);
+			const std::size_t ascan2 = std::min(ascan1 + 1, bscanWidth-1);
+			if(getAScanPos(ascan2).absQuad(pos) < getAScanPos(ascan1).absQuad(pos))
+				return ascan2;
+			return ascan1;
+		}
 
-	class PixelInfo
-	{
 	public:
-		enum class Status : uint8_t { FAR_AWAY, ACCEPTED, BRODER };
+		ScanGeometry() = default;
+		ScanGeometry(const OctData::BScan& bscan, const SloCoordTranslator& transformCoord)
+		: type      (bscan.getBScanType())
+		, bscanWidth(static_cast<std::size_t>(std::max(0, bscan.getWidth())))
+		{
+			switch(type)
+			{
+				case OctData::BScan::BScanType::Line:
+					start_px = transformCoord(bscan.getStart());
+					end_px   = transformCoord(bscan.getEnd()  );
+					break;
+				case OctData::BScan::BScanType::Circle:
+				{
+					const OctData::CoordSLOpx circleStart_px = transformCoord(bscan.getStart ());
+					const OctData::CoordSLOpx center_px      = transformCoord(bscan.getCenter());
 
-		Status status = Status::FAR_AWAY;
-		std::size_t ascan = 0;
-		bool hasValue = false;
+					radius = circleStart_px.abs(center_px);
+					double ratio  = circleStart_px.getXf() - center_px.getXf();
+					nullAngle = acos( ratio/radius )/M_PI/2.;
 
-		SlideInfo val1;
-		SlideInfo val2;
+					rotationFactor = bscan.getClockwiseRot()?1:-1;
+
+					mX = center_px.getXf();
+					mY = center_px.getYf();
+					break;
+				}
+				case OctData::BScan::BScanType::Unknown:
+					break;
+			}
+		}
 
-		bool updateValue(const SlideInfo& info)
+		bool isValid()                                        const { return bscanWidth >= 2 && type != OctData::BScan::BScanType::Unknown; }
+		std::size_t getWidth()                                const { return bscanWidth; }
+
+		OctData::CoordSLOpx getAScanPos(std::size_t i) const
 		{
-			if(val2 < info)
-				return false;
+			const double v = ascanFraction(i);
+			if(type == OctData::BScan::BScanType::Circle)
+			{
+				const double angle = (v+nullAngle)*2.*M_PI*rotationFactor;
 
-			val2 = info;
-			if(val2 < val1)
-				std::swap(val1, val2);
+				const double x = cos(angle)*radius + mX;
+				const double y = sin(angle)*radius + mY;
+				return OctData::CoordSLOpx(x, y);
+			}
+			return start_px*(1-v) + end_px*v;
+		}
 
-			hasValue = true;
-			return true;
+		std::size_t getNearestAScan(const OctData::CoordSLOpx& pos) const
+		{
+			if(type == OctData::BScan::BScanType::Circle)
+				return nearestCircleAScan(pos);
+			return nearestLineAScan(pos);
 		}
 	};
 
@@ -129,28 +241,29 @@ namespace
 	{
 		SloBScanDistanceMap::PreCalcDataMatrix& matrix;
 		const OctData::Series& series;
+		CppFW::Callback* callback;
+		bool calculationBreaked = false;
 
-		typedef Matrix<PixelInfo> PixelMap;
+		typedef AlignedMatrix<PixelStatus> PixelMap;
 
 		PixelMap pixelMap;
-		TrailMap trailMap;
 
 		SloCoordTranslator transformCoord;
+		std::vector<ScanGeometry> bscanGeometries;
 
 		constexpr static const DistanceType maxDistance = 25;
-		std::size_t actBscanNr = 0;
+		constexpr static const std::size_t  bandHeight  = 16;
 
 		static Point2D coordSLO2Point(const OctData::CoordSLOpx& c)                { return Point2D(c.getXf(), c.getYf()); }
 
+		// set broder value on each a-scan position to stop evaluation from other b-scans on this bariere (reduce calculation time and artefacts)
 		class ValueSetter
 		{
 			FillPreCalcData& ctm;
-			bool add2TrailMap = false; // add2TrailMap == false: For set broder value on each a-scan position to stop evaluation from other b-scans on this bariere (reduce calculation time and artefacts)
-			std::size_t nextAscan = 0;
 		public:
-			ValueSetter(FillPreCalcData& ctm, bool add2TrailMap) : ctm(ctm), add2TrailMap(add2TrailMap) {}
+			ValueSetter(FillPreCalcData& ctm) : ctm(ctm)                {}
 
-			void operator()(const OctData::CoordSLOpx& coord, std::size_t ascan)
+			void operator()(const OctData::CoordSLOpx& coord, std::size_t /*ascan*/)
 			{
 				const std::size_t x = static_cast<std::size_t>(coord.getX());
 				const std::size_t y = static_cast<std::size_t>(coord.getY());
@@ -158,232 +271,218 @@ namespace
 				if(x >= ctm.pixelMap.getSizeX() || y >= ctm.pixelMap.getSizeY())
 					return;
 
-				PixelInfo& info = ctm.pixelMap(x, y);
-				info.status = PixelInfo::Status::BRODER;
-				info.ascan  = ascan;
-				if(add2TrailMap)
-				{
-					info.updateValue(SlideInfo(0, ctm.actBscanNr, ascan));
-					ctm.trailMap.emplace(0, PixtureElement(x, y));
-				}
+				ctm.pixelMap(x, y) = PixelStatus::BRODER;
 			}
-			constexpr static const bool calcDistMap = false;
-
-			void loopInit()                          { nextAscan = 0; }
-			bool loopIncrement(std::size_t maxAscan) { ++nextAscan; return nextAscan < maxAscan; }
-			std::size_t getNextAscanNr() const       { return nextAscan; }
 		};
 
-		class FindMinAScan
+		class StartPixelCollector
 		{
-			OctData::CoordSLOpx pos;
-			std::size_t minAscan = 0;
-			double minDistance = std::numeric_limits<double>::infinity();
-
-			std::size_t nextAscan = 0;
-			double lastDistance1 = std::numeric_limits<double>::infinity();
-			double lastDistance2 = std::numeric_limits<double>::infinity();
-			enum class State { Start, Init, TestPost, Pos, Neg, End };
-			State state;
-
+			std::vector<PixtureElement>& startPixels;
+			const std::size_t sizeX;
+			const std::size_t sizeY;
 		public:
-			FindMinAScan(const OctData::CoordSLOpx& pos, std::size_t startAScan) : pos(pos), minAscan(startAScan) {}
+			StartPixelCollector(std::vector<PixtureElement>& startPixels, std::size_t sizeX, std::size_t sizeY) : startPixels(startPixels), sizeX(sizeX), sizeY(sizeY) {}
 
-			void operator()(const OctData::CoordSLOpx& coord, std::size_t ascan)
+			void operator()(const OctData::CoordSLOpx& coord, std::size_t /*ascan*/)
 			{
-				double d = coord.absQuad(pos);
-				if(d < minDistance)
-				{
-					minDistance = d;
-					minAscan    = ascan;
-				}
-				lastDistance2 = lastDistance1;
-				lastDistance1 = d;
-			}
-
-			std::size_t getMinAScan() const { return minAscan; }
-			double getMinDistance()   const { return std::sqrt(minDistance); }
+				const std::size_t x = static_cast<std::size_t>(coord.getX());
+				const std::size_t y = static_cast<std::size_t>(coord.getY());
 
-			void loopInit()                          { nextAscan = minAscan; state = State::Start; }
-			bool loopIncrement(std::size_t maxAscan)
-			{
-				if(state == State::Pos || state == State::Neg)
-					if(lastDistance1 > lastDistance2)
-						return false;
+				if(x >= sizeX || y >= sizeY)
+					return;
 
-				switch(state)
-				{
-					case State::Start: // iteration 0, no value has checked
-						state = State::Init;
-						return true;
-					case State::Init: // iteration 1, the start value has checked
-						if(minAscan == maxAscan-1) { state = State::Neg     ; --nextAscan; } // end of bscan, only neg is possible
-						else                       { state = State::TestPost; ++nextAscan; }
-						return true;
-					case State::TestPost:
-						if(lastDistance1 > lastDistance2) { state = State::Neg; --nextAscan; } // wrong direction
-						else                              { state = State::Pos; ++nextAscan; } // pos is good
-						return true;
-					case State::Pos:
-						++nextAscan;
-						return nextAscan < maxAscan;
-					case State::Neg:
-						return nextAscan-- > 0;
-					case State::End:
-						return false;
-				}
-				return false;
+				startPixels.push_back(PixtureElement(x, y));
 			}
-			std::size_t getNextAscanNr() const       { return nextAscan; }
 		};
 
-
-
 		template<typename AScanHandler>
-		void addLineScan(const OctData::BScan& bscan, AScanHandler& handler)
+		static void addBScan(const ScanGeometry& geometry, AScanHandler& pixelSetter)
 		{
-			const OctData::CoordSLOpx start_px = transformCoord(bscan.getStart());
-			const OctData::CoordSLOpx   end_px = transformCoord(bscan.getEnd()  );
-
-			const std::size_t bscanWidth = static_cast<std::size_t>(bscan.getWidth());
-
-			if(bscanWidth < 2)
+			if(!geometry.isValid())
 				return;
 
-// 			for(std::size_t i=0; i<bscanWidth; ++i)
-			handler.loopInit();
-			while(handler.loopIncrement(bscanWidth))
-			{
-				const std::size_t i = handler.getNextAscanNr();
-				const double v = static_cast<double>(i)/static_cast<double>(bscanWidth-1);
-				const OctData::CoordSLOpx actPos = start_px*(1-v) + end_px*v;
-				handler(actPos, i);
-			}
+			for(std::size_t i = 0; i < geometry.getWidth(); ++i)
+				pixelSetter(geometry.getAScanPos(i), i);
 		}
 
 
 		template<typename AScanHandler>
-		void addCircleScan(const OctData::BScan& bscan, AScanHandler& handler)
+		void addBScans(AScanHandler& pixelSetter)
 		{
-			const OctData::CoordSLOpx start_px  = transformCoord(bscan.getStart ());
-			const OctData::CoordSLOpx center_px = transformCoord(bscan.getCenter());
-
-			const std::size_t bscanWidth = static_cast<std::size_t>(bscan.getWidth());
+			for(const ScanGeometry& geometry : bscanGeometries)
+				addBScan(geometry, pixelSetter);
+		}
 
-			if(bscanWidth < 2)
-				return;
+		// ----------------------
+		// create distance map
+		// ----------------------
+		// Every b-scan spreads from its a-scan pixels over the pixels nearer than maxDistance, stopped by the
+		// broder pixels. The distance of a pixel is calculated exact from the b-scan geometry, only the pixels
+		// in the row spans around the a-scan pixels are evaluated. The b-scans are independent, so they are
+		// calculated in parallel and merged with updateValue in b-scan order.
+		struct TrailPixelInfo
+		{
+			float                          distance = 0;
+			SloBScanDistanceMap::IndexType ascan    = 0;
+			bool                           accepted = false;
+		};
 
-			bool clockwise = bscan.getClockwiseRot();
+		void calcBScanTrail(std::size_t bscanNr, BScanTrail& trail) const
+		{
+			trail.clear();
 
-			double radius = start_px.abs(center_px);
-			double ratio  = start_px.getXf() - center_px.getXf();
-			double nullAngle = acos( ratio/radius )/M_PI/2.;
+			const std::size_t sizeX = pixelMap.getSizeX();
+			const std::size_t sizeY = pixelMap.getSizeY();
 
-			const int rotationFactor = clockwise?1:-1;
+			const ScanGeometry& geometry = bscanGeometries[bscanNr];
 
-			double mX = center_px.getXf();
-			double mY = center_px.getYf();
+			std::vector<PixtureElement> startPixels;
+			StartPixelCollector collector(startPixels, sizeX, sizeY);
+			addBScan(geometry, collector);
+			if(startPixels.empty())
+				return;
 
-// 			for(std::size_t i=0; i<bscanWidth; ++i)
-			handler.loopInit();
-			while(handler.loopIncrement(bscanWidth))
+			// row spans of the pixels near the a-scan pixels, a pixel position differs less than one from its a-scan
+			const std::size_t border = static_cast<std::size_t>(std::ceil(maxDistance)) + 1;
+			std::size_t minY = sizeY;
+			std::size_t maxY = 0;
+			for(const PixtureElement& pixel : startPixels)
 			{
-				const std::size_t i = handler.getNextAscanNr();
-				const double v     = static_cast<double>(i)/static_cast<double>(bscanWidth-1);
-				const double angle = (v+nullAngle)*2.*M_PI*rotationFactor;
-
-				const double x = cos(angle)*radius + mX;
-				const double y = sin(angle)*radius + mY;
-				const OctData::CoordSLOpx actPos(x, y);
-				handler(actPos, i);
+				minY = std::min(minY, pixel.getY());
+				maxY = std::max(maxY, pixel.getY());
 			}
-		}
-
+			minY = minY > border ? minY - border : 0;
+			maxY = std::min(maxY + border + 1, sizeY);
 
-		template<typename AScanHandler>
-		void addBScan(const OctData::BScan& bscan, AScanHandler& pixelSetter)
-		{
-			switch(bscan.getBScanType())
+			std::vector<std::size_t> spanMinX(maxY - minY, sizeX);
+			std::vector<std::size_t> spanMaxX(maxY - minY, 0);
+			for(const PixtureElement& pixel : startPixels)
 			{
-				case OctData::BScan::BScanType::Line:
-					addLineScan(bscan, pixelSetter);
-					break;
-				case OctData::BScan::BScanType::Circle:
-					addCircleScan(bscan, pixelSetter);
-					break;
-				case OctData::BScan::BScanType::Unknown:
-					break;
+				const std::size_t pixelMinX = pixel.getX() > border ? pixel.getX() - border : 0;
+				const std::size_t pixelMaxX = std::min(pixel.getX() + border + 1, sizeX);
+				const std::size_t pixelMinY = pixel.getY() > border ? pixel.getY() - border : 0;
+				const std::size_t pixelMaxY = std::min(pixel.getY() + border + 1, sizeY);
+				for(std::size_t y = pixelMinY; y < pixelMaxY; ++y)
+				{
+					spanMinX[y - minY] = std::min(spanMinX[y - minY], pixelMinX);
+					spanMaxX[y - minY] = std::max(spanMaxX[y - minY], pixelMaxX);
+				}
 			}
-		}
 
+			std::vector<std::size_t> spanOffsets(maxY - minY + 1, 0);
+			for(std::size_t row = 0; row < maxY - minY; ++row)
+				spanOffsets[row+1] = spanOffsets[row] + (spanMaxX[row] > spanMinX[row] ? spanMaxX[row] - spanMinX[row] : 0);
 
-		template<typename AScanHandler>
-		void addBScans(AScanHandler& pixelSetter, bool evaluation)
-		{
-			std::size_t bscanNr = 0;
-			for(const OctData::BScan* bscan : series.getBScans())
+			std::vector<TrailPixelInfo> spanPixels(spanOffsets.back());
+			auto getSpanPixel = [&](std::size_t x, std::size_t y) -> TrailPixelInfo*
 			{
-				actBscanNr = bscanNr;
-				if(bscan)
-					addBScan(*bscan, pixelSetter);
+				const std::size_t row = y - minY;
+				if(y < minY || y >= maxY || x < spanMinX[row] || x >= spanMaxX[row])
+					return nullptr;
+				return &spanPixels[spanOffsets[row] + x - spanMinX[row]];
+			};
+
+			std::vector<PixtureElement> fillStack;
+			auto acceptPixel = [&](std::size_t x, std::size_t y, bool startPixel)
+			{
+				if(!startPixel && pixelMap(x, y) == PixelStatus::BRODER)
+					return;
 
-				if(evaluation)
-					calcActDistMap();
+				TrailPixelInfo* info = getSpanPixel(x, y);
+				if(!info || info->accepted)
+					return;
 
-				++bscanNr;
-			}
-		}
+				const OctData::CoordSLOpx pos(static_cast<double>(x), static_cast<double>(y));
+				const std::size_t ascan    = geometry.getNearestAScan(pos);
+				const double      distance = geometry.getAScanPos(ascan).abs(pos);
+				if((!startPixel && distance >= maxDistance) || ascan >= SloBScanDistanceMap::invalidIndex)
+					return;
 
-		// ----------------------
-		// create L1 distance map
-		// ----------------------
-		inline void addTrail(std::size_t x, std::size_t y, DistanceType distance, PixelInfo& info, std::size_t ascan)
-		{
-			info.status = PixelInfo::Status::ACCEPTED;
-			info.ascan  = ascan;
+				info->accepted = true;
+				info->ascan    = static_cast<SloBScanDistanceMap::IndexType>(ascan);
+				info->distance = static_cast<float>(distance);
+				fillStack.push_back(PixtureElement(x, y));
+			};
 
-			if(info.updateValue(SlideInfo(distance, actBscanNr, ascan)))
-				trailMap.emplace(distance, PixtureElement(x, y));
-		}
+			for(const PixtureElement& pixel : startPixels)
+				acceptPixel(pixel.getX(), pixel.getY(), true);
 
+			while(!fillStack.empty())
+			{
+				const PixtureElement aktEle = fillStack.back();
+				fillStack.pop_back();
 
-		inline void calcSetTrailDistanceL1(std::size_t x, std::size_t y, DistanceType distance, std::size_t ascan)
-		{
-			PixelInfo& newTrailInfo = pixelMap(x, y);
-			if(newTrailInfo.status == PixelInfo::Status::FAR_AWAY)
+				const std::size_t aktX = aktEle.getX();
+				const std::size_t aktY = aktEle.getY();
+
+				if(aktY > 0      ) acceptPixel(aktX  , aktY-1, false);
+				if(aktY < sizeY-1) acceptPixel(aktX  , aktY+1, false);
+				if(aktX > 0      ) acceptPixel(aktX-1, aktY  , false);
+				if(aktX < sizeX-1) acceptPixel(aktX+1, aktY  , false);
+			}
+
+			trail.minY = minY;
+			for(std::size_t y = minY; y < maxY; ++y)
 			{
-				DistanceType trailDistance = distance + 1;
-				if(trailDistance < maxDistance)
-					addTrail(x, y, trailDistance, newTrailInfo, ascan);
+				const std::size_t row = y - minY;
+				trail.rowOffsets.push_back(trail.trailPixels.size());
+				for(std::size_t x = spanMinX[row]; x < spanMaxX[row]; ++x)
+				{
+					const TrailPixelInfo& info = spanPixels[spanOffsets[row] + x - spanMinX[row]];
+					if(info.accepted)
+						trail.trailPixels.push_back(BScanTrail::TrailPixel{static_cast<uint32_t>(x), info.ascan, info.distance});
+				}
 			}
+			trail.rowOffsets.push_back(trail.trailPixels.size());
 		}
 
-		void calcActDistMap()
+		// merge the trails in b-scan order, the rows are independent
+		void mergeBScanTrails(const std::vector<BScanTrail>& trails, std::size_t firstBScanNr, std::size_t numTrails)
 		{
-			DistanceType distance    = 0;
+			const std::size_t sizeY = pixelMap.getSizeY();
 
-			while(trailMap.size() > 0 && distance < maxDistance)
+			parallelFor((sizeY + bandHeight - 1)/bandHeight, [&](std::size_t band)
 			{
-				PixtureElement aktEle;
-				trailMap.getElement(aktEle, distance);
-
-				const std::size_t aktX = aktEle.getX();
-				const std::size_t aktY = aktEle.getY();
+				const std::size_t bandMinY = band*bandHeight;
+				const std::size_t bandMaxY = std::min(bandMinY + bandHeight, sizeY);
 
-				std::size_t ascan = pixelMap(aktX, aktY).ascan;
+				for(std::size_t i = 0; i < numTrails; ++i)
+				{
+					const BScanTrail& trail = trails[i];
+					const SloBScanDistanceMap::IndexType bscanIndex = static_cast<SloBScanDistanceMap::IndexType>(firstBScanNr + i);
 
-				if(aktY > 0                    ) calcSetTrailDistanceL1(aktX  , aktY-1, distance, ascan);
-				if(aktY < pixelMap.getSizeY()-1) calcSetTrailDistanceL1(aktX  , aktY+1, distance, ascan);
-				if(aktX > 0                    ) calcSetTrailDistanceL1(aktX-1, aktY  , distance, ascan);
-				if(aktX < pixelMap.getSizeX()-1) calcSetTrailDistanceL1(aktX+1, aktY  , distance, ascan);
-			}
+					const std::size_t minY = std::max(bandMinY, trail.minY);
+					const std::size_t maxY = std::min(bandMaxY, trail.endY());
+					for(std::size_t y = minY; y < maxY; ++y)
+					{
+						const std::size_t row = y - trail.minY;
+						for(std::size_t j = trail.rowOffsets[row]; j < trail.rowOffsets[row+1]; ++j)
+						{
+							const BScanTrail::TrailPixel& pixel = trail.trailPixels[j];
+							matrix.updateValue(pixel.x, y, SloBScanDistanceMap::InfoBScanDist(pixel.distance, bscanIndex, pixel.ascan));
+						}
+					}
+				}
+			});
+		}
 
-			trailMap.clear();
+		void calcTrails()
+		{
+			const std::size_t numBScans = std::min(series.bscanCount(), static_cast<std::size_t>(SloBScanDistanceMap::invalidIndex));
+			const std::size_t batchSize = static_cast<std::size_t>(std::max(1, cv::getNumThreads()))*4;
 
-			for(PixelInfo& info : pixelMap) // reset map for next b-scan calculation
+			std::vector<BScanTrail> trails(std::min(batchSize, numBScans));
+			for(std::size_t firstBScanNr = 0; firstBScanNr < numBScans; firstBScanNr += batchSize)
 			{
-				if(info.status != PixelInfo::Status::BRODER)
-					info.status = PixelInfo::Status::FAR_AWAY;
+				const std::size_t numTrails = std::min(batchSize, numBScans - firstBScanNr);
+				parallelFor(numTrails, [&](std::size_t i) { calcBScanTrail(firstBScanNr + i, trails[i]); });
+				mergeBScanTrails(trails, firstBScanNr, numTrails);
+
+				if(callback && !callback->callback(static_cast<double>(firstBScanNr + numTrails)/static_cast<double>(numBScans)))
+				{
+					calculationBreaked = true;
+					return;
+				}
 			}
 		}
 
@@ -414,11 +513,8 @@ namespace
 
 		void drawScanLine(std::size_t y, std::size_t x1, std::size_t x2)
 		{
-			      PixelInfo*       it    = pixelMap.scanLine(y);
-			const PixelInfo* const itEnd = pixelMap.scanLine(y) + x2;
-			it += x1;
-			for(;it != itEnd; ++it)
-				it->status = PixelInfo::Status::BRODER;
+			PixelStatus* line = pixelMap.scanLine(y);
+			std::fill(line + x1, line + x2, PixelStatus::BRODER);
 		}
 
 		void fillConvexBroder(const OctData::Series::BScanSLOCoordList& broderPoints)
@@ -462,7 +558,7 @@ namespace
 		}
 
 
-		void creatL1DistanceMap()
+		void creatDistanceMap()
 		{
 			const OctData::Series::BScanSLOCoordList& convexHull = series.getConvexHull();
 			const OctData::SloImage& sloImage = series.getSloImage();
@@ -473,91 +569,102 @@ namespace
 
 			fillConvexBroder(convexHull);
 
-			ValueSetter ivs(*this, false);
-			addBScans(ivs, false);
+			ValueSetter ivs(*this);
+			addBScans(ivs);
 
-			ValueSetter apvs(*this, true);
-			addBScans(apvs, true);
+			calcTrails();
 
 		}
 
 
 
 
-		// --------------------
-		// finisch distance map
-		// --------------------
-
-		void recalcDistDataL2(std::size_t x, std::size_t y, SloBScanDistanceMap::InfoBScanDist& info, const SlideInfo& slideInfo)
+	public:
+		FillPreCalcData(SloBScanDistanceMap::PreCalcDataMatrix& matrix, const OctData::Series& series, CppFW::Callback* callback)
+		: matrix(matrix)
+		, series(series)
+		, callback(callback)
+		, pixelMap(matrix.getSizeX(), matrix.getSizeY(), PixelStatus::FAR_AWAY)
+		, transformCoord(series)
 		{
-			std::size_t bscanNr = info.bscan;
-			if(bscanNr >= series.bscanCount())
-				return;
+			for(const OctData::BScan* bscan : series.getBScans())
+			{
+				if(bscan)
+					bscanGeometries.emplace_back(*bscan, transformCoord);
+				else
+					bscanGeometries.emplace_back();
+			}
 
-			FindMinAScan fmas(OctData::CoordSLOpx(static_cast<double>(x), static_cast<double>(y)), slideInfo.ascanId);
+			creatDistanceMap();
+		}
 
-			const OctData::BScan* bscan = series.getBScan(bscanNr);
-			if(bscan)
-				addBScan(*bscan, fmas);
+		bool isCalculationBreaked()                           const { return calculationBreaked; }
+	};
+}
 
-			info.ascan    = fmas.getMinAScan();
-			info.distance = fmas.getMinDistance();
-		}
 
-		void fillPreCalcData()
-		{
-			SloBScanDistanceMap::PreCalcDataMatrix::value_type* itOut = matrix.begin();
-			PixelMap::value_type* itIn = pixelMap.begin();
+constexpr const SloBScanDistanceMap::IndexType SloBScanDistanceMap::invalidIndex;
 
-			const std::size_t sizeX = matrix.getSizeX();
-			const std::size_t sizeY = matrix.getSizeY();
 
-			for(std::size_t y = 0; y < sizeY; ++y)
-			{
-				for(std::size_t x = 0; x < sizeX; ++x)
-				{
-					if(itIn->hasValue)
-					{
-						SloBScanDistanceMap::InfoBScanDist info1;
-						SloBScanDistanceMap::InfoBScanDist info2;
-						info1.bscan = itIn->val1.bscanId;
-						info2.bscan = itIn->val2.bscanId;
-
-#if true
-						recalcDistDataL2(x, y, info1, itIn->val1);
-						recalcDistDataL2(x, y, info2, itIn->val2);
-#else
-						info1.ascan    = itIn->val1.ascanId;
-						info2.ascan    = itIn->val2.ascanId;
-						info1.distance = itIn->val1.distance;
-						info2.distance = itIn->val2.distance;
-#endif
-
-						if(info2.distance < info1.distance)
-							std::swap(info1, info2);
-
-						itOut->bscan1 = info1;
-						itOut->bscan2 = info2;
-						itOut->init   = true;
-					}
-					++itOut;
-					++itIn;
-				}
-			}
-		}
+SloBScanDistanceMap::PreCalcDataMatrix::PreCalcDataMatrix(std::size_t sizeX, std::size_t sizeY)
+: distance1(sizeX, sizeY, std::numeric_limits<float>::infinity())
+, distance2(sizeX, sizeY, std::numeric_limits<float>::infinity())
+, bscan1   (sizeX, sizeY, invalidIndex)
+, bscan2   (sizeX, sizeY, invalidIndex)
+, ascan1   (sizeX, sizeY, invalidIndex)
+, ascan2   (sizeX, sizeY, invalidIndex)
+, init     ((sizeX + 63)/64, sizeY, 0)
+{
+}
 
 
-	public:
-		FillPreCalcData(SloBScanDistanceMap::PreCalcDataMatrix& matrix, const OctData::Series& series)
-		: matrix(matrix)
-		, series(series)
-		, pixelMap(matrix.getSizeX(), matrix.getSizeY())
-		, transformCoord(series)
-		{
-			creatL1DistanceMap();
-			fillPreCalcData();
-		}
-	};
+SloBScanDistanceMap::PreCalcDataMatrix::PreCalcDataMatrix(std::size_t sizeX, std::size_t sizeY, const uint8_t* data)
+{
+	distance1.setView(data, sizeX          , sizeY); data += distance1.memorySize();
+	distance2.setView(data, sizeX          , sizeY); data += distance2.memorySize();
+	bscan1   .setView(data, sizeX          , sizeY); data += bscan1   .memorySize();
+	bscan2   .setView(data, sizeX          , sizeY); data += bscan2   .memorySize();
+	ascan1   .setView(data, sizeX          , sizeY); data += ascan1   .memorySize();
+	ascan2   .setView(data, sizeX          , sizeY); data += ascan2   .memorySize();
+	init     .setView(data, (sizeX + 63)/64, sizeY);
+}
+
+
+bool SloBScanDistanceMap::PreCalcDataMatrix::writeData(QIODevice& device) const
+{
+	return writePlane(device, distance1) && writePlane(device, distance2)
+	    && writePlane(device, bscan1   ) && writePlane(device, bscan2   )
+	    && writePlane(device, ascan1   ) && writePlane(device, ascan2   )
+	    && writePlane(device, init     );
+}
+
+
+void SloBScanDistanceMap::PreCalcDataMatrix::updateValue(std::size_t x, std::size_t y, const InfoBScanDist& info)
+{
+	float& dist1 = distance1(x, y);
+	float& dist2 = distance2(x, y);
+	if(dist2 < info.distance)
+		return;
+
+	dist2          = info.distance;
+	bscan2(x, y)   = info.bscan;
+	ascan2(x, y)   = info.ascan;
+	if(dist2 < dist1)
+	{
+		std::swap(dist1, dist2);
+		std::swap(bscan1(x, y), bscan2(x, y));
+		std::swap(ascan1(x, y), ascan2(x, y));
+	}
+
+	init(x/64, y) |= uint64_t(1) << (x%64);
+}
+
+
+std::size_t SloBScanDistanceMap::PreCalcDataMatrix::calcMemorySize(std::size_t sizeX, std::size_t sizeY)
+{
+	return AlignedMatrix<float    >::calcMemorySize(sizeX, sizeY)*2
+	     + AlignedMatrix<IndexType>::calcMemorySize(sizeX, sizeY)*4
+	     + AlignedMatrix<uint64_t >::calcMemorySize((sizeX + 63)/64, sizeY);
 }
 
 
@@ -568,11 +675,33 @@ SloBScanDistanceMap::SloBScanDistanceMap()
 
 SloBScanDistanceMap::~SloBScanDistanceMap()
 {
+	delete interpolationOperator;
 	delete preCalcDataMatrix;
 }
 
 
-void SloBScanDistanceMap::createData(const OctData::Series* series)
+std::size_t SloBScanDistanceMap::memorySize() const
+{
+	std::size_t size = 0;
+	if(preCalcDataMatrix)
+		size += preCalcDataMatrix->memorySize();
+	if(interpolationOperator)
+		size += interpolationOperator->memorySize();
+	return size;
+}
+
+
+void SloBScanDistanceMap::createInterpolationOperator()
+{
+	delete interpolationOperator;
+	interpolationOperator = nullptr;
+
+	if(preCalcDataMatrix)
+		interpolationOperator = new SloInterpolationOperator(*preCalcDataMatrix);
+}
+
+
+void SloBScanDistanceMap::createData(const OctData::Series* series, CppFW::Callback* callback)
 {
 	if(!series)
 		return;
@@ -589,7 +718,116 @@ void SloBScanDistanceMap::createData(const OctData::Series* series)
 
 	if(oldPreCalcDataMatrix)
 		delete oldPreCalcDataMatrix;
+	mappedFile.reset();
+
+	FillPreCalcData fpcd(*preCalcDataMatrix, *series, callback);
+	if(fpcd.isCalculationBreaked())
+	{
+		delete preCalcDataMatrix;
+		preCalcDataMatrix = nullptr;
+	}
+
+	createInterpolationOperator();
+}
+
+
+uint64_t SloBScanDistanceMap::calcGeometryHash(const OctData::Series& series)
+{
+	GeometryHash hash;
+	hash.add(cacheFileVersion);
+
+	const cv::Mat& sloImageMat = series.getSloImage().getImage();
+	hash.add(sloImageMat.cols);
+	hash.add(sloImageMat.rows);
+
+	const SloCoordTranslator transformCoord(series);
+
+	hash.add(series.bscanCount());
+	for(const OctData::BScan* bscan : series.getBScans())
+	{
+		if(!bscan)
+		{
+			hash.add(-1);
+			continue;
+		}
+
+		hash.add(static_cast<int>(bscan->getBScanType()));
+		hash.add(bscan->getWidth());
+		hash.add(bscan->getClockwiseRot());
+		hash.add(transformCoord(bscan->getStart ()));
+		hash.add(transformCoord(bscan->getEnd   ()));
+		hash.add(transformCoord(bscan->getCenter()));
+	}
+
+	const OctData::Series::BScanSLOCoordList& convexHull = series.getConvexHull();
+	hash.add(convexHull.size());
+	for(const OctData::CoordSLOmm& point : convexHull)
+		hash.add(transformCoord(point));
+
+	return hash.getHash();
+}
+
+
+bool SloBScanDistanceMap::writeFile(const QString& filename, uint64_t geometryHash) const
+{
+	if(!preCalcDataMatrix)
+		return false;
+
+	QSaveFile file(filename);
+	if(!file.open(QIODevice::WriteOnly))
+		return false;
+
+	CacheFileHeader header;
+	std::copy(std::begin(cacheFileMagic), std::end(cacheFileMagic), std::begin(header.magic));
+	header.version      = cacheFileVersion;
+	header.geometryHash = geometryHash;
+	header.sizeX        = preCalcDataMatrix->getSizeX();
+	header.sizeY        = preCalcDataMatrix->getSizeY();
+	header.dataSize     = preCalcDataMatrix->memorySize();
+
+	char headerData[cacheFileHeaderSize] = {};
+	std::copy_n(reinterpret_cast<const char*>(&header), sizeof(header), headerData);
+
+	if(file.write(headerData, cacheFileHeaderSize) != cacheFileHeaderSize)
+		return false;
+	if(!preCalcDataMatrix->writeData(file))
+		return false;
+
+	return file.commit();
+}
+
+
+bool SloBScanDistanceMap::mapFile(const QString& filename, uint64_t geometryHash)
+{
+	std::unique_ptr<QFile> file(new QFile(filename));
+	if(!file->open(QIODevice::ReadOnly))
+		return false;
+
+	const qint64 fileSize = file->size();
+	if(fileSize < cacheFileHeaderSize)
+		return false;
+
+	const uint8_t* data = file->map(0, fileSize);
+	file->close(); // the mapping is valid until the QFile object is destroyed
+	if(!data)
+		return false;
+
+	CacheFileHeader header;
+	std::copy_n(data, sizeof(header), reinterpret_cast<uint8_t*>(&header));
+
+	if(!std::equal(std::begin(cacheFileMagic), std::end(cacheFileMagic), std::begin(header.magic))
+	 || header.version      != cacheFileVersion
+	 || header.geometryHash != geometryHash
+	 || header.dataSize     != PreCalcDataMatrix::calcMemorySize(header.sizeX, header.sizeY)
+	 || static_cast<uint64_t>(fileSize - cacheFileHeaderSize) != header.dataSize)
+		return false;
+
+	delete preCalcDataMatrix;
+	preCalcDataMatrix = new PreCalcDataMatrix(static_cast<std::size_t>(header.sizeX), static_cast<std::size_t>(header.sizeY), data + cacheFileHeaderSize);
+	mappedFile = std::move(file);
+
+	createInterpolationOperator();
 
-	FillPreCalcData fpcd(*preCalcDataMatrix, *series);
+	return true;
 }
 
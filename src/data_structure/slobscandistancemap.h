@@ -19,46 +19,104 @@
 #ifndef SLOBSCANDISTANCEMAP_H
 #define SLOBSCANDISTANCEMAP_H
 
-#include<data_structure/matrx.h>
+#include<data_structure/alignedmatrix.h>
 #include<limits>
 #include<vector>
+#include<memory>
+#include<cstdint>
 
 #include "point2d.h"
 
 
 namespace OctData { class Series; }
+namespace CppFW   { class Callback; }
+class QFile;
+class SloInterpolationOperator;
+class QString;
+class QIODevice;
 
 class SloBScanDistanceMap
 {
 public:
+	typedef uint16_t IndexType;
+	constexpr static const IndexType invalidIndex = std::numeric_limits<IndexType>::max();
+
 	class InfoBScanDist
 	{
 	public:
-		double      distance = std::numeric_limits<double>::infinity();
-		std::size_t bscan    = std::numeric_limits<std::size_t>::max();
-		std::size_t ascan    = std::numeric_limits<std::size_t>::max();
+		InfoBScanDist() = default;
+		InfoBScanDist(float distance, IndexType bscan, IndexType ascan) : distance(distance), bscan(bscan), ascan(ascan) {}
+
+		float     distance = std::numeric_limits<float>::infinity();
+		IndexType bscan    = invalidIndex;
+		IndexType ascan    = invalidIndex;
 	};
-	class PixelInfo
+
+	// nearest and second nearest b-scan of every slo pixel, stored as one plane per value
+	class PreCalcDataMatrix
 	{
+		AlignedMatrix<float>     distance1;
+		AlignedMatrix<float>     distance2;
+		AlignedMatrix<IndexType> bscan1;
+		AlignedMatrix<IndexType> bscan2;
+		AlignedMatrix<IndexType> ascan1;
+		AlignedMatrix<IndexType> ascan2;
+		AlignedMatrix<uint64_t>  init;                              // bit x%64 of word x/64
 	public:
-		InfoBScanDist bscan1;
-		InfoBScanDist bscan2;
-		bool init = false;
-	};
+		PreCalcDataMatrix(std::size_t sizeX, std::size_t sizeY);
+		// read only view on the planes written by writeData, data has to be 64 byte aligned and outlive the matrix
+		PreCalcDataMatrix(std::size_t sizeX, std::size_t sizeY, const uint8_t* data);
+
+		std::size_t getSizeX()                                const { return distance1.getSizeX(); }
+		std::size_t getSizeY()                                const { return distance1.getSizeY(); }
+
+		const float*     getDistance1Line(std::size_t y)      const { return distance1.scanLine(y); }
+		const float*     getDistance2Line(std::size_t y)      const { return distance2.scanLine(y); }
+		const IndexType* getBScan1Line   (std::size_t y)      const { return bscan1   .scanLine(y); }
+		const IndexType* getBScan2Line   (std::size_t y)      const { return bscan2   .scanLine(y); }
+		const IndexType* getAScan1Line   (std::size_t y)      const { return ascan1   .scanLine(y); }
+		const IndexType* getAScan2Line   (std::size_t y)      const { return ascan2   .scanLine(y); }
+		const uint64_t*  getInitLine     (std::size_t y)      const { return init     .scanLine(y); }
+
+		static bool isInit(const uint64_t* initLine, std::size_t x) { return ((initLine[x/64] >> (x%64)) & 1) != 0; }
+		bool isInit(std::size_t x, std::size_t y)             const { return isInit(getInitLine(y), x); }
 
-	typedef Matrix<PixelInfo> PreCalcDataMatrix;
+		InfoBScanDist getBScan1(std::size_t x, std::size_t y) const { return InfoBScanDist(distance1(x, y), bscan1(x, y), ascan1(x, y)); }
+		InfoBScanDist getBScan2(std::size_t x, std::size_t y) const { return InfoBScanDist(distance2(x, y), bscan2(x, y), ascan2(x, y)); }
+
+		// insert info if it is one of the two nearest b-scans, for equal distances the later info wins the second place
+		void updateValue(std::size_t x, std::size_t y, const InfoBScanDist& info);
+
+		bool writeData(QIODevice& device) const;
+
+		static std::size_t calcMemorySize(std::size_t sizeX, std::size_t sizeY);
+		std::size_t memorySize()                              const { return calcMemorySize(getSizeX(), getSizeY()); }
+	};
 
 
 	SloBScanDistanceMap();
 	~SloBScanDistanceMap();
 
-	void createData(const OctData::Series* series);
+	// the map is empty when the callback breaks the calculation
+	void createData(const OctData::Series* series, CppFW::Callback* callback = nullptr);
+
+	// hash of everything createData depends on: slo size, b-scan positions and convex hull in slo pixel
+	static uint64_t calcGeometryHash(const OctData::Series& series);
 
+	// cache file with the map, mapFile uses the file read only without copying the data
+	bool writeFile(const QString& filename, uint64_t geometryHash) const;
+	bool mapFile  (const QString& filename, uint64_t geometryHash);
 
 	const PreCalcDataMatrix* getDataMatrix() const { return preCalcDataMatrix; }
+	const SloInterpolationOperator* getInterpolationOperator() const { return interpolationOperator; }
+	std::size_t memorySize() const;
 
 private:
 	PreCalcDataMatrix* preCalcDataMatrix = nullptr;
+	SloInterpolationOperator* interpolationOperator = nullptr;
+	std::unique_ptr<QFile> mappedFile;
+
+	void createInterpolationOperator();
 
 };
 
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "slointerpolationoperator.h"
+
+#include<algorithm>
+#include<atomic>
+
+
+SloInterpolationOperator::SloInterpolationOperator(const SloBScanDistanceMap::PreCalcDataMatrix& distMatrix)
+: generation(nextGeneration())
+, index1 (distMatrix.getSizeX(), distMatrix.getSizeY())
+, index2 (distMatrix.getSizeX(), distMatrix.getSizeY())
+, weight1(distMatrix.getSizeX(), distMatrix.getSizeY(), 1.f)
+{
+	const std::size_t sizeX = distMatrix.getSizeX();
+	const std::size_t sizeY = distMatrix.getSizeY();
+
+	// a-scans per b-scan, from the largest a-scan index in the map
+	std::vector<std::size_t> numAScans;
+	auto addAScan = [&numAScans](SloBScanDistanceMap::IndexType bscan, SloBScanDistanceMap::IndexType ascan)
+	{
+		if(bscan == SloBScanDistanceMap::invalidIndex || ascan == SloBScanDistanceMap::invalidIndex)
+			return;
+		if(bscan >= numAScans.size())
+			numAScans.resize(bscan + 1u, 0);
+		numAScans[bscan] = std::max(numAScans[bscan], ascan + std::size_t(1));
+	};
+
+	for(std::size_t y = 0; y < sizeY; ++y)
+	{
+		const SloBScanDistanceMap::IndexType* bscan1Line = distMatrix.getBScan1Line(y);
+		const SloBScanDistanceMap::IndexType* bscan2Line = distMatrix.getBScan2Line(y);
+		const SloBScanDistanceMap::IndexType* ascan1Line = distMatrix.getAScan1Line(y);
+		const SloBScanDistanceMap::IndexType* ascan2Line = distMatrix.getAScan2Line(y);
+		for(std::size_t x = 0; x < sizeX; ++x)
+		{
+			addAScan(bscan1Line[x], ascan1Line[x]);
+			addAScan(bscan2Line[x], ascan2Line[x]);
+		}
+	}
+
+	ascanOffsets.resize(numAScans.size() + 1, 0);
+	for(std::size_t bscan = 0; bscan < numAScans.size(); ++bscan)
+		ascanOffsets[bscan+1] = ascanOffsets[bscan] + numAScans[bscan];
+
+	const IndexType noAScanIndex = static_cast<IndexType>(getNoAScanIndex());
+
+	parallelFor(sizeY, [&](std::size_t y)
+	{
+		const uint64_t*                       initLine      = distMatrix.getInitLine     (y);
+		const float*                          distance1Line = distMatrix.getDistance1Line(y);
+		const float*                          distance2Line = distMatrix.getDistance2Line(y);
+		const SloBScanDistanceMap::IndexType* bscan1Line    = distMatrix.getBScan1Line   (y);
+		const SloBScanDistanceMap::IndexType* bscan2Line    = distMatrix.getBScan2Line   (y);
+		const SloBScanDistanceMap::IndexType* ascan1Line    = distMatrix.getAScan1Line   (y);
+		const SloBScanDistanceMap::IndexType* ascan2Line    = distMatrix.getAScan2Line   (y);
+
+		IndexType* index1Line  = index1 .scanLine(y);
+		IndexType* index2Line  = index2 .scanLine(y);
+		float*     weight1Line = weight1.scanLine(y);
+
+		for(std::size_t x = 0; x < sizeX; ++x)
+		{
+			index1Line[x] = noAScanIndex;
+			index2Line[x] = noAScanIndex;
+
+			if(!SloBScanDistanceMap::PreCalcDataMatrix::isInit(initLine, x) || bscan1Line[x] == SloBScanDistanceMap::invalidIndex)
+				continue;
+
+			index1Line[x] = static_cast<IndexType>(getValueIndex(bscan1Line[x], ascan1Line[x]));
+
+			const double distance1 = distance1Line[x];
+			const double distance2 = distance2Line[x];
+			const double l = distance1 + distance2;
+			if(bscan2Line[x] == SloBScanDistanceMap::invalidIndex || distance1 == 0 || l == 0)
+				continue;
+
+			index2Line [x] = static_cast<IndexType>(getValueIndex(bscan2Line[x], ascan2Line[x]));
+			weight1Line[x] = static_cast<float>(distance2/l);
+		}
+	});
+
+	createPixelRuns(distMatrix);
+}
+
+
+void SloInterpolationOperator::createPixelRuns(const SloBScanDistanceMap::PreCalcDataMatrix& distMatrix)
+{
+	const std::size_t sizeX = getSizeX();
+	const std::size_t sizeY = getSizeY();
+	const IndexType noAScanIndex = static_cast<IndexType>(getNoAScanIndex());
+
+	std::vector<std::vector<PixelRun>> bscanRuns(getNumBScans());
+	auto addPixel = [&bscanRuns](std::size_t bscan, std::size_t x, std::size_t y)
+	{
+		std::vector<PixelRun>& runs = bscanRuns[bscan];
+		if(!runs.empty() && runs.back().y == y && runs.back().xEnd == x)
+			++runs.back().xEnd;
+		else
+			runs.push_back(PixelRun{static_cast<uint32_t>(y), static_cast<uint32_t>(x), static_cast<uint32_t>(x + 1)});
+	};
+
+	for(std::size_t y = 0; y < sizeY; ++y)
+	{
+		const SloBScanDistanceMap::IndexType* bscan1Line = distMatrix.getBScan1Line(y);
+		const SloBScanDistanceMap::IndexType* bscan2Line = distMatrix.getBScan2Line(y);
+		const IndexType* index1Line = index1.scanLine(y);
+		const IndexType* index2Line = index2.scanLine(y);
+
+		for(std::size_t x = 0; x < sizeX; ++x)
+		{
+			if(index1Line[x] != noAScanIndex) addPixel(bscan1Line[x], x, y);
+			if(index2Line[x] != noAScanIndex) addPixel(bscan2Line[x], x, y);
+		}
+	}
+
+	pixelRunOffsets.assign(bscanRuns.size() + 1, 0);
+	for(std::size_t bscan = 0; bscan < bscanRuns.size(); ++bscan)
+		pixelRunOffsets[bscan+1] = pixelRunOffsets[bscan] + bscanRuns[bscan].size();
+
+	pixelRuns.reserve(pixelRunOffsets.back());
+	for(const std::vector<PixelRun>& runs : bscanRuns)
+		pixelRuns.insert(pixelRuns.end(), runs.begin(), runs.end());
+}
+
+
+std::size_t SloInterpolationOperator::nextGeneration()
+{
+	static std::atomic<std::size_t> counter(0); // the operators are created in the distance map threads
+	return ++counter;
+}
+
+
+std::size_t SloInterpolationOperator::memorySize() const
+{
+	return index1.memorySize() + index2.memorySize() + weight1.memorySize()
+	     + ascanOffsets.size()*sizeof(std::size_t)
+	     + pixelRuns.size()*sizeof(PixelRun) + pixelRunOffsets.size()*sizeof(std::size_t);
+}
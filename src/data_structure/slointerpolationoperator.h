@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include<vector>
+#include<limits>
+#include<cstdint>
+
+#include<data_structure/alignedmatrix.h>
+#include<data_structure/slobscandistancemap.h>
+#include<helper/parallelfor.h>
+
+
+/**
+ * the slo distance map as sparse interpolation operator: every slo pixel refers to the two nearest a-scans
+ * by their index in a flat vector of per a-scan values and the weight of the nearest a-scan
+ * the value vectors have getValueCount() entries, the a-scans of all b-scans in b-scan order
+ * followed by the value for pixels without a-scan, so the kernels run without branches
+ * the pixel runs of a b-scan are the pixels which refer to one of its a-scans, for updates after b-scan changes
+ */
+class SloInterpolationOperator
+{
+public:
+	typedef uint32_t IndexType;
+
+	struct PixelRun
+	{
+		uint32_t y;
+		uint32_t xBegin;
+		uint32_t xEnd;
+	};
+
+	explicit SloInterpolationOperator(const SloBScanDistanceMap::PreCalcDataMatrix& distMatrix);
+
+	// unique for every created operator, an address of a deleted operator can be reused
+	std::size_t getGeneration()                               const { return generation; }
+
+	std::size_t getSizeX()                                    const { return index1.getSizeX(); }
+	std::size_t getSizeY()                                    const { return index1.getSizeY(); }
+
+	std::size_t getValueCount()                               const { return ascanOffsets.back() + 1; }
+	std::size_t getNumBScans()                                const { return ascanOffsets.size() - 1; }
+	// a-scans of the b-scan which are used by the map, the value vector holds no further a-scans of it
+	std::size_t getNumAScans(std::size_t bscan)               const { return ascanOffsets[bscan+1] - ascanOffsets[bscan]; }
+	std::size_t getValueIndex(std::size_t bscan, std::size_t ascan) const { return ascanOffsets[bscan] + ascan; }
+	std::size_t getNoAScanIndex()                             const { return ascanOffsets.back(); }
+
+	const PixelRun* getPixelRunsBegin(std::size_t bscan)      const { return pixelRuns.data() + pixelRunOffsets[bscan  ]; }
+	const PixelRun* getPixelRunsEnd  (std::size_t bscan)      const { return pixelRuns.data() + pixelRunOffsets[bscan+1]; }
+
+	/**
+	 * dest[x] = value of the nearest a-scan of pixel (x, y) for x in [xBegin, xEnd)
+	 */
+	template<typename T>
+	void gatherNearest(const T* values, std::size_t y, std::size_t xBegin, std::size_t xEnd, T* dest) const
+	{
+		const IndexType* const index1Line = index1.scanLine(y);
+		for(std::size_t x = xBegin; x < xEnd; ++x)
+			dest[x] = values[index1Line[x]];
+	}
+
+	/**
+	 * dest[x] = distance weighted mix of the two nearest a-scans of pixel (x, y) for x in [xBegin, xEnd)
+	 * a NaN value of the second a-scan uses the nearest a-scan only, a NaN of the nearest a-scan gives NaN
+	 */
+	void interpolate(const float* values, std::size_t y, std::size_t xBegin, std::size_t xEnd, float* dest) const
+	{
+		const IndexType* const index1Line  = index1 .scanLine(y);
+		const IndexType* const index2Line  = index2 .scanLine(y);
+		const float*     const weight1Line = weight1.scanLine(y);
+		for(std::size_t x = xBegin; x < xEnd; ++x)
+		{
+			const float v1 = values[index1Line[x]];
+			const float v2 = values[index2Line[x]];
+			const float w1 = weight1Line[x];
+			dest[x] = (v2 == v2) ? v1*w1 + v2*(1.f - w1) : v1; // v2 == v2 is false for NaN
+		}
+	}
+
+	/**
+	 * the kernels for all pixels, rowPtr(y) gives the destination row y
+	 */
+	template<typename T, typename RowPtr>
+	void gatherNearest(const T* values, RowPtr rowPtr) const
+	{
+		parallelFor(getSizeY(), [&](std::size_t y) { gatherNearest(values, y, 0, getSizeX(), rowPtr(y)); });
+	}
+
+	template<typename RowPtr>
+	void interpolate(const float* values, RowPtr rowPtr) const
+	{
+		parallelFor(getSizeY(), [&](std::size_t y) { interpolate(values, y, 0, getSizeX(), rowPtr(y)); });
+	}
+
+	std::size_t memorySize() const;
+
+private:
+	const std::size_t generation;
+
+	AlignedMatrix<IndexType> index1;
+	AlignedMatrix<IndexType> index2;
+	AlignedMatrix<float>     weight1;
+
+	std::vector<std::size_t> ascanOffsets;    // value index of the first a-scan of every b-scan, the total number of a-scans at the end
+
+	std::vector<PixelRun>    pixelRuns;       // grouped by b-scan, row by row
+	std::vector<std::size_t> pixelRunOffsets; // pixel runs of b-scan i: [pixelRunOffsets[i], pixelRunOffsets[i+1])
+
+	void createPixelRuns(const SloBScanDistanceMap::PreCalcDataMatrix& distMatrix);
+	static std::size_t nextGeneration();
+};
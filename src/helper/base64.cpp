@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "base64.h"
+
+#include <cstdint>
+
+
+namespace
+{
+	const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	struct DecodeTable
+	{
+		std::int8_t values[256];
+		DecodeTable()
+		{
+			for(std::int8_t& v : values)
+				v = -1;
+			for(int i = 0; i < 64; ++i)
+				values[static_cast<std::uint8_t>(alphabet[i])] = static_cast<std::int8_t>(i);
+		}
+	};
+}
+
+
+namespace Base64
+{
+	void encode(const char* data, std::size_t size, std::string& out)
+	{
+		const std::uint8_t* in = reinterpret_cast<const std::uint8_t*>(data);
+		out.reserve(out.size() + (size+2)/3*4);
+
+		std::size_t i = 0;
+		for(; i+2 < size; i += 3)
+		{
+			const std::uint32_t v = (static_cast<std::uint32_t>(in[i]) << 16) | (static_cast<std::uint32_t>(in[i+1]) << 8) | in[i+2];
+			out.push_back(alphabet[(v >> 18) & 0x3f]);
+			out.push_back(alphabet[(v >> 12) & 0x3f]);
+			out.push_back(alphabet[(v >>  6) & 0x3f]);
+			out.push_back(alphabet[ v        & 0x3f]);
+		}
+
+		const std::size_t rest = size - i;
+		if(rest > 0)
+		{
+			std::uint32_t v = static_cast<std::uint32_t>(in[i]) << 16;
+			if(rest == 2)
+				v |= static_cast<std::uint32_t>(in[i+1]) << 8;
+			out.push_back(alphabet[(v >> 18) & 0x3f]);
+			out.push_back(alphabet[(v >> 12) & 0x3f]);
+			out.push_back(rest == 2 ? alphabet[(v >> 6) & 0x3f] : '=');
+			out.push_back('=');
+		}
+	}
+
+	bool decode(const char* text, std::size_t size, std::string& out)
+	{
+		static const DecodeTable table;
+
+		if(size % 4 != 0)
+			return false;
+
+		std::size_t padding = 0;
+		if(size > 0 && text[size-1] == '=') ++padding;
+		if(size > 1 && text[size-2] == '=') ++padding;
+
+		out.reserve(out.size() + size/4*3);
+		for(std::size_t i = 0; i < size; i += 4)
+		{
+			std::uint32_t v = 0;
+			const bool lastBlock = i+4 == size;
+			for(std::size_t j = 0; j < 4; ++j)
+			{
+				const char c = text[i+j];
+				std::int8_t d;
+				if(lastBlock && c == '=' && j >= 4 - padding)
+					d = 0;
+				else
+				{
+					d = table.values[static_cast<std::uint8_t>(c)];
+					if(d < 0)
+						return false;
+				}
+				v = (v << 6) | static_cast<std::uint32_t>(d);
+			}
+
+			out.push_back(static_cast<char>(v >> 16));
+			if(!lastBlock || padding < 2)
+				out.push_back(static_cast<char>(v >> 8));
+			if(!lastBlock || padding < 1)
+				out.push_back(static_cast<char>(v));
+		}
+		return true;
+	}
+}
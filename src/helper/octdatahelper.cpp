@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "octdatahelper.h"
+
+#include <octdata/datastruct/oct.h>
+#include <octdata/datastruct/series.h>
+#include <octdata/datastruct/bscan.h>
+#include <octdata/datastruct/sloimage.h>
+
+#include <opencv2/core/core.hpp>
+
+
+namespace
+{
+	std::size_t matSize(const cv::Mat& mat)
+	{
+		return mat.total()*mat.elemSize();
+	}
+}
+
+
+std::size_t OctDataHelper::memorySize(const OctData::OCT& oct)
+{
+	std::size_t size = 0;
+	for(const OctData::OCT::SubstructurePair& patientPair : oct)
+	{
+		for(const OctData::Patient::SubstructurePair& studyPair : *patientPair.second)
+		{
+			for(const OctData::Study::SubstructurePair& seriesPair : *studyPair.second)
+			{
+				const OctData::Series* series = seriesPair.second;
+				size += matSize(series->getSloImage().getImage());
+
+				for(const OctData::BScan* bscan : series->getBScans())
+				{
+					if(!bscan)
+						continue;
+					size += matSize(bscan->getImage());
+					size += matSize(bscan->getRawImage());
+				}
+			}
+		}
+	}
+	return size;
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include <opencv2/core/core.hpp>
+
+
+namespace ParallelForDetail
+{
+	template<typename Func>
+	class LoopBody : public cv::ParallelLoopBody
+	{
+		Func& func;
+	public:
+		explicit LoopBody(Func& func) : func(func)                  {}
+
+		void operator()(const cv::Range& range) const override
+		{
+			for(int i = range.start; i < range.end; ++i)
+				func(static_cast<std::size_t>(i));
+		}
+	};
+}
+
+// calls func(i) for i in [0, count) on the OpenCV thread pool
+template<typename Func>
+void parallelFor(std::size_t count, Func func)
+{
+	ParallelForDetail::LoopBody<Func> body(func);
+	cv::parallel_for_(cv::Range(0, static_cast<int>(count)), body);
+}
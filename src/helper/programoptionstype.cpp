@@ -167,3 +167,24 @@ void OptionDouble::setDescriptions(const QString& shortDesc, const QString& long
 	inputDialogAction->setText(shortDesc);
 	inputDialogAction->setToolTip(longDesc);
 }
+
+
+void OptionString::showInputDialog()
+{
+	QInputDialog dialog;
+	dialog.setInputMode(QInputDialog::TextInput);
+	dialog.setTextValue(value);
+	dialog.setWindowTitle(getDescriptionShort());
+	dialog.setLabelText(getDescription() + "\n" + tr("Default value: %1").arg(defaultValue));
+
+	if(dialog.exec() == QDialog::Accepted && dialog.textValue() != value)
+		setValue(dialog.textValue());
+}
+
+void OptionString::setDescriptions(const QString& shortDesc, const QString& longDesc)
+{
+	Option::setDescriptions(shortDesc, longDesc);
+
+	inputDialogAction->setText(shortDesc);
+	inputDialogAction->setToolTip(longDesc);
+}
@@ -225,7 +225,16 @@ class OptionString : public Option
 	QString value;
 	QString defaultValue;
 
-	OptionString(const QString& v, const QString& name, const QString& optClass) : Option(name, optClass), value(v), defaultValue(v) {}
+	QAction* inputDialogAction;
+
+	OptionString(const QString& v, const QString& name, const QString& optClass)
+	: Option(name, optClass)
+	, value(v)
+	, defaultValue(v)
+	, inputDialogAction(new QAction(this))
+	{
+		connect(inputDialogAction, &QAction::triggered, this, &OptionString::showInputDialog);
+	}
 	OptionString(const OptionString&) = delete;
 	OptionString& operator=(const OptionString&) = delete;
 public:
@@ -233,13 +242,18 @@ public:
 
 	const QString& getValue()   const                               { return value; }
 	const QString& operator()() const                               { return value; }
+
+	QAction* getInputDialogAction()                                 { return inputDialogAction; }
 	
 	virtual QVariant getVariant()                          override { return QVariant(value); }
 	virtual void setVariant(const QVariant& variant)       override { value = variant.toString(); }
 
+	virtual void setDescriptions(const QString& shortDesc, const QString& longDesc) override;
+
 	virtual bool isDefault() const                         override { return value == defaultValue; }
 public slots:
 	void setValue(const QString& v)                                 { value = v; emit(valueChanged(v)); }
+	void showInputDialog();
 
 signals:
 	void valueChanged(const QString& v);
@@ -55,6 +55,23 @@ namespace PTreeHelper
 		return node;
 	}
 
+	const boost::property_tree::ptree* findNodeWithId(const boost::property_tree::ptree& tree, const std::string& searchNode, int id)
+	{
+		for(const std::pair<const std::string, bpt::ptree>& treePair : tree)
+		{
+			if(treePair.first != searchNode)
+				continue;
+
+			boost::optional<const bpt::ptree&> child = treePair.second.get_child_optional("ID");
+			if(child)
+			{
+				if(id == (*child).get_value<int>(id+1))
+					return &treePair.second;
+			}
+		}
+		return nullptr;
+	}
+
 	void putNotEmpty(boost::property_tree::ptree& tree, const std::string& path, const std::string& value)
 	{
 		if(!value.empty())
@@ -63,6 +80,27 @@ namespace PTreeHelper
 
 
 
+	namespace
+	{
+		std::size_t stringHeapSize(const std::string& str)
+		{
+			return str.capacity() >= sizeof(std::string) ? str.capacity() + 1 : 0; // short strings are stored in the object
+		}
+	}
+
+	std::size_t memorySize(const boost::property_tree::ptree& tree)
+	{
+		// node of the multi index container: value, links of the sequenced and the ordered index
+		constexpr std::size_t nodeSize = sizeof(bpt::ptree::value_type) + 5*sizeof(void*);
+
+		std::size_t size = stringHeapSize(tree.data());
+		for(const std::pair<const std::string, bpt::ptree>& child : tree)
+			size += nodeSize + stringHeapSize(child.first) + memorySize(child.second);
+		return size;
+	}
+
+
+
 	boost::property_tree::ptree& NodeCreator::getNode()
 	{
 		if(!node)
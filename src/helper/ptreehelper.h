@@ -27,9 +27,12 @@ namespace PTreeHelper
 {
 	boost::property_tree::ptree& get_put      (boost::property_tree::ptree& tree, const std::string& path);
 	boost::property_tree::ptree& getNodeWithId(boost::property_tree::ptree& tree, const std::string& searchNode, int id);
+	const boost::property_tree::ptree* findNodeWithId(const boost::property_tree::ptree& tree, const std::string& searchNode, int id); // nullptr if not exists
 
 	void putNotEmpty(boost::property_tree::ptree& tree, const std::string& path, const std::string& value);
 
+	std::size_t memorySize(const boost::property_tree::ptree& tree); // estimation of the heap memory
+
 
 	class NodeCreator
 	{
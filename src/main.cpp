@@ -35,6 +35,7 @@
 #include <buildconstants.h>
 
 #include "prepareprogrammoptions.h"
+#include "batchprocessing.h"
 
 
 bool loadMarkerTranslatorFile(QTranslator& translator, const QString& dir)
@@ -67,6 +68,9 @@ int main(int argc, char **argv)
 {
 // 	QGuiApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
 
+	if(BatchProcessing::isBatchCall(argc, argv))
+		return BatchProcessing::exec(argc, argv);
+
 	QApplication app(argc, argv);
 	QCoreApplication::setApplicationName("OCT-Marker");
 	QCoreApplication::setApplicationVersion(BuildConstants::gitSha1);
@@ -91,6 +95,8 @@ int main(int argc, char **argv)
 		{"license"                 , QCoreApplication::translate("main", "Show license text")},
 		{"i-want-stupid-spline-gui", QCoreApplication::translate("main", "Show stupid spline gui")},
 		{"dont-save-options"       , QCoreApplication::translate("main", "dont save options set in application")},
+		{"batch"                   , QCoreApplication::translate("main", "run an operation without gui (convert, export-layerseg, thicknessmap), see --batch <operation> --help"),
+		                             QCoreApplication::translate("main", "operation")},
 		{{"i", "ini-file"},
 		    QCoreApplication::translate("main", "use config from ini file"),
 		    QCoreApplication::translate("main", "ini file")},
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "distancemapdiskcache.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QStandardPaths>
+
+#include <data_structure/slobscandistancemap.h>
+#include <data_structure/programoptions.h>
+
+
+DistanceMapDiskCache::DistanceMapDiskCache()
+: directory(getDirectory())
+, maxSize  (static_cast<qint64>(ProgramOptions::distanceMapCacheMaxSize())*1024*1024)
+{
+}
+
+
+SloBScanDistanceMap* DistanceMapDiskCache::createDistanceMap(const OctData::Series* series, CppFW::Callback* callback) const
+{
+	SloBScanDistanceMap* distanceMap = new SloBScanDistanceMap();
+
+	if(!series || maxSize == 0)
+	{
+		distanceMap->createData(series, callback);
+		return distanceMap;
+	}
+
+	const uint64_t geometryHash = SloBScanDistanceMap::calcGeometryHash(*series);
+	const QString  filename     = QDir(directory).filePath(QString("%1.dmap").arg(static_cast<qulonglong>(geometryHash), 16, 16, QChar('0')));
+
+	if(distanceMap->mapFile(filename, geometryHash))
+	{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+		QFile file(filename); // mark as recently used for shrink
+		if(file.open(QIODevice::ReadWrite))
+			file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+#endif
+		return distanceMap;
+	}
+
+	distanceMap->createData(series, callback);
+	if(QDir().mkpath(directory) && distanceMap->writeFile(filename, geometryHash))
+		shrink();
+
+	return distanceMap;
+}
+
+
+QString DistanceMapDiskCache::getDirectory()
+{
+	const QString& optionDirectory = ProgramOptions::distanceMapCacheDirectory();
+	if(!optionDirectory.isEmpty())
+		return optionDirectory;
+
+	return QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("distancemaps");
+}
+
+
+void DistanceMapDiskCache::shrink() const
+{
+	const QFileInfoList files = QDir(directory).entryInfoList(QStringList("*.dmap"), QDir::Files, QDir::Time); // last used first
+
+	qint64 size = 0;
+	for(const QFileInfo& info : files)
+	{
+		size += info.size();
+		if(size > maxSize)
+			QFile::remove(info.absoluteFilePath());
+	}
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <QString>
+
+
+namespace OctData
+{
+	class Series;
+}
+
+namespace CppFW
+{
+	class Callback;
+}
+
+class SloBScanDistanceMap;
+
+
+/**
+ * slo distance maps of the opened series on disk, in ProgramOptions::distanceMapCacheDirectory
+ * the files are named by the geometry hash of the series and used read only by a memory mapping,
+ * the least recently used files are removed to hold ProgramOptions::distanceMapCacheMaxSize
+ * the options are read in the constructor, createDistanceMap can run in a worker thread
+ */
+class DistanceMapDiskCache
+{
+	const QString directory;
+	const qint64  maxSize;
+
+	void shrink() const;
+public:
+	DistanceMapDiskCache();
+
+	/**
+	 * map the cached distance map of the series or calculate it and store it in the cache
+	 * a calculation breaked by the callback is not stored
+	 */
+	SloBScanDistanceMap* createDistanceMap(const OctData::Series* series, CppFW::Callback* callback = nullptr) const;
+
+	static QString getDirectory();
+};
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "octdatacache.h"
+
+#include <QFileInfo>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <octdata/datastruct/oct.h>
+
+#include <data_structure/slobscandistancemap.h>
+#include <helper/octdatahelper.h>
+#include <helper/ptreehelper.h>
+
+#include "octmarkerio.h"
+
+
+OctDataCacheEntry::OctDataCacheEntry()
+: markers (new boost::property_tree::ptree)
+, markerIO(new OctMarkerIO(markers))
+{
+}
+
+OctDataCacheEntry::~OctDataCacheEntry()
+{
+	delete distanceMap;
+	delete markerIO;
+	delete markers;
+	delete oct;
+}
+
+
+OctDataCache::~OctDataCache()
+{
+	clear();
+}
+
+
+void OctDataCache::insert(const QString& filename, OctDataCacheEntry* entry, std::size_t maxMemory)
+{
+	QFileInfo fileInfo(filename);
+	entry->canonicalPath = fileInfo.canonicalFilePath();
+	entry->fileTime      = fileInfo.lastModified();
+
+	entry->memory = 0;
+	if(entry->oct)
+		entry->memory += OctDataHelper::memorySize(*entry->oct);
+	if(entry->distanceMap)
+		entry->memory += entry->distanceMap->memorySize();
+	if(entry->markersValid)
+		entry->memory += PTreeHelper::memorySize(*entry->markers);
+
+	if(entry->canonicalPath.isEmpty() || entry->memory > maxMemory)
+	{
+		delete entry;
+		return;
+	}
+
+	entries.push_front(entry);
+	shrink(maxMemory);
+}
+
+
+OctDataCacheEntry* OctDataCache::take(const QString& filename)
+{
+	QFileInfo fileInfo(filename);
+	const QString canonicalPath = fileInfo.canonicalFilePath();
+
+	for(std::list<OctDataCacheEntry*>::iterator it = entries.begin(); it != entries.end(); ++it)
+	{
+		OctDataCacheEntry* entry = *it;
+		if(entry->canonicalPath != canonicalPath)
+			continue;
+
+		entries.erase(it);
+		if(entry->fileTime != fileInfo.lastModified())
+		{
+			delete entry;
+			return nullptr;
+		}
+		return entry;
+	}
+	return nullptr;
+}
+
+
+void OctDataCache::updateMarkersStamp(const QString& filename, const std::string& markersFilename)
+{
+	const QString canonicalPath = QFileInfo(filename).canonicalFilePath();
+
+	for(OctDataCacheEntry* entry : entries)
+	{
+		if(entry->canonicalPath != canonicalPath)
+			continue;
+
+		if(entry->markersValid && entry->markerIO->getLoadedDefaultFilename() == markersFilename)
+			entry->markersStamp = OctMarkerIO::getFileStamp(markersFilename);
+		return;
+	}
+}
+
+
+void OctDataCache::installMarkers(const QString& filename, boost::property_tree::ptree& markers, std::size_t maxMemory)
+{
+	const QString canonicalPath = QFileInfo(filename).canonicalFilePath();
+
+	for(OctDataCacheEntry* entry : entries)
+	{
+		if(entry->canonicalPath != canonicalPath)
+			continue;
+
+		if(!entry->markersValid)
+		{
+			entry->markers->swap(markers);
+			entry->markersStamp = OctMarkerIO::getFileStamp(entry->markerIO->getLoadedDefaultFilename());
+			entry->markersValid = true;
+			entry->memory += PTreeHelper::memorySize(*entry->markers);
+			shrink(maxMemory);
+		}
+		return;
+	}
+}
+
+
+void OctDataCache::shrink(std::size_t maxMemory)
+{
+	std::size_t memory = 0;
+	for(const OctDataCacheEntry* entry : entries)
+		memory += entry->memory;
+
+	while(memory > maxMemory && !entries.empty())
+	{
+		OctDataCacheEntry* entry = entries.back();
+		memory -= entry->memory;
+		entries.pop_back();
+		delete entry;
+	}
+}
+
+
+void OctDataCache::clear()
+{
+	for(OctDataCacheEntry* entry : entries)
+		delete entry;
+	entries.clear();
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <list>
+#include <string>
+
+#include <QString>
+#include <QDateTime>
+
+#include <boost/property_tree/ptree_fwd.hpp>
+
+#include "octmarkerio.h"
+
+
+namespace OctData
+{
+	class OCT;
+	class Patient;
+	class Study;
+	class Series;
+}
+
+class SloBScanDistanceMap;
+
+
+/**
+ * oct data with the markers and derived data of a file in the OctDataCache
+ */
+class OctDataCacheEntry
+{
+public:
+	OctDataCacheEntry();
+	~OctDataCacheEntry();
+
+	OctDataCacheEntry(const OctDataCacheEntry&)            = delete;
+	OctDataCacheEntry& operator=(const OctDataCacheEntry&) = delete;
+
+	OctData::OCT*           oct     = nullptr;
+	const OctData::Patient* patient = nullptr;
+	const OctData::Study*   study   = nullptr;
+	const OctData::Series*  series  = nullptr;
+
+	boost::property_tree::ptree* markers  = nullptr;
+	OctMarkerIO*                 markerIO = nullptr;
+	OctMarkerFileStamp           markersStamp;
+	bool                         markersValid = false; // false when the markers had unsaved changes
+
+	SloBScanDistanceMap*         distanceMap = nullptr; // of series
+
+	std::size_t memory = 0;
+
+	QString   canonicalPath;
+	QDateTime fileTime;
+};
+
+
+/**
+ * LRU cache for the recently opened oct files
+ * the key is the canonical path and the modification time of the oct file
+ */
+class OctDataCache
+{
+public:
+	OctDataCache() = default;
+	~OctDataCache();
+
+	OctDataCache(const OctDataCache&)            = delete;
+	OctDataCache& operator=(const OctDataCache&) = delete;
+
+	/**
+	 * takes the ownership of entry, the oldest entries are removed to hold the memory limit
+	 */
+	void insert(const QString& filename, OctDataCacheEntry* entry, std::size_t maxMemory);
+
+	/**
+	 * remove the entry from the cache and return it, nullptr when the file is not in the cache or the file was changed
+	 */
+	OctDataCacheEntry* take(const QString& filename);
+
+	/**
+	 * the markers of the entry were written to markersFilename, the cached markers are still valid
+	 */
+	void updateMarkersStamp(const QString& filename, const std::string& markersFilename);
+
+	/**
+	 * the markers of the entry were in a save, when the entry was inserted, they are moved into the entry after the write
+	 */
+	void installMarkers(const QString& filename, boost::property_tree::ptree& markers, std::size_t maxMemory);
+
+	void clear();
+	void shrink(std::size_t maxMemory);
+
+private:
+	std::list<OctDataCacheEntry*> entries; // front is the last used entry
+};
@@ -19,6 +19,7 @@
 #include "octdatamanager.h"
 
 #include <iostream>
+#include <algorithm>
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
@@ -33,6 +34,7 @@
 #include<QApplication>
 #include<QFileInfo>
 #include<QDir>
+#include<QTimer>
 
 #include <octdata/datastruct/series.h>
 #include <octdata/datastruct/bscan.h>
@@ -47,23 +49,145 @@
 
 #include "octmarkerio.h"
 #include "octmarkermanager.h"
+#include "octdataprefetcher.h"
+#include "octdatacache.h"
+#include "octmarkersaver.h"
 
 namespace bpt = boost::property_tree;
 namespace bfs = boost::filesystem;
 
 
+namespace
+{
+	// find the series with the same internal ids as in the old oct object
+	bool findEquivalentSeries(const OctData::OCT& oct
+	                        , const OctData::Patient* patientReq, const OctData::Study* studyReq, const OctData::Series* seriesReq
+	                        , const OctData::Patient*& patient  , const OctData::Study*& study  , const OctData::Series*& series)
+	{
+		if(!patientReq || !studyReq || !seriesReq)
+			return false;
+
+		for(const OctData::OCT::SubstructurePair& patientPair : oct)
+		{
+			const OctData::Patient* pat = patientPair.second;
+			if(pat->getInternalId() != patientReq->getInternalId())
+				continue;
+
+			for(const OctData::Patient::SubstructurePair& studyPair : *pat)
+			{
+				const OctData::Study* s = studyPair.second;
+				if(s->getInternalId() != studyReq->getInternalId())
+					continue;
+
+				for(const OctData::Study::SubstructurePair& seriesPair : *s)
+				{
+					if(seriesPair.second->getInternalId() == seriesReq->getInternalId())
+					{
+						patient = pat;
+						study   = s;
+						series  = seriesPair.second;
+						return true;
+					}
+				}
+			}
+		}
+		return false;
+	}
+
+
+	// copy on write: the save thread reads the lent tree at the same time, only const access
+	void copyLentSeries(const bpt::ptree& saveTree, bpt::ptree& studyNode, int patientId, int studyId, int seriesId)
+	{
+		const bpt::ptree* node = OctMarkerIO::getSaveTreeMarkers(saveTree);
+		if(node)
+			node = PTreeHelper::findNodeWithId(*node, "Patient", patientId);
+		if(node)
+			node = PTreeHelper::findNodeWithId(*node, "Study"  , studyId);
+		if(node)
+			node = PTreeHelper::findNodeWithId(*node, "Series" , seriesId);
+		if(node)
+			studyNode.add_child("Series", *node);
+	}
+
+	// moves the series (and the uid nodes) used while the markers were lent into the returned markers
+	void mergeSeriesNodes(bpt::ptree& src, bpt::ptree& dest, const char* const* levels)
+	{
+		for(std::pair<const std::string, bpt::ptree>& child : src)
+		{
+			if(child.first == "ID")
+				continue;
+
+			if(child.first != *levels)
+			{
+				dest.put_child(bpt::ptree::path_type(child.first, '\0'), child.second);
+				continue;
+			}
+
+			boost::optional<int> id = child.second.get_optional<int>("ID");
+			if(!id)
+				continue;
+
+			bpt::ptree& destNode = PTreeHelper::getNodeWithId(dest, child.first, *id);
+			if(levels[1])
+				mergeSeriesNodes(child.second, destNode, levels + 1);
+			else
+				destNode.swap(child.second);
+		}
+	}
+
+	void mergeSeriesNodes(bpt::ptree& src, bpt::ptree& dest)
+	{
+		static const char* const levels[] = { "Patient", "Study", "Series", nullptr };
+		mergeSeriesNodes(src, dest, levels);
+	}
+}
+
+
 
 OctDataManager::OctDataManager()
 : markerstree(new bpt::ptree)
 , markerIO(new OctMarkerIO(markerstree))
+, prefetcher(new OctDataPrefetcher)
+, octCache  (new OctDataCache)
+, markerSaver  (new OctMarkerSaver)
+, autoSaveTimer(new QTimer(this))
 {
-	connect(this, &OctDataManager::seriesChanged, this, &OctDataManager::clearSeriesCache);
+	connect(this       , &OctDataManager::seriesChanged       , this, &OctDataManager::clearSeriesCache);
+	connect(prefetcher , &OctDataPrefetcher::prefetchFinished, this, &OctDataManager::prefetchFinished);
+	connect(markerSaver, &OctMarkerSaver::markersSaved        , this, &OctDataManager::markersSaved);
+	connect(markerSaver, &OctMarkerSaver::saveFailed          , this, &OctDataManager::markersSaveFailed);
+	connect(markerSaver, &OctMarkerSaver::saveFailed          , this, &OctDataManager::markersNotSaved);
+	connect(markerSaver, &OctMarkerSaver::lentTreeWritten     , this, &OctDataManager::lentMarkersWritten);
+	connect(autoSaveTimer, &QTimer::timeout                   , this, &OctDataManager::autoSaveTimeout);
+
+	connect(&ProgramOptions::octCacheMaxMemory       , &OptionInt ::valueChanged, this, &OctDataManager::shrinkOctCache);
+	connect(&ProgramOptions::autoSaveOctMarkers      , &OptionBool::valueChanged, this, &OctDataManager::updateAutoSaveTimer);
+	connect(&ProgramOptions::autoSaveMarkersInterval , &OptionInt ::valueChanged, this, &OctDataManager::updateAutoSaveTimer);
+	updateAutoSaveTimer();
 }
 
 
 
 OctDataManager::~OctDataManager()
 {
+	if(loadThread)
+	{
+		loadThread->breakLoad();
+		loadThread->wait();
+		delete loadThread;
+	}
+	stopDistanceMapThread();
+	releaseLentMarkers();
+	for(CacheLentMarkers& pending : cacheLentMarkers)
+	{
+		markerSaver->releaseTree(pending.saveTree);
+		delete pending.usedSeries;
+	}
+	delete markerSaver; // writes the pending marker files
+	delete prefetcher;
+	delete octCache;
+	delete octData4Loading;
+	delete octData4Preview;
 	delete octData;
 	delete markerstree;
 	delete markerIO;
@@ -81,10 +205,237 @@ void OctDataManager::triggerSaveMarkersDefault()
 {
 	if(!actFilename.isEmpty())
 	{
+		reclaimLentMarkers();
 		saveMarkerState(actSeries);
-		markerIO->saveDefaultMarker(actFilename.toStdString());
-		OctMarkerManager::getInstance().resetChangedSinceLastSaveState();
+
+		OctMarkerFileformat format;
+		const std::string markersFilename = markerIO->getDefaultSaveFilename(actFilename.toStdString(), format);
+
+		// no copy for the save thread, the markers are moved into the save tree and merged back after the write
+		lentMarkers = new bpt::ptree;
+		markerIO->lendSaveTree(*lentMarkers);
+		markerSaver->saveLent(actFilename, markersFilename, format, OctMarkerIO::isCompressionEnabled(), lentMarkers);
+		resetMarkerJournal(false);
+
+		OctMarkerManager::getInstance().resetChangedForPendingSave(); // confirmed in markersSaved
+	}
+}
+
+void OctDataManager::triggerJournalSaveMarkersDefault()
+{
+	if(actFilename.isEmpty())
+		return;
+
+	saveMarkerState(actSeries);
+
+	const std::size_t maxJournalSize = static_cast<std::size_t>(ProgramOptions::markerJournalMaxSize())*1024*1024;
+	if(fullMarkerSaveRequired || journalSize > maxJournalSize)
+	{
+		triggerSaveMarkersDefault(); // compacts the journal into the marker file
+		return;
+	}
+
+	std::string records;
+	for(const OctMarkerJournal::NodePath& path : journalNodes)
+		OctMarkerJournal::addRecord(records, *markerstree, path);
+	journalNodes.clear();
+
+	if(!records.empty())
+	{
+		OctMarkerFileformat format;
+		const std::string markersFilename = markerIO->getDefaultSaveFilename(actFilename.toStdString(), format);
+
+		journalSize += records.size();
+		markerSaver->appendJournal(actFilename, markersFilename, std::move(records));
+	}
+
+	OctMarkerManager& markerManager = OctMarkerManager::getInstance();
+	markerManager.resetChangedForPendingSave(); // confirmed in markersSaved
+	if(!markerSaver->isSavingFile(actFilename))
+		markerManager.confirmPendingSave(); // nothing to write
+}
+
+
+void OctDataManager::reclaimLentMarkers()
+{
+	// the wait emits the save signals, an error dialog can reclaim or lend the markers meanwhile
+	while(lentMarkers && markerSaver->isSavingTree(lentMarkers))
+		markerSaver->waitForTree(lentMarkers); // merged in lentMarkersWritten
+
+	if(lentMarkers)
+		mergeLentMarkers();
+}
+
+
+void OctDataManager::mergeLentMarkers()
+{
+	bpt::ptree* saveTree = lentMarkers;
+	lentMarkers = nullptr;
+
+	bpt::ptree usedSeries;
+	usedSeries.swap(*markerstree);
+	markerIO->returnSaveTree(*saveTree);
+	delete saveTree;
+
+	mergeSeriesNodes(usedSeries, *markerstree);
+}
+
+
+void OctDataManager::lentMarkersWritten(const bpt::ptree* saveTree, bool success)
+{
+	if(!saveTree)
+		return;
+
+	if(saveTree == lentMarkers)
+	{
+		mergeLentMarkers();
+		return;
+	}
+
+	for(std::vector<CacheLentMarkers>::iterator it = cacheLentMarkers.begin(); it != cacheLentMarkers.end(); ++it)
+	{
+		if(it->saveTree != saveTree)
+			continue;
+
+		const CacheLentMarkers pending = *it;
+		cacheLentMarkers.erase(it);
+
+		bpt::ptree* markers = OctMarkerIO::getSaveTreeMarkers(*pending.saveTree);
+		if(success && markers)
+		{
+			mergeSeriesNodes(*pending.usedSeries, *markers);
+			octCache->installMarkers(pending.octFilename, *markers, octCacheMaxMemory());
+		}
+		delete pending.saveTree;
+		delete pending.usedSeries;
+		return;
+	}
+}
+
+
+void OctDataManager::releaseLentMarkers()
+{
+	if(!lentMarkers)
+		return;
+
+	markerSaver->releaseTree(lentMarkers); // deleted after the write
+	lentMarkers = nullptr;
+}
+
+
+void OctDataManager::resetMarkerJournal(bool fullSaveRequired)
+{
+	journalNodes.clear();
+	journalSize            = 0;
+	fullMarkerSaveRequired = fullSaveRequired;
+}
+
+
+void OctDataManager::markerBScansSaved(const OctData::Series* series, const std::string& markerId, const std::vector<std::size_t>& bscans, bool versionChanged)
+{
+	if(!octData || !series || (bscans.empty() && !versionChanged))
+		return;
+
+	const OctData::Patient* patient;
+	const OctData::Study  * study;
+	octData->findSeries(series, patient, study);
+	if(!patient || !study)
+		return;
+
+	OctMarkerJournal::NodePath modulePath;
+	modulePath.emplace_back("Patient", patient->getInternalId());
+	modulePath.emplace_back("Study"  , study  ->getInternalId());
+	modulePath.emplace_back("Series" , series ->getInternalId());
+	modulePath.emplace_back(markerId);
+
+	auto addJournalNode = [this](OctMarkerJournal::NodePath&& path)
+	{
+		if(std::find(journalNodes.begin(), journalNodes.end(), path) == journalNodes.end())
+			journalNodes.push_back(std::move(path));
+	};
+
+	if(versionChanged)
+	{
+		OctMarkerJournal::NodePath path = modulePath;
+		path.emplace_back("Version");
+		addJournalNode(std::move(path));
 	}
+
+	for(std::size_t bscan : bscans)
+	{
+		OctMarkerJournal::NodePath path = modulePath;
+		path.emplace_back("BScan", static_cast<int>(bscan));
+		addJournalNode(std::move(path));
+	}
+}
+
+
+bool OctDataManager::waitForMarkerSaves(QString& error)
+{
+	QStringList errors;
+	bool result = markerSaver->waitForAll(errors);
+	error = errors.join('\n');
+	return result;
+}
+
+
+void OctDataManager::markersSaved(const QString& octFilename, const QString& markersFilename)
+{
+	octCache->updateMarkersStamp(octFilename, markersFilename.toStdString());
+
+	// a later save of the file can still fail
+	if(octFilename == actFilename && !markerSaver->isSavingFile(actFilename))
+		OctMarkerManager::getInstance().confirmPendingSave();
+}
+
+
+void OctDataManager::markersNotSaved(const QString& markersFilename)
+{
+	// the marker file or the journal is in an unknown state, the next autosave must not append to the journal
+	if(markersFilename.toStdString() == markerIO->getLoadedDefaultFilename())
+		fullMarkerSaveRequired = true;
+}
+
+
+void OctDataManager::updateAutoSaveTimer()
+{
+	const int interval = ProgramOptions::autoSaveMarkersInterval();
+	if(ProgramOptions::autoSaveOctMarkers() && interval > 0)
+		autoSaveTimer->start(interval*60*1000);
+	else
+		autoSaveTimer->stop();
+}
+
+
+void OctDataManager::autoSaveTimeout()
+{
+	if(!ProgramOptions::autoSaveOctMarkers() || loadThread || !prefetchWaitFile.isEmpty())
+		return;
+
+	if(markerSaver->isSaving())
+		return; // next timeout, the markers are merged back meanwhile
+
+	if(!OctMarkerManager::getInstance().hasChangedSinceLastSave())
+		return;
+
+	if(ProgramOptions::autoSaveMarkersJournal())
+		triggerJournalSaveMarkersDefault();
+	else
+		triggerSaveMarkersDefault();
+}
+
+
+void OctDataManager::fillFileReadOptions(OctData::FileReadOptions& octOptions)
+{
+	QFileInfo octmarkerPath(QApplication::applicationFilePath());
+
+	octOptions.e2eGray             = static_cast<OctData::FileReadOptions::E2eGrayTransform>(ProgramOptions::e2eGrayTransform());
+	octOptions.registerBScanns     = ProgramOptions::registerBScans();
+	octOptions.fillEmptyPixelWhite = ProgramOptions::fillEmptyPixelWhite();
+	octOptions.holdRawData         = ProgramOptions::holdOCTRawData();
+	octOptions.readBScans          = ProgramOptions::readBScans();
+	octOptions.rotateSlo           = ProgramOptions::loadRotateSlo();
+	octOptions.libPath             = octmarkerPath.dir().absolutePath().toStdString(); // QApplication::applicationFilePath().toStdString();
 }
 
 
@@ -98,18 +449,21 @@ void OctDataManagerThread::run()
 
 	try
 	{
-		QFileInfo octmarkerPath(QApplication::applicationFilePath());
-
 		OctData::FileReadOptions octOptions;
-		octOptions.e2eGray             = static_cast<OctData::FileReadOptions::E2eGrayTransform>(ProgramOptions::e2eGrayTransform());
-		octOptions.registerBScanns     = ProgramOptions::registerBScans();
-		octOptions.fillEmptyPixelWhite = ProgramOptions::fillEmptyPixelWhite();
-		octOptions.holdRawData         = ProgramOptions::holdOCTRawData();
-		octOptions.readBScans          = ProgramOptions::readBScans();
-		octOptions.rotateSlo           = ProgramOptions::loadRotateSlo();
-		octOptions.libPath             = octmarkerPath.dir().absolutePath().toStdString(); // QApplication::applicationFilePath().toStdString();
+		OctDataManager::fillFileReadOptions(octOptions);
+
+		if(preview)
+		{
+			OctData::FileReadOptions previewOptions = octOptions;
+			previewOptions.readBScans = false;
+
+			*preview = OctData::OctFileRead::openFile(filename.toStdString(), previewOptions, nullptr);
+			if(preview->size() > 0)
+				emit(previewLoaded());
+		}
 
-		*oct = OctData::OctFileRead::openFile(filename.toStdString(), octOptions, this);
+		if(!breakLoading)
+			*oct = OctData::OctFileRead::openFile(filename.toStdString(), octOptions, this);
 	}
 	catch(boost::exception& e)
 	{
@@ -162,7 +516,7 @@ bool OctDataManager::checkAndAskSaveBeforContinue()
 
 void OctDataManager::openFile(const QString& filename)
 {
-	if(loadThread)
+	if((loadThread && !isLoadingPreviewBScans()) || !prefetchWaitFile.isEmpty())
 		return;
 
 	if(!ProgramOptions::autoSaveOctMarkers())
@@ -171,17 +525,24 @@ void OctDataManager::openFile(const QString& filename)
 			return;
 	}
 
+	stopLoadThread(); // only the b-scans of the shown preview are loading, the user can switch to the next file
+
 	loadFileSignal(true);
 	try
 	{
 		saveMarkersDefault();
 
-		octData4Loading = new OctData::OCT;
+		markerSaver->waitForFile(filename); // a pending save of the file must be written before its markers are used again
+
+		if(openCachedFile(filename))
+			return;
 
-		loadThread = new OctDataManagerThread(*this, filename, octData4Loading);
-		connect(loadThread, &OctDataManagerThread::stepCalulated, this, &OctDataManager::loadOctDataThreadProgress);
-		connect(loadThread, &OctDataManagerThread::finished     , this, &OctDataManager::loadOctDataThreadFinish  );
-		loadThread->start();
+		if(prefetcher->isReady(filename))
+			openPrefetchedFile(filename);
+		else if(prefetcher->prioritize(filename))
+			prefetchWaitFile = filename;
+		else
+			startLoadThread(filename);
 	}
 	catch(...)
 	{
@@ -191,94 +552,397 @@ void OctDataManager::openFile(const QString& filename)
 }
 
 
-void OctDataManager::loadOctDataThreadFinish()
+void OctDataManager::startLoadThread(const QString& filename)
+{
+	prefetcher->setPaused(true);
+
+	octData4Loading = new OctData::OCT;
+	if(ProgramOptions::progressiveLoading() && ProgramOptions::readBScans())
+		octData4Preview = new OctData::OCT;
+
+	loadThread = new OctDataManagerThread(*this, filename, octData4Loading, octData4Preview);
+	connect(loadThread, &OctDataManagerThread::stepCalulated, this, &OctDataManager::loadOctDataThreadProgress);
+	connect(loadThread, &OctDataManagerThread::previewLoaded, this, &OctDataManager::loadOctDataThreadPreview );
+	connect(loadThread, &OctDataManagerThread::finished     , this, &OctDataManager::loadOctDataThreadFinish  );
+	loadThread->start();
+}
+
+
+void OctDataManager::openPrefetchedFile(const QString& filename)
+{
+	OctDataPrefetchThread* prefetchThread = prefetcher->take(filename);
+	if(!prefetchThread)
+	{
+		startLoadThread(filename);
+		return;
+	}
+
+	bpt::ptree* markers = nullptr;
+	if(prefetchThread->markersUpToDate())
+		markers = prefetchThread->releaseMarkers();
+
+	installLoadedOct(prefetchThread->releaseOct(), filename, false, markers, &prefetchThread->getMarkerIO());
+
+	delete markers;
+	delete prefetchThread;
+
+	loadFileSignal(false);
+}
+
+
+bool OctDataManager::openCachedFile(const QString& filename)
 {
+	OctDataCacheEntry* entry = octCache->take(filename);
+	if(!entry)
+		return false;
+
+	bpt::ptree* markers = nullptr;
+	if(entry->markersValid && entry->markerIO->isDefaultMarkerUnchanged(filename.toStdString(), entry->markersStamp))
+		markers = entry->markers;
+
+	installLoadedOct(entry->oct, filename, false, markers, entry->markerIO, entry->series, entry->distanceMap);
+	entry->oct         = nullptr;
+	entry->distanceMap = nullptr;
+	delete entry;
+
 	loadFileSignal(false);
+	return true;
+}
 
-	if(loadThread->success())
+
+std::size_t OctDataManager::octCacheMaxMemory()
+{
+	return static_cast<std::size_t>(ProgramOptions::octCacheMaxMemory())*1024*1024;
+}
+
+
+OctDataCacheEntry* OctDataManager::createCacheEntry()
+{
+	if(!octData || previewShown || actFilename.isEmpty() || octCacheMaxMemory() == 0)
+		return nullptr;
+
+	OctDataCacheEntry* entry = new OctDataCacheEntry;
+	// a failed save of the snapshot changes the marker file stamp, the markers are reloaded from the file
+	if(OctMarkerManager::getInstance().hasChangedSinceSaveSnapshot())
+		return entry;
+
+	entry->markerIO->copyDefaultMarkerInfo(*markerIO);
+	if(lentMarkers)
 	{
-		if(octData4Loading->size() == 0)
+		CacheLentMarkers pending;
+		pending.octFilename = actFilename;
+		pending.saveTree    = lentMarkers;
+		pending.usedSeries  = new bpt::ptree;
+		pending.usedSeries->swap(*markerstree);
+		cacheLentMarkers.push_back(pending);
+		lentMarkers = nullptr; // installed in lentMarkersWritten
+		return entry;
+	}
+
+	entry->markers->swap(*markerstree);
+	entry->markersStamp = OctMarkerIO::getFileStamp(markerIO->getLoadedDefaultFilename());
+	entry->markersValid = true;
+	return entry;
+}
+
+
+void OctDataManager::moveActualOctToCache(OctDataCacheEntry* entry)
+{
+	stopDistanceMapThread(); // uses the series of octData
+
+	SloBScanDistanceMap* distanceMap = nullptr;
+	if(distanceMapSeries == actSeries)
+		distanceMap = seriesSLODistanceMap;
+	else
+		delete seriesSLODistanceMap;
+	seriesSLODistanceMap = nullptr;
+	distanceMapSeries    = nullptr;
+
+	if(!entry)
+	{
+		delete distanceMap;
+		delete octData;
+		octData = nullptr;
+		return;
+	}
+
+	entry->oct         = octData;
+	entry->patient     = actPatient;
+	entry->study       = actStudy;
+	entry->series      = actSeries;
+	entry->distanceMap = distanceMap;
+
+	octData = nullptr;
+	octCache->insert(actFilename, entry, octCacheMaxMemory());
+}
+
+
+void OctDataManager::shrinkOctCache()
+{
+	octCache->shrink(octCacheMaxMemory());
+}
+
+
+void OctDataManager::prefetchFinished(const QString& filename)
+{
+	if(prefetchWaitFile != filename)
+		return;
+
+	prefetchWaitFile.clear();
+	if(prefetcher->isReady(filename))
+		openPrefetchedFile(filename);
+	else
+		startLoadThread(filename); // prefetch failed, load it again to show the errors
+}
+
+
+void OctDataManager::setPrefetchFiles(const QStringList& files)
+{
+	prefetcher->setPrefetchFiles(files);
+}
+
+
+void OctDataManager::installLoadedOct(OctData::OCT* oct, const QString& filename, bool preview
+                                    , bpt::ptree* loadedMarkers, const OctMarkerIO* loadedMarkerIO
+                                    , const OctData::Series* series, SloBScanDistanceMap* distanceMap)
+{
+	OctDataCacheEntry* cacheEntry = createCacheEntry(); // the marker tree and marker info of the actual file are moved into the entry
+	releaseLentMarkers();
+
+	QString error;
+	try
+	{
+		markerstree->clear();
+		if(loadedMarkers && loadedMarkerIO)
 		{
-			QMessageBox msgBox;
-			msgBox.setText("OctDataManager::openFile: oct->size() == 0");
-			msgBox.setIcon(QMessageBox::Critical);
-			msgBox.exec();
+			markerstree->swap(*loadedMarkers);
+			markerIO->copyDefaultMarkerInfo(*loadedMarkerIO);
 		}
 		else
+			markerIO->loadDefaultMarker(filename.toStdString());
+
+		// the journal needs a marker file as base, new records after a damaged record would be lost
+		resetMarkerJournal(OctMarkerIO::getFileTime(markerIO->getLoadedDefaultFilename()) == 0 || !markerIO->isJournalComplete());
+	}
+	catch(boost::exception& e)
+	{
+		error = QString::fromStdString(boost::diagnostic_information(e));
+	}
+	catch(std::exception& e)
+	{
+		error = QString::fromStdString(e.what());
+	}
+	catch(const char* str)
+	{
+		error = str;
+	}
+	catch(...)
+	{
+		error = QString("Unknow error in file %1 line %2").arg(__FILE__).arg(__LINE__);
+	}
+	if(!error.isEmpty())
+	{
+		QMessageBox msgBox;
+		msgBox.setText("OctDataManager::openFile: markerload failed: " + error);
+		msgBox.setIcon(QMessageBox::Critical);
+		msgBox.exec();
+	}
+
+
+	moveActualOctToCache(cacheEntry);
+	previewShown = preview;
+
+	actFilename = filename;
+	octData = oct;
+
+	const OctData::Patient* patient = nullptr;
+	const OctData::Study  * study   = nullptr;
+	if(series)
+		octData->findSeries(series, patient, study);
+
+	if(patient && study)
+	{
+		actPatient = patient;
+		actStudy   = study;
+		actSeries  = series;
+
+		seriesSLODistanceMap = distanceMap;
+		distanceMapSeries    = distanceMap?actSeries:nullptr;
+	}
+	else
+	{
+		delete distanceMap;
+
+		actPatient = octData->begin()->second;
+		actStudy   = nullptr;
+		actSeries  = nullptr;
+		if(actPatient->size() > 0)
 		{
-			QString error;
-			try
-			{
-				markerstree->clear();
-				markerIO->loadDefaultMarker(loadThread->getFilename().toStdString());
-			}
-			catch(boost::exception& e)
-			{
-				error = QString::fromStdString(boost::diagnostic_information(e));
-			}
-			catch(std::exception& e)
+			actStudy = actPatient->begin()->second;
+
+			if(actStudy->size() > 0)
 			{
-				error = QString::fromStdString(e.what());
+				actSeries = actStudy->begin()->second;
 			}
-			catch(const char* str)
+		}
+	}
+
+	emit(octFileChanged());
+	emit(octFileChanged(actFilename));
+	emit(octFileChanged(octData   ));
+	emit(patientChanged(actPatient));
+	emit(studyChanged  (actStudy  ));
+	emit(seriesChanged (actSeries ));
+	if(distanceMapSeries == actSeries && seriesSLODistanceMap)
+		emit(distanceMapReady(seriesSLODistanceMap)); // restored from the oct cache, no thread is started
+	OctMarkerManager::getInstance().resetChangedSinceLastSaveState();
+}
+
+
+void OctDataManager::replacePreviewOct(OctData::OCT* oct)
+{
+	saveMarkerState(actSeries); // markers (e.g. slo markers) set on the preview, the marker file is not read again
+
+	const OctData::Patient* patient = nullptr;
+	const OctData::Study  * study   = nullptr;
+	const OctData::Series * series  = nullptr;
+	if(!findEquivalentSeries(*oct, actPatient, actStudy, actSeries, patient, study, series))
+	{
+		patient = oct->begin()->second;
+		if(patient->size() > 0)
+		{
+			study = patient->begin()->second;
+			if(study->size() > 0)
+				series = study->begin()->second;
+		}
+	}
+
+	OctData::OCT* previewOct = octData;
+
+	previewShown = false;
+	octData    = oct;
+	actPatient = patient;
+	actStudy   = study;
+	actSeries  = series;
+
+	emit(octFileChanged(octData   ));
+	emit(patientChanged(actPatient));
+	emit(studyChanged  (actStudy  ));
+	emit(seriesChanged (actSeries ));
+
+	delete previewOct; // after the signals, the receivers hold pointers into the preview until they got the new series
+}
+
+
+void OctDataManager::loadOctDataThreadPreview()
+{
+	if(!loadThread || !octData4Preview)
+		return;
+
+	OctData::OCT* preview = octData4Preview;
+	octData4Preview = nullptr;
+
+	installLoadedOct(preview, loadThread->getFilename(), true);
+
+	loadFileSignal(false);
+	loadBScansSignal(true);
+}
+
+
+void OctDataManager::loadOctDataThreadFinish()
+{
+	if(!loadThread)
+		return;
+
+	if(isLoadingPreviewBScans())
+	{
+		if(loadThread->success() && !loadThread->loadBreaked() && octData4Loading->size() > 0)
+		{
+			replacePreviewOct(octData4Loading);
+			octData4Loading = nullptr;
+		}
+		else if(loadThread->hasLoadError())
+		{
+			QMessageBox msgBox;
+			msgBox.setText(tr("error loading b-scans from file: %1").arg(loadThread->getFilename()) + '\n' + loadThread->getError());
+			msgBox.setIcon(QMessageBox::Critical);
+			msgBox.exec();
+		}
+
+		loadBScansSignal(false);
+	}
+	else
+	{
+		loadFileSignal(false);
+
+		if(loadThread->success())
+		{
+			if(octData4Loading->size() == 0)
 			{
-				error = str;
+				QMessageBox msgBox;
+				msgBox.setText("OctDataManager::openFile: oct->size() == 0");
+				msgBox.setIcon(QMessageBox::Critical);
+				msgBox.exec();
 			}
-			catch(...)
+			else
 			{
-				error = QString("Unknow error in file %1 line %2").arg(__FILE__).arg(__LINE__);
+				installLoadedOct(octData4Loading, loadThread->getFilename(), false);
+				octData4Loading = nullptr;
 			}
-			if(!error.isEmpty())
+		}
+		else
+		{
+			if(loadThread->hasLoadError())
 			{
+				const QString& loadError = loadThread->getError();
 				QMessageBox msgBox;
-				msgBox.setText("OctDataManager::openFile: markerload failed: " + error);
+				msgBox.setText(tr("error open file: %1").arg(loadThread->getFilename()) + '\n' + loadError);
 				msgBox.setIcon(QMessageBox::Critical);
 				msgBox.exec();
 			}
+		}
+	}
 
+	delete loadThread;
+	delete octData4Loading;
+	delete octData4Preview;
+	loadThread      = nullptr;
+	octData4Loading = nullptr;
+	octData4Preview = nullptr;
 
-			actFilename = loadThread->getFilename();
+	prefetcher->setPaused(false);
+}
 
-			delete octData;
-			octData = octData4Loading;
-			octData4Loading = nullptr;
 
-			actPatient = octData->begin()->second;
-			if(actPatient->size() > 0)
-			{
-				actStudy = actPatient->begin()->second;
+void OctDataManager::stopLoadThread()
+{
+	if(!loadThread)
+		return;
 
-				if(actStudy->size() > 0)
-				{
-					actSeries = actStudy->begin()->second;
-				}
-			}
+	const bool previewBScans = isLoadingPreviewBScans();
 
-			emit(octFileChanged());
-			emit(octFileChanged(actFilename));
-			emit(octFileChanged(octData   ));
-			emit(patientChanged(actPatient));
-			emit(studyChanged  (actStudy  ));
-			emit(seriesChanged (actSeries ));
-			OctMarkerManager::getInstance().resetChangedSinceLastSaveState();
-		}
-	}
-	else
-	{
-		if(loadThread->hasLoadError())
-		{
-			const QString& loadError = loadThread->getError();
-			QMessageBox msgBox;
-			msgBox.setText(tr("error open file: %1").arg(loadThread->getFilename()) + '\n' + loadError);
-			msgBox.setIcon(QMessageBox::Critical);
-			msgBox.exec();
-		}
-	}
+	loadThread->disconnect(this);
+	loadThread->breakLoad();
+	loadThread->wait();
 
 	delete loadThread;
 	delete octData4Loading;
+	delete octData4Preview;
 	loadThread      = nullptr;
 	octData4Loading = nullptr;
+	octData4Preview = nullptr;
+
+	prefetcher->setPaused(false);
+
+	if(previewBScans)
+		loadBScansSignal(false); // the preview stays without b-scans
+}
+
+
+bool OctDataManager::isLoadingPreviewBScans() const
+{
+	// the preview of the running thread is shown (moved from octData4Preview to octData)
+	return loadThread && loadThread->hasPreview() && !octData4Preview;
 }
 
 
@@ -327,6 +991,8 @@ boost::property_tree::ptree* OctDataManager::getMarkerTreeSeries(const OctData::
 
 	bpt::ptree& patNode    = PTreeHelper::getNodeWithId(*markerstree, "Patient", patient->getInternalId());
 	bpt::ptree& studyNode  = PTreeHelper::getNodeWithId(patNode     , "Study"  , study  ->getInternalId());
+	if(lentMarkers && !PTreeHelper::findNodeWithId(studyNode, "Series", series->getInternalId()))
+		copyLentSeries(*lentMarkers, studyNode, patient->getInternalId(), study->getInternalId(), series->getInternalId());
 	bpt::ptree& seriesNode = PTreeHelper::getNodeWithId(studyNode   , "Series" , series ->getInternalId());
 
 
@@ -341,8 +1007,11 @@ boost::property_tree::ptree* OctDataManager::getMarkerTreeSeries(const OctData::
 
 bool OctDataManager::loadMarkers(QString filename, OctMarkerFileformat format)
 {
+	markerSaver->waitForFile(filename);
+	releaseLentMarkers();
 	markerstree->clear();
 	markerIO->loadMarkers(filename.toStdString(), format);
+	resetMarkerJournal(true);
 	emit(loadMarkerStateAll());
 	OctMarkerManager::getInstance().resetChangedSinceLastSaveState();
 	return true;
@@ -350,6 +1019,8 @@ bool OctDataManager::loadMarkers(QString filename, OctMarkerFileformat format)
 
 void OctDataManager::saveMarkers(QString filename, OctMarkerFileformat format)
 {
+	markerSaver->waitForFile(filename);
+	reclaimLentMarkers();
 	saveMarkerState(actSeries);
 	markerIO->saveMarkers(filename.toStdString(), format);
 	OctMarkerManager::getInstance().resetChangedSinceLastSaveState();
@@ -368,19 +1039,74 @@ void OctDataManager::saveOctScan(QString filename)
 
 const SloBScanDistanceMap* OctDataManager::getSeriesSLODistanceMap() const
 {
-	if(!seriesSLODistanceMap)
-	{
-		seriesSLODistanceMap = new SloBScanDistanceMap();
-		seriesSLODistanceMap->createData(actSeries);
-	}
+	if(distanceMapSeries != actSeries)
+		return nullptr;
 
 	return seriesSLODistanceMap;
 }
 
 void OctDataManager::clearSeriesCache()
 {
+	if(distanceMapSeries == actSeries)
+		return; // e.g. restored from the oct cache
+
 	delete seriesSLODistanceMap;
 	seriesSLODistanceMap = nullptr;
+	distanceMapSeries    = nullptr;
+
+	startDistanceMapThread();
+}
+
+void OctDataManager::startDistanceMapThread()
+{
+	if(distanceMapThread && distanceMapThread->getSeries() == actSeries)
+		return;
+
+	stopDistanceMapThread();
+	if(!actSeries)
+		return;
+
+	SloDistanceMapThread* thread = new SloDistanceMapThread(actSeries);
+	const unsigned int threadNumber = ++distanceMapThreadNumber;
+	connect(thread, &SloDistanceMapThread::finished, this, [this, thread, threadNumber]() { distanceMapThreadFinish(thread, threadNumber); });
+	distanceMapThread = thread;
+	distanceMapThread->start(QThread::LowPriority);
+}
+
+void OctDataManager::stopDistanceMapThread()
+{
+	if(!distanceMapThread)
+		return;
+
+	distanceMapThread->disconnect(this);
+	distanceMapThread->breakCalc();
+	distanceMapThread->wait();
+
+	delete distanceMapThread;
+	distanceMapThread = nullptr;
+}
+
+void OctDataManager::distanceMapThreadFinish(SloDistanceMapThread* thread, unsigned int threadNumber)
+{
+	// a queued finished signal of a stopped thread can arrive after a new thread was started
+	if(!distanceMapThread || threadNumber != distanceMapThreadNumber)
+		return;
+
+	distanceMapThread = nullptr;
+	thread->wait();
+
+	if(thread->getSeries() != actSeries)
+	{
+		delete thread;
+		return;
+	}
+
+	delete seriesSLODistanceMap;
+	seriesSLODistanceMap = thread->releaseDistanceMap();
+	distanceMapSeries    = actSeries;
+	delete thread;
+
+	emit(distanceMapReady(seriesSLODistanceMap));
 }
 
 void OctDataManager::abortLoadingOctFile()
@@ -388,3 +1114,30 @@ void OctDataManager::abortLoadingOctFile()
 	if(loadThread)
 		loadThread->breakLoad();
 }
+
+
+SloDistanceMapThread::~SloDistanceMapThread()
+{
+	delete distanceMap;
+}
+
+SloBScanDistanceMap* SloDistanceMapThread::releaseDistanceMap()
+{
+	SloBScanDistanceMap* result = distanceMap;
+	distanceMap = nullptr;
+	return result;
+}
+
+void SloDistanceMapThread::run()
+{
+	try
+	{
+		distanceMap = diskCache.createDistanceMap(series, this);
+	}
+	catch(...)
+	{
+		// the consumers show no slo map
+		delete distanceMap;
+		distanceMap = nullptr;
+	}
+}
@@ -24,18 +24,28 @@
 
 #include <vector>
 #include <string>
+#include <atomic>
 
 
 #include <boost/property_tree/ptree_fwd.hpp>
 
 #include <globaldefinitions.h>
 
+#include "octmarkerjournal.h"
+#include "distancemapdiskcache.h"
+
 #include <oct_cpp_framework/callback.h>
 
 
 class QString;
+class QStringList;
+class QTimer;
 class OctMarkerIO;
+class OctMarkerSaver;
 class SloBScanDistanceMap;
+class OctDataPrefetcher;
+class OctDataCache;
+class OctDataCacheEntry;
 
 namespace OctData
 {
@@ -43,9 +53,11 @@ namespace OctData
 	class Patient;
 	class Study;
 	class Series;
+	class FileReadOptions;
 }
 
 class OctDataManagerThread;
+class SloDistanceMapThread;
 
 class OctDataManager : public QObject
 {
@@ -62,23 +74,42 @@ public:
 	const OctData::Patient* getPatient() const                      { return actPatient ; }
 	const OctData::Study  * getStudy  () const                      { return actStudy   ; }
 	const OctData::Series * getSeries () const                      { return actSeries  ; }
+	bool isPreview() const                                          { return previewShown; }
 	boost::property_tree::ptree* getMarkerTree(const OctData::Series* series)
 	                                                                { return getMarkerTreeSeries(series); }
 	
 	void saveMarkersDefault();
 	bool checkAndAskSaveBeforContinue();
+	bool waitForMarkerSaves(QString& error);
+
+	// reported by the marker modules after saveMarkerState, decides between journal and complete marker file save
+	// versionChanged: the "Version" node of the module was changed, removed or added
+	void markerBScansSaved(const OctData::Series* series, const std::string& markerId, const std::vector<std::size_t>& bscans, bool versionChanged);
+	void markerModuleChanged()                                      { fullMarkerSaveRequired = true; }
+
+	static void fillFileReadOptions(OctData::FileReadOptions& octOptions);
 
 private slots:
 	void loadOctDataThreadProgress(double frac)                     { emit(loadFileProgress(frac)); }
+	void loadOctDataThreadPreview();
 	void loadOctDataThreadFinish();
+	void prefetchFinished(const QString& filename);
 	void clearSeriesCache();
+	void shrinkOctCache();
+	void markersSaved(const QString& octFilename, const QString& markersFilename);
+	void markersNotSaved(const QString& markersFilename);
+	void lentMarkersWritten(const boost::property_tree::ptree* saveTree, bool success);
+	void autoSaveTimeout();
+	void updateAutoSaveTimer();
 
 public slots:
 	void openFile(const QString& filename);
+	void setPrefetchFiles(const QStringList& files);
 	
 	void chooseSeries(const OctData::Series* seriesReq);
 
 
+	// nullptr while the map is calculated in background, distanceMapReady is emitted when it is available
 	const SloBScanDistanceMap* getSeriesSLODistanceMap() const;
 	
 	
@@ -106,26 +137,77 @@ signals:
 
 	void loadFileSignal(bool loading);
 	void loadFileProgress(double frac);
+	void loadBScansSignal(bool loading);
+
+	void markersSaveFailed(const QString& filename, const QString& error);
+
+	void distanceMapReady(const SloBScanDistanceMap*);
 
 
 private:
 	
 	boost::property_tree::ptree* const markerstree = nullptr;
 	OctMarkerIO*                 const markerIO    = nullptr;
+	boost::property_tree::ptree*       lentMarkers = nullptr; // the markers are in a save, markerstree holds the series used since (copy on write)
 
 	OctData::OCT* octData         = nullptr;
 	OctData::OCT* octData4Loading = nullptr; // is nullptr when no file is loading by task
+	OctData::OCT* octData4Preview = nullptr; // slo preview (progressive loading), is nullptr after it was shown
+	bool previewShown = false;               // actual octData is a slo preview without b-scans
 	QString actFilename;
 	
 	const OctData::Patient* actPatient = nullptr;
 	const OctData::Study*   actStudy   = nullptr;
 	const OctData::Series*  actSeries  = nullptr;
 
-	mutable SloBScanDistanceMap* seriesSLODistanceMap = nullptr;
+	SloBScanDistanceMap*   seriesSLODistanceMap = nullptr;
+	const OctData::Series* distanceMapSeries    = nullptr;
 	
-	OctDataManagerThread* loadThread = nullptr;
+	OctDataManagerThread* loadThread        = nullptr;
+	SloDistanceMapThread* distanceMapThread = nullptr;
+	unsigned int          distanceMapThreadNumber = 0; // a queued finished signal of a stopped thread is ignored, the address can be reused
+
+	// markers of a file moved into the cache while they were lent, installed in the cache entry after the write
+	struct CacheLentMarkers
+	{
+		QString                      octFilename;
+		boost::property_tree::ptree* saveTree   = nullptr;
+		boost::property_tree::ptree* usedSeries = nullptr;
+	};
+	std::vector<CacheLentMarkers> cacheLentMarkers;
+
+	OctDataPrefetcher* const prefetcher = nullptr;
+	OctDataCache*      const octCache   = nullptr;
+	OctMarkerSaver*    const markerSaver   = nullptr;
+	QTimer*            const autoSaveTimer = nullptr;
+	QString prefetchWaitFile; // file is opened when the prefetch is finished
+
+	std::vector<OctMarkerJournal::NodePath> journalNodes; // changed nodes, which are not written to the marker file or journal
+	std::size_t journalSize            = 0;
+	bool        fullMarkerSaveRequired = true;
 	
 	OctDataManager();
+
+	void startLoadThread(const QString& filename);
+	void openPrefetchedFile(const QString& filename);
+	bool openCachedFile(const QString& filename);
+	OctDataCacheEntry* createCacheEntry();
+	void moveActualOctToCache(OctDataCacheEntry* entry);
+	static std::size_t octCacheMaxMemory();
+	void installLoadedOct(OctData::OCT* oct, const QString& filename, bool preview
+	                    , boost::property_tree::ptree* loadedMarkers = nullptr, const OctMarkerIO* loadedMarkerIO = nullptr
+	                    , const OctData::Series* series = nullptr, SloBScanDistanceMap* distanceMap = nullptr);
+	void replacePreviewOct(OctData::OCT* oct);
+	void triggerJournalSaveMarkersDefault();
+	void reclaimLentMarkers();
+	void mergeLentMarkers();
+	void releaseLentMarkers();
+	void resetMarkerJournal(bool fullSaveRequired);
+	void stopLoadThread();
+	bool isLoadingPreviewBScans() const;
+	void startDistanceMapThread();
+	void stopDistanceMapThread();
+	void distanceMapThreadFinish(SloDistanceMapThread* thread, unsigned int threadNumber);
 	
 	boost::property_tree::ptree* getMarkerTreeSeries(const OctData::Series* series);
 	boost::property_tree::ptree* getMarkerTreeSeries(const OctData::Patient* pat, const OctData::Study* study, const OctData::Series*  series);
@@ -142,20 +224,24 @@ class OctDataManagerThread : public QThread, public CppFW::Callback
 	bool loadSuccess  = true;
 	bool loadError    = false;
 
-	OctData::OCT* oct = nullptr;
+	OctData::OCT* oct     = nullptr;
+	OctData::OCT* preview = nullptr;
 
 	const QString filename;
 	QString  error;
 
 public:
-	OctDataManagerThread(OctDataManager& dataManager, const QString& filename, OctData::OCT* oct) : octDataManager(dataManager), oct(oct), filename(filename) {}
+	OctDataManagerThread(OctDataManager& dataManager, const QString& filename, OctData::OCT* oct, OctData::OCT* preview = nullptr)
+	: octDataManager(dataManager), oct(oct), preview(preview), filename(filename) {}
 
 	void breakLoad()                                                { breakLoading = true; }
 
 	bool success()                                           const  { return loadSuccess; }
+	bool loadBreaked()                                       const  { return breakLoading; }
 	const QString& getError()                                const  { return error; }
 	const QString& getFilename()                             const  { return filename; }
 	bool hasLoadError()                                      const  { return loadError; }
+	bool hasPreview()                                        const  { return preview != nullptr; }
 
 protected:
 	void run();
@@ -167,5 +253,34 @@ protected:
 	}
 signals:
 	void stepCalulated(double);
+	void previewLoaded();
 };
 
+
+/**
+ * calculate the slo distance map of a series in background
+ */
+class SloDistanceMapThread : public QThread, public CppFW::Callback
+{
+	Q_OBJECT
+
+	const OctData::Series* const series;
+	const DistanceMapDiskCache   diskCache;
+
+	SloBScanDistanceMap* distanceMap = nullptr;
+	std::atomic<bool>    breakCalculation;
+
+public:
+	explicit SloDistanceMapThread(const OctData::Series* series) : series(series), breakCalculation(false) {}
+	~SloDistanceMapThread();
+
+	void breakCalc()                                                { breakCalculation = true; }
+
+	const OctData::Series* getSeries()                       const  { return series; }
+	SloBScanDistanceMap* releaseDistanceMap();
+
+protected:
+	void run() override;
+
+	virtual bool callback(double /*frac*/) override                 { return !breakCalculation; }
+};
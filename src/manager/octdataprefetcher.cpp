@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "octdataprefetcher.h"
+
+#include <algorithm>
+
+#include <QFileInfo>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <octdata/datastruct/oct.h>
+#include <octdata/octfileread.h>
+#include <octdata/filereadoptions.h>
+
+#include <data_structure/programoptions.h>
+#include <helper/octdatahelper.h>
+
+#include "octdatamanager.h"
+#include "octmarkerio.h"
+
+namespace bpt = boost::property_tree;
+
+
+namespace
+{
+	std::size_t maxPrefetchMemory()
+	{
+		return static_cast<std::size_t>(ProgramOptions::prefetchMaxMemory())*1024*1024;
+	}
+}
+
+
+OctDataPrefetchThread::OctDataPrefetchThread(const QString& filename)
+: filename(filename)
+, oct     (new OctData::OCT)
+, markers (new bpt::ptree)
+, markerIO(new OctMarkerIO(markers))
+{
+}
+
+OctDataPrefetchThread::~OctDataPrefetchThread()
+{
+	delete markerIO;
+	delete markers;
+	delete oct;
+}
+
+OctData::OCT* OctDataPrefetchThread::releaseOct()
+{
+	OctData::OCT* result = oct;
+	oct = nullptr;
+	return result;
+}
+
+bpt::ptree* OctDataPrefetchThread::releaseMarkers()
+{
+	bpt::ptree* result = markers;
+	markers = nullptr;
+	return result;
+}
+
+
+bool OctDataPrefetchThread::markersUpToDate() const
+{
+	// the marker file can be saved after the prefetch (e.g. the file was open in the meantime)
+	return markerIO->isDefaultMarkerUnchanged(filename.toStdString(), markersStamp);
+}
+
+
+void OctDataPrefetchThread::run()
+{
+	try
+	{
+		OctData::FileReadOptions octOptions;
+		OctDataManager::fillFileReadOptions(octOptions);
+
+		*oct = OctData::OctFileRead::openFile(filename.toStdString(), octOptions, this);
+		if(breakLoading || oct->size() == 0)
+			return;
+
+		OctMarkerFileformat markersFormat;
+		markersStamp = OctMarkerIO::getFileStamp(OctMarkerIO::getDefaultMarkerFilename(filename.toStdString(), markersFormat));
+		markerIO->loadDefaultMarker(filename.toStdString());
+
+		loadSuccess = true;
+	}
+	catch(...)
+	{
+		// errors are shown when the file is opened without prefetch
+		loadSuccess = false;
+	}
+}
+
+
+
+OctDataPrefetcher::OctDataPrefetcher()
+{
+}
+
+OctDataPrefetcher::~OctDataPrefetcher()
+{
+	for(Entry* entry : entries)
+	{
+		if(entry->thread)
+		{
+			entry->thread->breakLoad();
+			entry->thread->wait();
+			delete entry->thread;
+		}
+		delete entry;
+	}
+}
+
+
+OctDataPrefetcher::Entry* OctDataPrefetcher::findEntry(const QString& filename)
+{
+	for(Entry* entry : entries)
+		if(entry->filename == filename)
+			return entry;
+	return nullptr;
+}
+
+bool OctDataPrefetcher::prioritize(const QString& filename)
+{
+	Entry* entry = findEntry(filename);
+	if(entry && entry->thread && !entry->ready && !entry->failed)
+	{
+		entry->thread->setPriority(QThread::NormalPriority);
+		entry->pinned = true;
+		return true;
+	}
+	return false;
+}
+
+void OctDataPrefetcher::setPaused(bool pause)
+{
+	paused = pause;
+	if(!paused)
+		startNext();
+}
+
+bool OctDataPrefetcher::isReady(const QString& filename)
+{
+	Entry* entry = findEntry(filename);
+	return entry && entry->ready;
+}
+
+std::size_t OctDataPrefetcher::usedMemory() const
+{
+	std::size_t memory = 0;
+	for(const Entry* entry : entries)
+		if(entry->ready)
+			memory += entry->memory;
+	return memory;
+}
+
+
+void OctDataPrefetcher::removeEntry(Entry* entry)
+{
+	entries.erase(std::remove(entries.begin(), entries.end(), entry), entries.end());
+	delete entry;
+}
+
+void OctDataPrefetcher::cancelEntry(Entry* entry)
+{
+	OctDataPrefetchThread* thread = entry->thread;
+	if(thread)
+	{
+		thread->disconnect(this);
+		if(thread->isRunning())
+		{
+			thread->breakLoad();
+			connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+		}
+		else
+			delete thread;
+	}
+
+	const bool    pinned   = entry->pinned;
+	const QString filename = entry->filename;
+	removeEntry(entry);
+
+	if(pinned)
+		emit(prefetchFinished(filename)); // the waiting file open has to load the file itself
+}
+
+
+OctDataPrefetchThread* OctDataPrefetcher::take(const QString& filename)
+{
+	Entry* entry = findEntry(filename);
+	if(!entry || !entry->ready)
+		return nullptr;
+
+	OctDataPrefetchThread* thread = entry->thread;
+	thread->disconnect(this);
+	removeEntry(entry);
+
+	startNext();
+	return thread;
+}
+
+
+void OctDataPrefetcher::setPrefetchFiles(const QStringList& files)
+{
+	// the list position has jumped, cancel the prefetches which are not longer needed
+	std::vector<Entry*> oldEntries = entries;
+	for(Entry* entry : oldEntries)
+		if(!entry->pinned && !files.contains(entry->filename))
+			cancelEntry(entry);
+
+	if(maxPrefetchMemory() == 0)
+		return;
+
+	for(const QString& file : files)
+	{
+		if(findEntry(file))
+			continue;
+
+		Entry* entry = new Entry;
+		entry->filename = file;
+		entries.push_back(entry);
+	}
+
+	// keep the order of the request
+	std::stable_sort(entries.begin(), entries.end(), [&files](const Entry* e1, const Entry* e2) { return files.indexOf(e1->filename) < files.indexOf(e2->filename); });
+
+	startNext();
+}
+
+void OctDataPrefetcher::cancelAll()
+{
+	std::vector<Entry*> oldEntries = entries;
+	for(Entry* entry : oldEntries)
+		cancelEntry(entry);
+}
+
+
+void OctDataPrefetcher::startNext()
+{
+	if(paused)
+		return;
+
+	for(const Entry* entry : entries)
+		if(entry->thread && !entry->ready && !entry->failed)
+			return; // only one prefetch at the same time
+
+	const std::size_t maxMemory = maxPrefetchMemory();
+	for(Entry* entry : entries)
+	{
+		if(entry->thread || entry->failed)
+			continue;
+
+		// the decoded volume is at least as big as the file
+		QFileInfo fileInfo(entry->filename);
+		if(!fileInfo.exists() || usedMemory() + static_cast<std::size_t>(fileInfo.size()) > maxMemory)
+		{
+			entry->failed = true;
+			continue;
+		}
+
+		entry->thread = new OctDataPrefetchThread(entry->filename);
+		connect(entry->thread, &QThread::finished, this, &OctDataPrefetcher::prefetchThreadFinished);
+		entry->thread->start(QThread::LowestPriority);
+		return;
+	}
+}
+
+
+void OctDataPrefetcher::prefetchThreadFinished()
+{
+	OctDataPrefetchThread* thread = qobject_cast<OctDataPrefetchThread*>(sender());
+	if(!thread)
+		return;
+
+	Entry* entry = nullptr;
+	for(Entry* e : entries)
+		if(e->thread == thread)
+			entry = e;
+	if(!entry)
+		return;
+
+	if(thread->success())
+	{
+		entry->memory = OctDataHelper::memorySize(*thread->getOct());
+		if(usedMemory() + entry->memory <= maxPrefetchMemory())
+			entry->ready = true;
+	}
+
+	if(!entry->ready)
+	{
+		entry->failed = true;
+		entry->thread = nullptr;
+		delete thread;
+	}
+
+	entry->pinned = false;
+	emit(prefetchFinished(entry->filename));
+	startNext();
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <QObject>
+#include <QThread>
+#include <QString>
+#include <QStringList>
+
+#include <vector>
+#include <string>
+
+#include <boost/property_tree/ptree_fwd.hpp>
+
+#include <oct_cpp_framework/callback.h>
+
+#include <globaldefinitions.h>
+
+#include "octmarkerio.h"
+
+
+namespace OctData
+{
+	class OCT;
+}
+
+
+/**
+ * decode a oct file and its default marker file in background
+ */
+class OctDataPrefetchThread : public QThread, public CppFW::Callback
+{
+	Q_OBJECT
+
+	bool breakLoading = false;
+	bool loadSuccess  = false;
+
+	const QString filename;
+
+	OctData::OCT*                oct      = nullptr;
+	boost::property_tree::ptree* markers  = nullptr;
+	OctMarkerIO*                 markerIO = nullptr;
+	OctMarkerFileStamp           markersStamp;
+
+public:
+	explicit OctDataPrefetchThread(const QString& filename);
+	virtual ~OctDataPrefetchThread();
+
+	void breakLoad()                                                { breakLoading = true; }
+
+	bool success()                                           const  { return loadSuccess && !breakLoading; }
+	const QString& getFilename()                             const  { return filename; }
+
+	const OctData::OCT* getOct()                             const  { return oct; }
+
+	OctData::OCT*                releaseOct();
+	boost::property_tree::ptree* releaseMarkers();
+	const OctMarkerIO&           getMarkerIO()               const  { return *markerIO; }
+	bool                         markersUpToDate()           const;
+
+protected:
+	void run() override;
+
+	virtual bool callback(double /*frac*/) override                 { return !breakLoading; }
+};
+
+
+/**
+ * hold the prefetched files (next and previous file in the file list)
+ * the files are loaded one after another in low priority threads
+ */
+class OctDataPrefetcher : public QObject
+{
+	Q_OBJECT
+
+	struct Entry
+	{
+		QString                filename;
+		OctDataPrefetchThread* thread = nullptr;
+		std::size_t            memory = 0;
+		bool                   ready  = false;
+		bool                   failed = false;
+		bool                   pinned = false; // a file open waits for this prefetch, it is not canceled by setPrefetchFiles
+	};
+
+	std::vector<Entry*> entries;
+	bool paused = false;
+
+	Entry* findEntry(const QString& filename);
+	std::size_t usedMemory() const;
+	void removeEntry(Entry* entry);
+	void cancelEntry(Entry* entry);
+	void startNext();
+
+public:
+	OctDataPrefetcher();
+	virtual ~OctDataPrefetcher();
+
+	bool isReady   (const QString& filename);
+	/**
+	 * raises the priority of a running prefetch and keeps it until prefetchFinished is emitted
+	 * returns false if the file is not prefetching, prefetchFinished is not emitted then
+	 */
+	bool prioritize(const QString& filename);
+
+	/**
+	 * returns the finished prefetch thread with the loaded data and removes it from the prefetcher
+	 * the caller owns the thread
+	 */
+	OctDataPrefetchThread* take(const QString& filename);
+
+	void setPrefetchFiles(const QStringList& files);
+	void cancelAll();
+
+	void setPaused(bool pause);
+
+private slots:
+	void prefetchThreadFinished();
+
+signals:
+	void prefetchFinished(const QString& filename);
+};
@@ -0,0 +1,875 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "octmarkerbinio.h"
+
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <ostream>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+namespace bpt = boost::property_tree;
+namespace bfs = boost::filesystem;
+namespace io  = boost::iostreams;
+
+
+namespace
+{
+	namespace Constants
+	{
+		const char          magic[8]    = {'O', 'C', 'T', 'M', 'A', 'R', 'K', 'B'};
+		const std::uint32_t version     = 1;
+		const std::size_t   headerSize  = 16;
+		const std::size_t   trailerSize = 8;
+		const char*         sectionParentNode = "Series";
+		const std::size_t   maxDepth    = 256;                      // protects the stack against broken files
+	}
+
+	enum class ValueType : std::uint8_t { Empty = 0, String = 1, FloatArray = 2, Tokens = 3, SectionRef = 4 };
+
+	const std::uint8_t trailingSpaceFlag = 1;
+
+
+	class BinWriter
+	{
+		std::string& buffer;
+	public:
+		explicit BinWriter(std::string& buffer) : buffer(buffer)    {}
+
+		void putU8(std::uint8_t v)                                  { buffer.push_back(static_cast<char>(v)); }
+		void putBytes(const char* data, std::size_t length)         { buffer.append(data, length); }
+
+		void putU32(std::uint32_t v)
+		{
+			for(int i = 0; i < 4; ++i)
+				putU8(static_cast<std::uint8_t>(v >> (8*i)));
+		}
+
+		void putU64(std::uint64_t v)
+		{
+			for(int i = 0; i < 8; ++i)
+				putU8(static_cast<std::uint8_t>(v >> (8*i)));
+		}
+
+		void putVarint(std::uint64_t v)
+		{
+			while(v >= 0x80)
+			{
+				putU8(static_cast<std::uint8_t>(v | 0x80));
+				v >>= 7;
+			}
+			putU8(static_cast<std::uint8_t>(v));
+		}
+
+		void putString(const std::string& str)
+		{
+			putVarint(str.size());
+			buffer.append(str);
+		}
+
+		void putFloat(float v)
+		{
+			std::uint32_t bits;
+			std::memcpy(&bits, &v, sizeof(bits));
+			putU32(bits);
+		}
+
+		std::size_t size() const                                    { return buffer.size(); }
+	};
+
+
+	class BinReader
+	{
+		const char* const data;
+		const std::size_t size;
+		std::size_t pos = 0;
+
+		void check(std::size_t n) const
+		{
+			if(n > size - pos)
+				throw "OctMarkerBinIO: unexpected end of data";
+		}
+	public:
+		BinReader(const char* data, std::size_t size) : data(data), size(size) {}
+
+		std::uint8_t getU8()
+		{
+			check(1);
+			return static_cast<std::uint8_t>(data[pos++]);
+		}
+
+		std::uint32_t getU32()
+		{
+			std::uint32_t v = 0;
+			for(int i = 0; i < 4; ++i)
+				v |= static_cast<std::uint32_t>(getU8()) << (8*i);
+			return v;
+		}
+
+		std::uint64_t getU64()
+		{
+			std::uint64_t v = 0;
+			for(int i = 0; i < 8; ++i)
+				v |= static_cast<std::uint64_t>(getU8()) << (8*i);
+			return v;
+		}
+
+		std::uint64_t getVarint()
+		{
+			std::uint64_t v = 0;
+			for(int shift = 0; shift < 64; shift += 7)
+			{
+				const std::uint8_t b = getU8();
+				v |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+				if((b & 0x80) == 0)
+					return v;
+			}
+			throw "OctMarkerBinIO: invalid varint";
+		}
+
+		std::size_t getSize()
+		{
+			const std::uint64_t v = getVarint();
+			if(v > size)
+				throw "OctMarkerBinIO: invalid size";
+			return static_cast<std::size_t>(v);
+		}
+
+		const char* getBytes(std::size_t length)
+		{
+			check(length);
+			const char* result = data + pos;
+			pos += length;
+			return result;
+		}
+
+		void getString(std::string& str)
+		{
+			const std::size_t length = getSize();
+			str.assign(getBytes(length), length);
+		}
+
+		float getFloat()
+		{
+			const std::uint32_t bits = getU32();
+			float v;
+			std::memcpy(&v, &bits, sizeof(v));
+			return v;
+		}
+
+		void seek(std::size_t p)
+		{
+			if(p > size)
+				throw "OctMarkerBinIO: invalid offset";
+			pos = p;
+		}
+	};
+
+
+	/*
+	 * Numbers written with std::ostream << double (e.g. layer segmentation lines) have the %g format with 6 significant digits.
+	 * Such a text is restored exactly from a float (FLT_DIG == 6), the check and the formating are done here without
+	 * the slow stream and locale functions. The writer checks every value by formating it again.
+	 */
+	const int maxDecimalExp = 37; // float range
+	const int pow10TableExp = 50;
+
+	double pow10(int exp)
+	{
+		static const struct Table
+		{
+			double values[2*pow10TableExp+1];
+			Table()
+			{
+				for(int i = 0; i <= 2*pow10TableExp; ++i)
+					values[i] = std::pow(10., i - pow10TableExp);
+			}
+		} table;
+		if(exp < -pow10TableExp || exp > pow10TableExp)
+			return std::pow(10., exp);
+		return table.values[exp + pow10TableExp];
+	}
+
+	bool parseLiteral(const char* begin, std::size_t length, float& value)
+	{
+		struct Literal { const char* text; float value; };
+		static const Literal literals[] =
+		{
+			{"nan" ,  std::numeric_limits<float>::quiet_NaN()},
+			{"-nan", -std::numeric_limits<float>::quiet_NaN()},
+			{"inf" ,  std::numeric_limits<float>::infinity()},
+			{"-inf", -std::numeric_limits<float>::infinity()},
+		};
+		for(const Literal& literal : literals)
+		{
+			if(std::strlen(literal.text) == length && std::memcmp(literal.text, begin, length) == 0)
+			{
+				value = literal.value;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// accepts only texts, which are generated by printf("%g") for the value
+	bool parseGFormat(const char* p, const char* end, float& value)
+	{
+		if(parseLiteral(p, static_cast<std::size_t>(end - p), value))
+			return true;
+
+		bool negative = false;
+		if(p != end && *p == '-')
+		{
+			negative = true;
+			++p;
+		}
+		if(p == end || *p < '0' || *p > '9')
+			return false;
+
+		long mantissa  = 0;
+		int  numDigits = 0;   // significant digits
+		int  exp10     = 0;   // decimal exponent of the first significant digit
+		bool zero      = false;
+
+		if(*p == '0')
+		{
+			++p;
+			if(p == end)
+				zero = true;
+			else
+			{
+				// 0.000ddd
+				if(*p != '.')
+					return false;
+				++p;
+				int leadingZeros = 0;
+				while(p != end && *p == '0')
+				{
+					++leadingZeros;
+					++p;
+				}
+				if(p == end || leadingZeros > 3)
+					return false;
+				exp10 = -leadingZeros - 1;
+				while(p != end && *p >= '0' && *p <= '9')
+				{
+					mantissa = mantissa*10 + (*p - '0');
+					++numDigits;
+					++p;
+				}
+				if(p != end || numDigits > 6 || *(p-1) == '0')
+					return false;
+			}
+		}
+		else
+		{
+			int intDigits = 0;
+			while(p != end && *p >= '0' && *p <= '9' && numDigits <= 6)
+			{
+				mantissa = mantissa*10 + (*p - '0');
+				++intDigits;
+				++numDigits;
+				++p;
+			}
+			exp10 = intDigits - 1;
+
+			if(p != end && *p == '.')
+			{
+				++p;
+				const char* fracBegin = p;
+				while(p != end && *p >= '0' && *p <= '9' && numDigits <= 6)
+				{
+					mantissa = mantissa*10 + (*p - '0');
+					++numDigits;
+					++p;
+				}
+				if(p == fracBegin || *(p-1) == '0')
+					return false;
+			}
+			if(numDigits > 6)
+				return false;
+
+			if(p != end)
+			{
+				// d.ddde+XX
+				if(*p != 'e' || intDigits != 1 || end - p < 4)
+					return false;
+				++p;
+				const bool negativeExp = *p == '-';
+				if(*p != '-' && *p != '+')
+					return false;
+				++p;
+				const std::ptrdiff_t expDigits = end - p;
+				if(expDigits > 3 || (expDigits == 3 && *p == '0'))
+					return false;
+				int e = 0;
+				for(; p != end; ++p)
+				{
+					if(*p < '0' || *p > '9')
+						return false;
+					e = e*10 + (*p - '0');
+				}
+				exp10 = negativeExp ? -e : e;
+				if(exp10 >= -4 && exp10 < 6)
+					return false;
+			}
+			else if(exp10 >= 6)
+				return false;
+		}
+
+		if(zero)
+		{
+			value = negative ? -0.f : 0.f;
+			return true;
+		}
+		if(exp10 > maxDecimalExp || exp10 < -maxDecimalExp)
+			return false;
+
+		const int scaleExp = exp10 - (numDigits - 1);
+		const double v = scaleExp >= 0 ? static_cast<double>(mantissa)*pow10(scaleExp) : static_cast<double>(mantissa)/pow10(-scaleExp);
+		value = static_cast<float>(negative ? -v : v);
+		return true;
+	}
+
+	void appendGFormat(std::string& str, float value)
+	{
+		if(std::isnan(value))
+		{
+			str.append(std::signbit(value) ? "-nan" : "nan");
+			return;
+		}
+		if(std::signbit(value))
+			str.push_back('-');
+		if(std::isinf(value))
+		{
+			str.append("inf");
+			return;
+		}
+		if(value == 0.f)
+		{
+			str.push_back('0');
+			return;
+		}
+
+		const double a = std::fabs(static_cast<double>(value));
+		int  exp10    = static_cast<int>(std::floor(std::log10(a)));
+		long mantissa = std::lround(a*pow10(5 - exp10));
+		if(mantissa >= 1000000)
+			mantissa = std::lround(a*pow10(5 - ++exp10));
+		else if(mantissa < 100000)
+			mantissa = std::lround(a*pow10(5 - --exp10));
+
+		char digits[6];
+		for(int i = 5; i >= 0; --i)
+		{
+			digits[i] = static_cast<char>('0' + mantissa%10);
+			mantissa /= 10;
+		}
+		int numDigits = 6;
+		while(numDigits > 1 && digits[numDigits-1] == '0')
+			--numDigits;
+
+		if(exp10 < -4 || exp10 >= 6)
+		{
+			str.push_back(digits[0]);
+			if(numDigits > 1)
+			{
+				str.push_back('.');
+				str.append(digits + 1, static_cast<std::size_t>(numDigits - 1));
+			}
+			str.push_back('e');
+			str.push_back(exp10 < 0 ? '-' : '+');
+			const int absExp = std::abs(exp10);
+			if(absExp >= 100)
+				str.push_back(static_cast<char>('0' + absExp/100));
+			str.push_back(static_cast<char>('0' + absExp/10%10));
+			str.push_back(static_cast<char>('0' + absExp%10));
+		}
+		else if(exp10 >= 0)
+		{
+			str.append(digits, static_cast<std::size_t>(exp10 + 1));
+			if(numDigits > exp10 + 1)
+			{
+				str.push_back('.');
+				str.append(digits + exp10 + 1, static_cast<std::size_t>(numDigits - exp10 - 1));
+			}
+		}
+		else
+		{
+			str.append("0.");
+			str.append(static_cast<std::size_t>(-exp10 - 1), '0');
+			str.append(digits, static_cast<std::size_t>(numDigits));
+		}
+	}
+
+	void appendInt(std::string& str, std::int64_t v)
+	{
+		char buffer[24];
+		char* p = buffer + sizeof(buffer);
+		std::uint64_t u = v < 0 ? static_cast<std::uint64_t>(-(v+1)) + 1 : static_cast<std::uint64_t>(v);
+		do
+		{
+			*--p = static_cast<char>('0' + u%10);
+			u /= 10;
+		} while(u > 0);
+		if(v < 0)
+			*--p = '-';
+		str.append(p, static_cast<std::size_t>(buffer + sizeof(buffer) - p));
+	}
+
+	bool parseCanonicalInt(const char* begin, const char* end, std::int64_t& value)
+	{
+		const char* p = begin;
+		bool negative = false;
+		if(p != end && *p == '-')
+		{
+			negative = true;
+			++p;
+		}
+		const std::ptrdiff_t digits = end - p;
+		if(digits <= 0 || digits > 15)
+			return false;
+		if(*p == '0' && (digits > 1 || negative))
+			return false;
+
+		std::int64_t v = 0;
+		for(; p != end; ++p)
+		{
+			if(*p < '0' || *p > '9')
+				return false;
+			v = v*10 + (*p - '0');
+		}
+		value = negative ? -v : v;
+		return true;
+	}
+
+	inline std::uint64_t zigzag  (std::int64_t  v)                  { return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63); }
+	inline std::int64_t  unzigzag(std::uint64_t v)                  { return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1); }
+
+
+	struct Token
+	{
+		const char* begin;
+		const char* end;
+
+		std::size_t length() const                                  { return static_cast<std::size_t>(end - begin); }
+	};
+
+	// split at single spaces, a trailing space is allowed (e.g. layer segmentation lines)
+	bool splitTokens(const std::string& str, std::vector<Token>& tokens, bool& trailingSpace)
+	{
+		tokens.clear();
+		trailingSpace = false;
+
+		const char* p   = str.data();
+		const char* end = p + str.size();
+		while(p != end)
+		{
+			const char* tokenEnd = std::find(p, end, ' ');
+			if(tokenEnd == p)
+				return false;
+			tokens.push_back(Token{p, tokenEnd});
+			if(tokenEnd == end)
+				return true;
+			p = tokenEnd + 1;
+		}
+		trailingSpace = true;
+		return !tokens.empty();
+	}
+
+
+	class TreeWriter
+	{
+		std::string sectionData;
+		std::string skeletonData;
+
+		BinWriter sectionWriter;
+		BinWriter skeletonWriter;
+
+		struct Section
+		{
+			std::string   name;
+			std::uint64_t offset;
+			std::uint64_t size;
+		};
+		std::vector<Section> sections;
+
+		std::vector<Token> tokens;
+		std::vector<float> numbers;
+		std::string        numberText;
+
+
+		void writeNumbers(BinWriter& writer, bool trailingSpace)
+		{
+			writer.putU8(static_cast<std::uint8_t>(ValueType::FloatArray));
+			writer.putU8(trailingSpace ? trailingSpaceFlag : 0);
+			writer.putVarint(numbers.size());
+			for(float v : numbers)
+				writer.putFloat(v);
+		}
+
+		void writeTokens(BinWriter& writer, bool trailingSpace)
+		{
+			writer.putU8(static_cast<std::uint8_t>(ValueType::Tokens));
+			writer.putU8(trailingSpace ? trailingSpaceFlag : 0);
+			writer.putVarint(tokens.size());
+			for(const Token& token : tokens)
+			{
+				std::int64_t value;
+				if(parseCanonicalInt(token.begin, token.end, value))
+					writer.putVarint(zigzag(value) << 1);
+				else
+				{
+					writer.putVarint((static_cast<std::uint64_t>(token.length()) << 1) | 1);
+					writer.putBytes(token.begin, token.length());
+				}
+			}
+		}
+
+		void writeValue(BinWriter& writer, const std::string& value)
+		{
+			if(value.empty())
+			{
+				writer.putU8(static_cast<std::uint8_t>(ValueType::Empty));
+				return;
+			}
+
+			bool trailingSpace;
+			if(splitTokens(value, tokens, trailingSpace))
+			{
+				std::size_t numInts = 0;
+				for(const Token& token : tokens)
+				{
+					std::int64_t intValue;
+					if(parseCanonicalInt(token.begin, token.end, intValue))
+						++numInts;
+				}
+				if(numInts == tokens.size())
+					return writeTokens(writer, trailingSpace);
+
+				bool allNumbers = true;
+				numbers.clear();
+				for(const Token& token : tokens)
+				{
+					float v;
+					numberText.clear();
+					if(parseGFormat(token.begin, token.end, v))
+						appendGFormat(numberText, v);
+					if(numberText.size() != token.length() || numberText.compare(0, numberText.size(), token.begin, token.length()) != 0)
+					{
+						allNumbers = false;
+						break;
+					}
+					numbers.push_back(v);
+				}
+
+				if(allNumbers)
+					return writeNumbers(writer, trailingSpace);
+				if(numInts > 0 && tokens.size() > 1)
+					return writeTokens(writer, trailingSpace);
+			}
+
+			writer.putU8(static_cast<std::uint8_t>(ValueType::String));
+			writer.putString(value);
+		}
+
+		void writeNode(BinWriter& writer, const bpt::ptree& node, bool isSectionParent, bool inSection)
+		{
+			writeValue(writer, node.data());
+			writer.putVarint(node.size());
+			for(const bpt::ptree::value_type& child : node)
+			{
+				writer.putString(child.first);
+				if(isSectionParent && !inSection && !child.second.empty())
+				{
+					const std::size_t offset = Constants::headerSize + sectionData.size();
+					writeNode(sectionWriter, child.second, false, true);
+					sections.push_back(Section{child.first, offset, Constants::headerSize + sectionData.size() - offset});
+
+					writer.putU8(static_cast<std::uint8_t>(ValueType::SectionRef));
+					writer.putVarint(sections.size() - 1);
+					writer.putVarint(0);
+				}
+				else
+					writeNode(writer, child.second, child.first == Constants::sectionParentNode, inSection);
+			}
+		}
+
+	public:
+		TreeWriter()
+		: sectionWriter (sectionData )
+		, skeletonWriter(skeletonData)
+		{}
+
+		void write(std::ostream& stream, const bpt::ptree& tree)
+		{
+			writeNode(skeletonWriter, tree, false, false);
+
+			std::string header;
+			BinWriter headerWriter(header);
+			headerWriter.putBytes(Constants::magic, sizeof(Constants::magic));
+			headerWriter.putU32(Constants::version);
+			headerWriter.putU32(0); // reserved
+
+			const std::uint64_t skeletonOffset = Constants::headerSize + sectionData.size();
+			const std::uint64_t indexOffset    = skeletonOffset + skeletonData.size();
+
+			std::string index;
+			BinWriter indexWriter(index);
+			indexWriter.putVarint(sections.size());
+			for(const Section& section : sections)
+			{
+				indexWriter.putString(section.name);
+				indexWriter.putVarint(section.offset);
+				indexWriter.putVarint(section.size);
+			}
+			indexWriter.putVarint(skeletonOffset);
+			indexWriter.putVarint(skeletonData.size());
+			indexWriter.putU64(indexOffset);
+
+			stream.write(header      .data(), static_cast<std::streamsize>(header      .size()));
+			stream.write(sectionData .data(), static_cast<std::streamsize>(sectionData .size()));
+			stream.write(skeletonData.data(), static_cast<std::streamsize>(skeletonData.size()));
+			stream.write(index       .data(), static_cast<std::streamsize>(index       .size()));
+		}
+	};
+
+
+	class TreeReader
+	{
+		const char* const data;
+		const std::size_t size;
+		const std::vector<std::string>* const sectionFilter;
+
+		struct Section
+		{
+			std::string name;
+			std::size_t offset;
+			std::size_t size;
+		};
+		std::vector<Section> sections;
+		std::vector<char>    sectionActive;                         // sections in decoding, a section can not refer to itself
+		std::size_t          depth = 0;
+
+		bool isSectionRequested(const std::string& name) const
+		{
+			if(!sectionFilter)
+				return true;
+			return std::find(sectionFilter->begin(), sectionFilter->end(), name) != sectionFilter->end();
+		}
+
+		// returns false if the node refers to a not requested section
+		bool readNode(BinReader& reader, bpt::ptree& node)
+		{
+			if(depth >= Constants::maxDepth)
+				throw "OctMarkerBinIO: nesting too deep";
+
+			++depth;
+			const bool result = readNodeContent(reader, node);
+			--depth;
+			return result;
+		}
+
+		bool readNodeContent(BinReader& reader, bpt::ptree& node)
+		{
+			std::string& value = node.data();
+			const ValueType type = static_cast<ValueType>(reader.getU8());
+			switch(type)
+			{
+				case ValueType::Empty:
+					break;
+				case ValueType::String:
+					reader.getString(value);
+					break;
+				case ValueType::FloatArray:
+				{
+					const bool trailingSpace = (reader.getU8() & trailingSpaceFlag) != 0;
+					const std::size_t n = reader.getSize();
+					value.reserve(n*8);
+					for(std::size_t i = 0; i < n; ++i)
+					{
+						if(i > 0)
+							value.push_back(' ');
+						appendGFormat(value, reader.getFloat());
+					}
+					if(trailingSpace)
+						value.push_back(' ');
+					break;
+				}
+				case ValueType::Tokens:
+				{
+					const bool trailingSpace = (reader.getU8() & trailingSpaceFlag) != 0;
+					const std::size_t n = reader.getSize();
+					for(std::size_t i = 0; i < n; ++i)
+					{
+						if(i > 0)
+							value.push_back(' ');
+						const std::uint64_t h = reader.getVarint();
+						if(h & 1)
+						{
+							const std::size_t length = static_cast<std::size_t>(h >> 1);
+							value.append(reader.getBytes(length), length);
+						}
+						else
+							appendInt(value, unzigzag(h >> 1));
+					}
+					if(trailingSpace)
+						value.push_back(' ');
+					break;
+				}
+				case ValueType::SectionRef:
+				{
+					const std::size_t sectionNr = reader.getSize();
+					reader.getVarint(); // no children
+					if(sectionNr >= sections.size())
+						throw "OctMarkerBinIO: invalid section";
+
+					const Section& section = sections[sectionNr];
+					if(!isSectionRequested(section.name))
+						return false;
+					if(sectionActive[sectionNr])
+						throw "OctMarkerBinIO: recursive section";
+
+					sectionActive[sectionNr] = 1;
+					BinReader sectionReader(data + section.offset, section.size);
+					const bool result = readNode(sectionReader, node);
+					sectionActive[sectionNr] = 0;
+					return result;
+				}
+				default:
+					throw "OctMarkerBinIO: unknown value type";
+			}
+
+			const std::size_t numChilds = reader.getSize();
+			std::string key;
+			for(std::size_t i = 0; i < numChilds; ++i)
+			{
+				reader.getString(key);
+				bpt::ptree::iterator it = node.push_back(bpt::ptree::value_type(key, bpt::ptree()));
+				if(!readNode(reader, it->second))
+					node.erase(it);
+			}
+			return true;
+		}
+
+		void checkRange(std::size_t offset, std::size_t length) const
+		{
+			if(offset > size || length > size - offset)
+				throw "OctMarkerBinIO: invalid section range";
+		}
+
+	public:
+		TreeReader(const char* data, std::size_t size, const std::vector<std::string>* sectionFilter)
+		: data(data)
+		, size(size)
+		, sectionFilter(sectionFilter)
+		{}
+
+		bool read(bpt::ptree& tree)
+		{
+			if(size < Constants::headerSize + Constants::trailerSize)
+				return false;
+			if(std::memcmp(data, Constants::magic, sizeof(Constants::magic)) != 0)
+				return false;
+
+			BinReader reader(data, size);
+			reader.seek(sizeof(Constants::magic));
+			if(reader.getU32() != Constants::version)
+				return false;
+
+			reader.seek(size - Constants::trailerSize);
+			const std::uint64_t indexOffset = reader.getU64();
+			if(indexOffset > size - Constants::trailerSize)
+				return false;
+			reader.seek(static_cast<std::size_t>(indexOffset));
+
+			const std::size_t numSections = reader.getSize();
+			sections.resize(numSections);
+			for(Section& section : sections)
+			{
+				reader.getString(section.name);
+				section.offset = reader.getSize();
+				section.size   = reader.getSize();
+				checkRange(section.offset, section.size);
+			}
+			sectionActive.assign(numSections, 0);
+
+			const std::size_t skeletonOffset = reader.getSize();
+			const std::size_t skeletonSize   = reader.getSize();
+			checkRange(skeletonOffset, skeletonSize);
+
+			tree.clear();
+			BinReader skeletonReader(data + skeletonOffset, skeletonSize);
+			readNode(skeletonReader, tree);
+			return true;
+		}
+	};
+}
+
+
+void OctMarkerBinIO::write(std::ostream& stream, const boost::property_tree::ptree& tree)
+{
+	TreeWriter writer;
+	writer.write(stream, tree);
+}
+
+
+bool OctMarkerBinIO::read(const char* data, std::size_t size, boost::property_tree::ptree& tree, const std::vector<std::string>* sections)
+{
+	TreeReader reader(data, size, sections);
+	try
+	{
+		return reader.read(tree);
+	}
+	catch(const char*)
+	{
+		// damaged data, the caller gets no partial tree
+	}
+	tree.clear();
+	return false;
+}
+
+
+bool OctMarkerBinIO::read(const boost::filesystem::path& path, boost::property_tree::ptree& tree, const std::vector<std::string>* sections)
+{
+	if(!bfs::exists(path) || bfs::file_size(path) == 0)
+		return false;
+
+	io::mapped_file_source file(path);
+	if(!file.is_open())
+		return false;
+
+	return read(file.data(), file.size(), tree, sections);
+}
+
+
+bool OctMarkerBinIO::isBinFile(const boost::filesystem::path& path)
+{
+	bfs::ifstream stream(path, std::ios::binary);
+	char magic[sizeof(Constants::magic)];
+	if(!stream.read(magic, sizeof(magic)))
+		return false;
+	return std::memcmp(magic, Constants::magic, sizeof(magic)) == 0;
+}
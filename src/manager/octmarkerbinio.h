@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+#include <boost/property_tree/ptree_fwd.hpp>
+
+namespace boost{ namespace filesystem { class path; }}
+
+
+/**
+ * binary marker file format (boctmarker)
+ *
+ * Every child with subnodes of a "Series" node (the data of a marker module) is stored in its own section,
+ * the remaining tree refers to the sections over a section index.
+ * Values are stored typed: lists of numbers as float arrays, lists of integers (e.g. boost text archives)
+ * as varints. A value is only stored typed when the decoded text is identical to the original text.
+ *
+ * The reader still builds a property tree with text values, a complete load is therefore not faster
+ * than the INFO format (the typed values are formatted as text again and parsed by the marker modules).
+ * The gains are the file size and the partial load of single sections.
+ */
+class OctMarkerBinIO
+{
+public:
+	static void write(std::ostream& stream, const boost::property_tree::ptree& tree);
+
+	/**
+	 * the file is mapped into memory, when sections is given only the sections with this names are decoded
+	 */
+	static bool read(const boost::filesystem::path& path, boost::property_tree::ptree& tree, const std::vector<std::string>* sections = nullptr);
+	static bool read(const char* data, std::size_t size, boost::property_tree::ptree& tree, const std::vector<std::string>* sections = nullptr);
+
+	static bool isBinFile(const boost::filesystem::path& path);
+};
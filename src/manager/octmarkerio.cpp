@@ -17,6 +17,8 @@
  */
 
 #include "octmarkerio.h"
+#include "octmarkerbinio.h"
+#include "octmarkerjournal.h"
 
 #ifndef MEX_COMPILE
 	#include <data_structure/programoptions.h>
@@ -35,10 +37,27 @@
 
 #include <boost/iostreams/device/file_descriptor.hpp>
 #include <boost/iostreams/stream.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/filesystem/fstream.hpp>
 #include <boost/filesystem.hpp>
 #include <iostream>
 
 #include<string>
+#include<map>
+#include<mutex>
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
 
 namespace pt = boost::property_tree;
 namespace io = boost::iostreams;
@@ -60,6 +79,51 @@ namespace
 		const char* mainNodeName = "OctMarker";
 		const int   version      = 1;
 	}
+
+	// writes the file data to the disk, before the file replaces another one
+	bool syncFile(const bfs::path& path)
+	{
+	#ifdef _WIN32
+		HANDLE handle = CreateFileW(path.wstring().c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if(handle == INVALID_HANDLE_VALUE)
+			return false;
+		const bool result = FlushFileBuffers(handle) != 0;
+		CloseHandle(handle);
+		return result;
+	#else
+		const int fd = ::open(path.c_str(), O_RDONLY);
+		if(fd < 0)
+			return false;
+		const bool result = ::fsync(fd) == 0;
+		::close(fd);
+		return result;
+	#endif
+	}
+
+	// makes a rename in the directory durable
+	void syncDirectory(const bfs::path& path)
+	{
+	#ifndef _WIN32
+		const bfs::path directory = path.has_parent_path() ? path.parent_path() : bfs::path(".");
+		const int fd = ::open(directory.c_str(), O_RDONLY);
+		if(fd >= 0)
+		{
+			::fsync(fd);
+			::close(fd);
+		}
+	#else
+		(void)path;
+	#endif
+	}
+
+	bool isGzipFile(const bfs::path& path)
+	{
+		bfs::ifstream stream(path, std::ios::binary);
+		char magic[2];
+		if(!stream.read(magic, sizeof(magic)))
+			return false;
+		return magic[0] == '\x1f' && magic[1] == '\x8b';
+	}
 }
 
 
@@ -69,6 +133,15 @@ OctMarkerIO::OctMarkerIO(boost::property_tree::ptree* markerTree)
 	
 }
 
+bool OctMarkerIO::isCompressionEnabled()
+{
+#ifndef MEX_COMPILE
+	return ProgramOptions::compressOctMarkers();
+#else
+	return false;
+#endif
+}
+
 OctMarkerFileformat OctMarkerIO::getDefaultFileFormat()
 {
 #ifndef MEX_COMPILE
@@ -82,6 +155,7 @@ OctMarkerFileformat OctMarkerIO::getDefaultFileFormat()
 		case OctMarkerFileformat::XML:
 		case OctMarkerFileformat::Json:
 		case OctMarkerFileformat::INFO:
+		case OctMarkerFileformat::Binary:
 			return format;
 		case OctMarkerFileformat::Unknown:
 		case OctMarkerFileformat::Auto:
@@ -102,6 +176,8 @@ int OctMarkerIO::fileformat2Int(OctMarkerFileformat format)
 			return static_cast<int>(OctMarkerFileformat::Json);
 		case OctMarkerFileformat::INFO:
 			return static_cast<int>(OctMarkerFileformat::INFO);
+		case OctMarkerFileformat::Binary:
+			return static_cast<int>(OctMarkerFileformat::Binary);
 		case OctMarkerFileformat::Unknown:
 		case OctMarkerFileformat::Auto:
 		case OctMarkerFileformat::NoExtension:
@@ -120,6 +196,8 @@ OctMarkerFileformat OctMarkerIO::int2Fileformat(int formatId)
 			return OctMarkerFileformat::Json;
 		case static_cast<int>(OctMarkerFileformat::INFO):
 			return OctMarkerFileformat::INFO;
+		case static_cast<int>(OctMarkerFileformat::Binary):
+			return OctMarkerFileformat::Binary;
 	}
 	return OctMarkerFileformat::Unknown;
 }
@@ -146,6 +224,8 @@ OctMarkerFileformat OctMarkerIO::getFormatFromExtension(const boost::filesystem:
 		return OctMarkerFileformat::XML;
 	if(extension == getFileExtension(OctMarkerFileformat::INFO))
 		return OctMarkerFileformat::INFO;
+	if(extension == getFileExtension(OctMarkerFileformat::Binary))
+		return OctMarkerFileformat::Binary;
 
 	return OctMarkerFileformat::Unknown;
 }
@@ -161,6 +241,8 @@ const char* OctMarkerIO::getFileExtension(OctMarkerFileformat format)
 			return "xoctmarker";
 		case OctMarkerFileformat::INFO:
 			return "ioctmarker";
+		case OctMarkerFileformat::Binary:
+			return "boctmarker";
 		case OctMarkerFileformat::Unknown:
 		case OctMarkerFileformat::Auto:
 		case OctMarkerFileformat::NoExtension:
@@ -176,43 +258,162 @@ std::string OctMarkerIO::addMarkerExtension(const std::string& file, OctMarkerFi
 
 
 
-bool OctMarkerIO::loadDefaultMarker(const std::string& octFilename)
+std::string OctMarkerIO::getDefaultMarkerFilename(const std::string& octFilename, OctMarkerFileformat& format)
 {
-	loadedDefaultFilename.clear();
 	OctMarkerFileformat formats[] = { OctMarkerFileformat::Json,
 	                                  OctMarkerFileformat::XML,
-	                                  OctMarkerFileformat::INFO };
-	
+	                                  OctMarkerFileformat::INFO,
+	                                  OctMarkerFileformat::Binary };
+
 	for(std::size_t i = 0; i < sizeof(formats)/sizeof(formats[0]); ++i)
 	{
 		bfs::path markersFile = filenameConv(addMarkerExtension(octFilename, formats[i]));
 		if(bfs::exists(markersFile))
 		{
-			defaultLoadedFormat = formats[i];
-			loadedDefaultFilename = markersFile.generic_string();
-			return loadMarkers(markersFile, defaultLoadedFormat);
+			format = formats[i];
+			return markersFile.generic_string();
 		}
 	}
 
 
 	if(octFilename.substr(octFilename.size()-3, 3) == ".gz")
-		return loadDefaultMarker(octFilename.substr(0, octFilename.size()-3));
+		return getDefaultMarkerFilename(octFilename.substr(0, octFilename.size()-3), format);
+
+	return std::string();
+}
+
+
+bool OctMarkerIO::loadDefaultMarker(const std::string& octFilename)
+{
+	OctMarkerFileformat format;
+	loadedDefaultFilename = getDefaultMarkerFilename(octFilename, format);
+
+	if(!loadedDefaultFilename.empty())
+	{
+		defaultLoadedFormat = format;
+		return loadMarkers(loadedDefaultFilename, defaultLoadedFormat);
+	}
 
 	defaultLoadedFormat = getDefaultFileFormat();
 	return false;
 }
 
 
+std::time_t OctMarkerIO::getFileTime(const std::string& filename)
+{
+	if(filename.empty())
+		return 0;
+
+	bfs::path filePath(filenameConv(filename));
+	if(!bfs::exists(filePath))
+		return 0;
+	return bfs::last_write_time(filePath);
+}
+
+
+namespace
+{
+	std::mutex                      writeCountMutex;
+	std::map<std::string, uint64_t> writeCounts;
+
+	std::string writeCountKey(const std::string& filename)
+	{
+		return bfs::path(filenameConv(filename)).generic_string();
+	}
+
+	void getFileSizeTime(const bfs::path& filePath, uintmax_t& size, std::time_t& time)
+	{
+		boost::system::error_code ec;
+		size = bfs::file_size(filePath, ec);
+		if(ec)
+		{
+			size = 0;
+			time = 0;
+			return;
+		}
+		time = bfs::last_write_time(filePath, ec);
+	}
+}
+
+
+bool OctMarkerFileStamp::operator==(const OctMarkerFileStamp& other) const
+{
+	return time        == other.time
+	    && size        == other.size
+	    && journalTime == other.journalTime
+	    && journalSize == other.journalSize
+	    && writeCount  == other.writeCount;
+}
+
+
+OctMarkerFileStamp OctMarkerIO::getFileStamp(const std::string& filename)
+{
+	OctMarkerFileStamp stamp;
+	if(filename.empty())
+		return stamp;
+
+	{
+		// before the file times, a write in the meantime changes the stamp in any case
+		std::lock_guard<std::mutex> lock(writeCountMutex);
+		std::map<std::string, uint64_t>::const_iterator it = writeCounts.find(writeCountKey(filename));
+		if(it != writeCounts.end())
+			stamp.writeCount = it->second;
+	}
+
+	const bfs::path filePath   (filenameConv(filename));
+	const bfs::path journalPath(OctMarkerJournal::getJournalPath(filePath));
+	getFileSizeTime(filePath   , stamp.size       , stamp.time       );
+	getFileSizeTime(journalPath, stamp.journalSize, stamp.journalTime);
+	return stamp;
+}
+
+
+void OctMarkerIO::markFileWritten(const std::string& filename)
+{
+	std::lock_guard<std::mutex> lock(writeCountMutex);
+	++writeCounts[writeCountKey(filename)];
+}
+
+
+bool OctMarkerIO::isDefaultMarkerUnchanged(const std::string& octFilename, const OctMarkerFileStamp& markersStamp) const
+{
+	OctMarkerFileformat format;
+	const std::string markersFilename = getDefaultMarkerFilename(octFilename, format);
+	if(markersFilename != loadedDefaultFilename)
+		return false;
+
+	return getFileStamp(markersFilename) == markersStamp;
+}
+
+
+void OctMarkerIO::copyDefaultMarkerInfo(const OctMarkerIO& other)
+{
+	defaultLoadedFormat   = other.defaultLoadedFormat;
+	loadedDefaultFilename = other.loadedDefaultFilename;
+	journalComplete       = other.journalComplete;
+}
+
+
 bool OctMarkerIO::saveDefaultMarker(const std::string& octFilename)
+{
+	OctMarkerFileformat format;
+	const std::string markersFilename = getDefaultSaveFilename(octFilename, format);
+	return saveMarkers(markersFilename, format);
+}
+
+std::string OctMarkerIO::getDefaultSaveFilename(const std::string& octFilename, OctMarkerFileformat& format)
 {
 	if(loadedDefaultFilename.empty())
-		return saveMarkers(addMarkerExtension(octFilename, defaultLoadedFormat), defaultLoadedFormat);
-	else
-		return saveMarkers(loadedDefaultFilename, defaultLoadedFormat);
+		loadedDefaultFilename = addMarkerExtension(octFilename, defaultLoadedFormat);
+
+	format = defaultLoadedFormat;
+	return loadedDefaultFilename;
 }
 
 bool OctMarkerIO::loadMarkers(const boost::filesystem::path& markersPath, OctMarkerFileformat format)
 {
+	journalComplete = true;
+
 	if(format == OctMarkerFileformat::Auto)
 		format = getFormatFromExtension(markersPath);
 	if(format == OctMarkerFileformat::Unknown
@@ -226,26 +427,47 @@ bool OctMarkerIO::loadMarkers(const boost::filesystem::path& markersPath, OctMar
 	DEBUG_OUT(loadString.c_str());
 
 	bpt::ptree loadTree;
+	const std::vector<std::string>* sections = sectionFilter.empty() ? nullptr : &sectionFilter;
 
-    io::file_descriptor_source fs(markersPath);
-    io::stream<io::file_descriptor_source> fsstream(fs);
-
-	switch(format)
+	// compressed and uncompressed files have the same extension, the gzip header decides
+	const bool compressed = isGzipFile(markersPath);
+	if(format == OctMarkerFileformat::Binary && !compressed)
 	{
-		case OctMarkerFileformat::Json:
-			bpt::read_json(fsstream, loadTree);
-			break;
-		case OctMarkerFileformat::XML:
-			bpt::read_xml(fsstream, loadTree, bpt::xml_parser::trim_whitespace);
-			break;
-		case OctMarkerFileformat::INFO:
-			bpt::read_info(fsstream, loadTree);
-			break;
-		case OctMarkerFileformat::Auto: // avoid compiler warnings
-		case OctMarkerFileformat::Unknown:
-		case OctMarkerFileformat::NoExtension:
+		if(!OctMarkerBinIO::read(markersPath, loadTree, sections))
 			return false;
 	}
+	else
+	{
+		io::filtering_istream fsstream;
+		if(compressed)
+			fsstream.push(io::gzip_decompressor());
+		fsstream.push(io::file_descriptor_source(markersPath));
+
+		switch(format)
+		{
+			case OctMarkerFileformat::Json:
+				bpt::read_json(fsstream, loadTree);
+				break;
+			case OctMarkerFileformat::XML:
+				bpt::read_xml(fsstream, loadTree, bpt::xml_parser::trim_whitespace);
+				break;
+			case OctMarkerFileformat::INFO:
+				bpt::read_info(fsstream, loadTree);
+				break;
+			case OctMarkerFileformat::Binary:
+			{
+				std::string data;
+				io::copy(fsstream, io::back_inserter(data));
+				if(!OctMarkerBinIO::read(data.data(), data.size(), loadTree, sections))
+					return false;
+				break;
+			}
+			case OctMarkerFileformat::Auto: // avoid compiler warnings
+			case OctMarkerFileformat::Unknown:
+			case OctMarkerFileformat::NoExtension:
+				return false;
+		}
+	}
 
 	boost::optional<bpt::ptree&> nodeMain = loadTree.get_child_optional(Constants::mainNodeName);
 	if(!nodeMain)
@@ -263,7 +485,9 @@ bool OctMarkerIO::loadMarkers(const boost::filesystem::path& markersPath, OctMar
 	if(!nodeMarkers)
 		return false;
 
-	*markerstree = *nodeMarkers;
+	markerstree->swap(*nodeMarkers); // loadTree is discarded, no deep copy needed
+
+	OctMarkerJournal::apply(OctMarkerJournal::getJournalPath(markersPath), *markerstree, journalComplete);
 
 	return true;
 }
@@ -294,27 +518,72 @@ bool OctMarkerIO::saveMarkers(const std::string& markersFilename, OctMarkerFilef
 
 bool OctMarkerIO::saveMarkersPrivat(const std::string& markersFilename, OctMarkerFileformat format)
 {
+	// lend the markers to the save tree instead of copying them, they are given back also on exceptions
+	class LendMarkers
+	{
+		bpt::ptree& owner;
+		bpt::ptree& borrower;
+	public:
+		LendMarkers(bpt::ptree& owner, bpt::ptree& borrower) : owner(owner), borrower(borrower) { borrower.swap(owner); }
+		~LendMarkers()                                                                          { borrower.swap(owner); }
+	};
+
 	bpt::ptree saveTree;
+	LendMarkers lend(*markerstree, createSaveTreeFrame(saveTree));
+	return writeSaveTree(saveTree, markersFilename, format, isCompressionEnabled());
+}
+
+
+boost::property_tree::ptree& OctMarkerIO::createSaveTreeFrame(boost::property_tree::ptree& saveTree)
+{
+	saveTree.clear();
 	bpt::ptree& markerTree = saveTree.put(Constants::mainNodeName, "");
 	markerTree.put("Version", Constants::version);
-    markerTree.add_child("Markers", *markerstree);
+	return markerTree.add_child("Markers", bpt::ptree());
+}
+
+
+void OctMarkerIO::lendSaveTree(boost::property_tree::ptree& saveTree)
+{
+	createSaveTreeFrame(saveTree).swap(*markerstree);
+}
+
+
+void OctMarkerIO::returnSaveTree(boost::property_tree::ptree& saveTree)
+{
+	markerstree->clear();
 
+	boost::optional<bpt::ptree&> nodeMain = saveTree.get_child_optional(Constants::mainNodeName);
+	if(!nodeMain)
+		return;
 
-	boost::filesystem::path p(filenameConv(markersFilename));
-    io::file_descriptor_sink fs(p);
-    io::stream<io::file_descriptor_sink> fsstream(fs);
+	boost::optional<bpt::ptree&> nodeMarkers = nodeMain->get_child_optional("Markers");
+	if(nodeMarkers)
+		markerstree->swap(*nodeMarkers);
+}
 
 
+const boost::property_tree::ptree* OctMarkerIO::getSaveTreeMarkers(const boost::property_tree::ptree& saveTree)
+{
+	boost::optional<const bpt::ptree&> nodeMain = saveTree.get_child_optional(Constants::mainNodeName);
+	if(!nodeMain)
+		return nullptr;
+
+	boost::optional<const bpt::ptree&> nodeMarkers = nodeMain->get_child_optional("Markers");
+	if(!nodeMarkers)
+		return nullptr;
+	return &(*nodeMarkers);
+}
+
+
+bool OctMarkerIO::writeSaveTree(const boost::property_tree::ptree& saveTree, const std::string& markersFilename, OctMarkerFileformat format, bool compress)
+{
 	switch(format)
 	{
 		case OctMarkerFileformat::Json:
-			bpt::write_json(fsstream, saveTree);
-			break;
 		case OctMarkerFileformat::XML:
-			bpt::write_xml(fsstream, saveTree, bpt::xml_writer_make_settings<bpt::ptree::key_type>('\t', 1u));
-			break;
 		case OctMarkerFileformat::INFO:
-			bpt::write_info(fsstream, saveTree, bpt::info_writer_settings<char>('\t', 1u));
+		case OctMarkerFileformat::Binary:
 			break;
 		case OctMarkerFileformat::Unknown:
 		case OctMarkerFileformat::Auto:
@@ -322,6 +591,65 @@ bool OctMarkerIO::saveMarkersPrivat(const std::string& markersFilename, OctMarke
 			return false;
 	}
 
+	// write into a temp file and replace the marker file afterwards, a crash while writing doesn't destroy the old markers
+	const bfs::path markersPath(filenameConv(markersFilename));
+	const bfs::path tempPath(filenameConv(markersFilename + ".tmp"));
+
+	try
+	{
+		{
+			io::filtering_ostream fsstream;
+			if(compress)
+				fsstream.push(io::gzip_compressor());
+			fsstream.push(io::file_descriptor_sink(tempPath));
+
+			switch(format)
+			{
+				case OctMarkerFileformat::Json:
+					bpt::write_json(fsstream, saveTree);
+					break;
+				case OctMarkerFileformat::XML:
+					bpt::write_xml(fsstream, saveTree, bpt::xml_writer_make_settings<bpt::ptree::key_type>('\t', 1u));
+					break;
+				case OctMarkerFileformat::INFO:
+					bpt::write_info(fsstream, saveTree, bpt::info_writer_settings<char>('\t', 1u));
+					break;
+				case OctMarkerFileformat::Binary:
+					OctMarkerBinIO::write(fsstream, saveTree);
+					break;
+				case OctMarkerFileformat::Unknown:
+				case OctMarkerFileformat::Auto:
+				case OctMarkerFileformat::NoExtension:
+					break;
+			}
+
+			fsstream.flush();
+			const bool writeOk = static_cast<bool>(fsstream);
+			fsstream.reset(); // closes the chain, writes the gzip trailer
+			if(!writeOk || !syncFile(tempPath))
+			{
+				bfs::remove(tempPath);
+				return false;
+			}
+		}
+
+		boost::system::error_code permissionsError;
+		const bfs::file_status markersStatus = bfs::status(markersPath, permissionsError);
+		if(!permissionsError && bfs::exists(markersStatus))
+			bfs::permissions(tempPath, markersStatus.permissions(), permissionsError); // keep the mode of the replaced file
+
+		bfs::rename(tempPath, markersPath);
+		syncDirectory(markersPath);
+
+		boost::system::error_code ec;
+		bfs::remove(OctMarkerJournal::getJournalPath(markersPath), ec); // the changes are in the marker file now
+	}
+	catch(...)
+	{
+		boost::system::error_code ec;
+		bfs::remove(tempPath, ec);
+		throw;
+	}
+
 	return true;
 }
-
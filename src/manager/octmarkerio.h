@@ -20,6 +20,9 @@
 #define OCTMARKERIO_H
 
 #include<string>
+#include<vector>
+#include<ctime>
+#include<cstdint>
 
 #include<boost/property_tree/ptree_fwd.hpp>
 
@@ -28,16 +31,36 @@
 namespace boost{ namespace filesystem { class path; }}
 
 
+/**
+ * version of a marker file and its journal, used to detect a save after the markers were read
+ * the write count of this process detects saves within the resolution of the file time
+ */
+struct OctMarkerFileStamp
+{
+	std::time_t time        = 0;
+	uintmax_t   size        = 0;
+	std::time_t journalTime = 0;
+	uintmax_t   journalSize = 0;
+	uint64_t    writeCount  = 0;
+
+	bool operator==(const OctMarkerFileStamp& other) const;
+	bool operator!=(const OctMarkerFileStamp& other) const         { return !(*this == other); }
+};
+
+
 class OctMarkerIO
 {
 	static OctMarkerFileformat getDefaultFileFormat();
 
 	OctMarkerFileformat defaultLoadedFormat = OctMarkerFileformat::Json;
 	std::string loadedDefaultFilename;
+	std::vector<std::string> sectionFilter;
+	bool journalComplete = true; // false: the journal of the loaded marker file has damaged records
 	
 	boost::property_tree::ptree* markerstree = nullptr;
 
 	bool saveMarkersPrivat(const std::string& markersFilename, OctMarkerFileformat format);
+	static boost::property_tree::ptree& createSaveTreeFrame(boost::property_tree::ptree& saveTree);
 	
 public:
 	explicit OctMarkerIO(boost::property_tree::ptree* markerTree);
@@ -52,12 +75,38 @@ public:
 	static int fileformat2Int(OctMarkerFileformat format);
 	
 	
+	static std::string getDefaultMarkerFilename(const std::string& octFilename, OctMarkerFileformat& format);
+
 	bool saveDefaultMarker(const std::string& octFilename);
+	std::string getDefaultSaveFilename(const std::string& octFilename, OctMarkerFileformat& format);
 	bool loadDefaultMarker(const std::string& octFilename);
+	void copyDefaultMarkerInfo(const OctMarkerIO& other);
+	const std::string& getLoadedDefaultFilename() const             { return loadedDefaultFilename; }
+	bool isJournalComplete() const                                  { return journalComplete; }
+
+	// load only these module nodes of a series from binary marker files, empty: load all
+	void setSectionFilter(const std::vector<std::string>& filter)   { sectionFilter = filter; }
+
+	static std::time_t getFileTime(const std::string& filename);
+
+	// take the stamp before the markers are read
+	static OctMarkerFileStamp getFileStamp(const std::string& filename);
+	static void markFileWritten(const std::string& filename); // after a write of the marker file or its journal
+	bool isDefaultMarkerUnchanged(const std::string& octFilename, const OctMarkerFileStamp& markersStamp) const;
 	
 	bool loadMarkers(const std::string&             markersFilename, OctMarkerFileformat format);
 	bool loadMarkers(const boost::filesystem::path& markersPath    , OctMarkerFileformat format);
 	bool saveMarkers(const std::string&             markersFilename, OctMarkerFileformat format);
+
+	static bool isCompressionEnabled(); // gzip for new marker files
+
+	// moves the markers into saveTree for writeSaveTree (e.g. in another thread), the markers are empty until returnSaveTree
+	void lendSaveTree  (boost::property_tree::ptree& saveTree);
+	void returnSaveTree(boost::property_tree::ptree& saveTree);
+	static const boost::property_tree::ptree* getSaveTreeMarkers(const boost::property_tree::ptree& saveTree);
+	static       boost::property_tree::ptree* getSaveTreeMarkers(      boost::property_tree::ptree& saveTree)
+	                                                                { return const_cast<boost::property_tree::ptree*>(getSaveTreeMarkers(static_cast<const boost::property_tree::ptree&>(saveTree))); }
+	static bool writeSaveTree(const boost::property_tree::ptree& saveTree, const std::string& markersFilename, OctMarkerFileformat format, bool compress = false);
 	
 	bool saveMarkersSeries(const std::string& markersFilename);
 	bool addMarkersSeries (const std::string& markersFilename);
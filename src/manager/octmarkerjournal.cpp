@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "octmarkerjournal.h"
+#include "octmarkerbinio.h"
+
+#include <cstring>
+#include <cstdint>
+#include <sstream>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <helper/ptreehelper.h>
+
+namespace bpt = boost::property_tree;
+namespace bfs = boost::filesystem;
+
+
+namespace
+{
+	namespace Constants
+	{
+		const char        magic[8]   = {'O', 'C', 'T', 'M', 'J', 'R', 'N', '1'};
+		const std::size_t recordHead = 8; // payload size and checksum
+	}
+
+	std::uint32_t checksum(const char* data, std::size_t size)
+	{
+		// FNV-1a
+		std::uint32_t hash = 2166136261u;
+		for(std::size_t i = 0; i < size; ++i)
+		{
+			hash ^= static_cast<std::uint8_t>(data[i]);
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	void appendU32(std::string& str, std::uint32_t v)
+	{
+		for(int i = 0; i < 4; ++i)
+			str.push_back(static_cast<char>(v >> (8*i)));
+	}
+
+	std::uint32_t readU32(const char* data)
+	{
+		std::uint32_t v = 0;
+		for(int i = 0; i < 4; ++i)
+			v |= static_cast<std::uint32_t>(static_cast<std::uint8_t>(data[i])) << (8*i);
+		return v;
+	}
+
+	bool isNode(const bpt::ptree::value_type& child, const OctMarkerJournal::PathElement& element)
+	{
+		if(child.first != element.name)
+			return false;
+		if(element.id < 0)
+			return true;
+
+		boost::optional<const bpt::ptree&> idNode = child.second.get_child_optional("ID");
+		return idNode && idNode->get_value<int>(element.id+1) == element.id;
+	}
+
+	const bpt::ptree* findNode(const bpt::ptree& tree, const OctMarkerJournal::NodePath& path)
+	{
+		const bpt::ptree* node = &tree;
+		for(const OctMarkerJournal::PathElement& element : path)
+		{
+			const bpt::ptree* child = nullptr;
+			for(const bpt::ptree::value_type& pair : *node)
+			{
+				if(isNode(pair, element))
+				{
+					child = &pair.second;
+					break;
+				}
+			}
+			if(!child)
+				return nullptr;
+			node = child;
+		}
+		return node;
+	}
+
+	bool applyRecord(const bpt::ptree& record, bpt::ptree& markersTree)
+	{
+		boost::optional<const bpt::ptree&> pathNode = record.get_child_optional("Path");
+		if(!pathNode || pathNode->empty())
+			return false;
+
+		OctMarkerJournal::NodePath path;
+		for(const bpt::ptree::value_type& pair : *pathNode)
+		{
+			boost::optional<std::string> name = pair.second.get_optional<std::string>("Name");
+			if(!name || name->empty())
+				return false;
+			path.emplace_back(*name, pair.second.get<int>("ID", -1));
+		}
+
+		bpt::ptree* parent = &markersTree;
+		for(std::size_t i = 0; i+1 < path.size(); ++i)
+		{
+			if(path[i].id < 0)
+				parent = &PTreeHelper::get_put(*parent, path[i].name);
+			else
+				parent = &PTreeHelper::getNodeWithId(*parent, path[i].name, path[i].id);
+		}
+
+		const OctMarkerJournal::PathElement& last = path.back();
+		bpt::ptree::iterator it = parent->begin();
+		while(it != parent->end())
+		{
+			if(isNode(*it, last))
+				it = parent->erase(it);
+			else
+				++it;
+		}
+
+		boost::optional<const bpt::ptree&> data = record.get_child_optional("Data");
+		if(data)
+			parent->push_back(bpt::ptree::value_type(last.name, *data));
+		return true;
+	}
+}
+
+
+boost::filesystem::path OctMarkerJournal::getJournalPath(const boost::filesystem::path& markersPath)
+{
+	bfs::path journalPath = markersPath;
+	journalPath += ".journal";
+	return journalPath;
+}
+
+
+void OctMarkerJournal::addRecord(std::string& records, const boost::property_tree::ptree& markersTree, const NodePath& path)
+{
+	bpt::ptree record;
+	bpt::ptree& pathNode = record.put_child("Path", bpt::ptree());
+	for(const PathElement& element : path)
+	{
+		bpt::ptree& elementNode = pathNode.add_child("Node", bpt::ptree());
+		elementNode.put("Name", element.name);
+		if(element.id >= 0)
+			elementNode.put("ID", element.id);
+	}
+
+	const bpt::ptree* node = findNode(markersTree, path);
+	if(node)
+		record.put_child("Data", *node);
+
+	std::ostringstream stream;
+	OctMarkerBinIO::write(stream, record);
+	const std::string payload = stream.str();
+
+	appendU32(records, static_cast<std::uint32_t>(payload.size()));
+	appendU32(records, checksum(payload.data(), payload.size()));
+	records.append(payload);
+}
+
+
+bool OctMarkerJournal::append(const boost::filesystem::path& journalPath, const std::string& records)
+{
+	const bool newFile = !bfs::exists(journalPath) || bfs::file_size(journalPath) == 0;
+
+	bfs::ofstream stream(journalPath, std::ios::binary | std::ios::app);
+	if(newFile)
+		stream.write(Constants::magic, sizeof(Constants::magic));
+	stream.write(records.data(), static_cast<std::streamsize>(records.size()));
+	stream.flush();
+	return static_cast<bool>(stream);
+}
+
+
+std::size_t OctMarkerJournal::apply(const boost::filesystem::path& journalPath, boost::property_tree::ptree& markersTree, bool& complete)
+{
+	complete = true;
+	if(!bfs::exists(journalPath))
+		return 0;
+
+	bfs::ifstream stream(journalPath, std::ios::binary);
+	const std::string content((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+	if(content.size() < sizeof(Constants::magic) || std::memcmp(content.data(), Constants::magic, sizeof(Constants::magic)) != 0)
+	{
+		complete = content.empty();
+		return 0;
+	}
+
+	std::size_t numRecords = 0;
+	std::size_t pos = sizeof(Constants::magic);
+	while(content.size() - pos >= Constants::recordHead)
+	{
+		const std::size_t size = readU32(content.data() + pos);
+		const std::uint32_t sum = readU32(content.data() + pos + 4);
+		pos += Constants::recordHead;
+		if(size > content.size() - pos || checksum(content.data() + pos, size) != sum)
+		{
+			pos -= Constants::recordHead;
+			break;
+		}
+
+		// a damaged record with a valid checksum (e.g. written by a newer version) stops the replay as well
+		bpt::ptree record;
+		if(!OctMarkerBinIO::read(content.data() + pos, size, record) || !applyRecord(record, markersTree))
+		{
+			pos -= Constants::recordHead;
+			break;
+		}
+		++numRecords;
+		pos += size;
+	}
+
+	complete = pos == content.size();
+	return numRecords;
+}
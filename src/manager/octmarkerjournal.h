@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <boost/property_tree/ptree_fwd.hpp>
+
+namespace boost{ namespace filesystem { class path; }}
+
+
+/**
+ * append-only journal of a marker file (<marker file>.journal)
+ *
+ * A record replaces one node of the marker tree (e.g. the layer segmentation of one b-scan) or removes it.
+ * Writing the marker file completely makes the journal obsolete.
+ */
+class OctMarkerJournal
+{
+public:
+	struct PathElement
+	{
+		std::string name;
+		int         id;   // < 0: node without ID child
+
+		PathElement(const std::string& name, int id = -1) : name(name), id(id) {}
+
+		bool operator==(const PathElement& other) const         { return id == other.id && name == other.name; }
+	};
+	typedef std::vector<PathElement> NodePath;
+
+	static boost::filesystem::path getJournalPath(const boost::filesystem::path& markersPath);
+
+	/**
+	 * serializes the node at path in markersTree, a missing node is recorded as removed
+	 */
+	static void addRecord(std::string& records, const boost::property_tree::ptree& markersTree, const NodePath& path);
+
+	static bool append(const boost::filesystem::path& journalPath, const std::string& records);
+
+	/**
+	 * applies the records one after another, the replay stops at an incomplete or damaged record (e.g. after a crash)
+	 * complete is false if the journal has data after the last valid record, new records must not be appended then
+	 * returns the number of applied records
+	 */
+	static std::size_t apply(const boost::filesystem::path& journalPath, boost::property_tree::ptree& markersTree, bool& complete);
+};
@@ -21,6 +21,7 @@
 #include <data_structure/intervalmarker.h>
 #include <data_structure/programoptions.h>
 #include <data_structure/extraseriesdata.h>
+#include <data_structure/markercommand.h>
 
 #include <octdata/datastruct/series.h>
 #include <octdata/datastruct/bscan.h>
@@ -83,6 +84,8 @@ OctMarkerManager::OctMarkerManager()
 	}
 
 
+	connect(&ProgramOptions::undoMaxMemory, &OptionInt::valueChanged, this, &OctMarkerManager::limitUndoMemory);
+
 	sloMarkerObj.push_back(new SloObjectMarker(this));
 	
 	setBscanMarker(ProgramOptions::bscanMarkerToolId());
@@ -246,16 +249,32 @@ void OctMarkerManager::saveMarkerStateSlot(const OctData::Series* s)
 		return;
 
 
-	for(BscanMarkerBase* obj : bscanMarkerObj)
+	OctDataManager& dataManager = OctDataManager::getInstance();
+
+	// a slo preview has no b-scans, the b-scan markers in the tree are still valid
+	if(!dataManager.isPreview())
 	{
-		const QString& markerId = obj->getMarkerId();
-		bpt::ptree& subtree = PTreeHelper::get_put(*markerTree, markerId.toStdString());
-		obj->saveState(subtree);
+		std::vector<std::size_t> savedBScans;
+		for(BscanMarkerBase* obj : bscanMarkerObj)
+		{
+			const std::string markerId = obj->getMarkerId().toStdString();
+			const bool changed = obj->hasChangedSinceLastSave();
+			bpt::ptree& subtree = PTreeHelper::get_put(*markerTree, markerId);
+			const boost::optional<std::string> oldVersion = subtree.get_optional<std::string>("Version");
+			obj->saveState(subtree);
+
+			if(obj->getLastSavedBScans(savedBScans))
+				dataManager.markerBScansSaved(s, markerId, savedBScans, subtree.get_optional<std::string>("Version") != oldVersion);
+			else if(changed)
+				dataManager.markerModuleChanged();
+		}
 	}
 
 	for(SloMarkerBase* obj : sloMarkerObj)
 	{
 		const QString& markerId = obj->getMarkerId();
+		if(obj->hasChangedSinceLastSave())
+			dataManager.markerModuleChanged();
 		bpt::ptree& subtree = PTreeHelper::get_put(*markerTree, markerId.toStdString());
 		obj->saveState(subtree);
 	}
@@ -301,6 +320,8 @@ void OctMarkerManager::udateFromMarkerModul()
 
 void OctMarkerManager::updateUndoRedowState()
 {
+	 limitUndoMemory();
+
 	 QObject* obj = sender();
 	 if(obj == actBscanMarker)
 	 {
@@ -308,6 +329,49 @@ void OctMarkerManager::updateUndoRedowState()
 	 }
 }
 
+void OctMarkerManager::limitUndoMemory()
+{
+	const std::size_t maxMemory = static_cast<std::size_t>(ProgramOptions::undoMaxMemory())*1024*1024;
+	if(maxMemory == 0)
+		return;
+
+	std::size_t memory    = 0;
+	std::size_t undoSteps = 0;
+	for(const BscanMarkerBase* marker : bscanMarkerObj)
+	{
+		memory    += marker->getUndoMemorySize();
+		undoSteps += marker->numUndoSteps();
+	}
+
+	// remove the oldest steps over all marker modules, the last step is kept
+	bool removed = false;
+	while(memory > maxMemory && undoSteps > 1)
+	{
+		BscanMarkerBase* oldestMarker = nullptr;
+		std::size_t oldestNumber = 0;
+		for(BscanMarkerBase* marker : bscanMarkerObj)
+		{
+			const MarkerCommand* command = marker->getOldestUndoCommand();
+			if(command && (!oldestMarker || command->getCreationNumber() < oldestNumber))
+			{
+				oldestMarker = marker;
+				oldestNumber = command->getCreationNumber();
+			}
+		}
+		if(!oldestMarker)
+			break;
+
+		memory -= oldestMarker->getUndoMemorySize();
+		oldestMarker->removeOldestUndoCommand();
+		memory += oldestMarker->getUndoMemorySize();
+		--undoSteps;
+		removed = true;
+	}
+
+	if(removed)
+		emit(undoRedoStateChange());
+}
+
 void OctMarkerManager::bscanChangeRequestFromMarkerModul(int bscan)
 {
 	 QObject* obj = sender();
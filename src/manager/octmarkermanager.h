@@ -56,8 +56,13 @@ public:
 	int getActSloMarkerId() const                                   { return actSloMarkerId; }
 	const std::vector<SloMarkerBase*>& getSloMarker() const         { return sloMarkerObj; }
 
-	bool hasChangedSinceLastSave() const                            { if(stateChangedSinceLastSave) return true; return hasActMarkerChanged(); }
-	void resetChangedSinceLastSaveState()                           { stateChangedSinceLastSave = false; }
+	bool hasChangedSinceLastSave() const                            { if(saveUnconfirmed) return true; return hasChangedSinceSaveSnapshot(); }
+	bool hasChangedSinceSaveSnapshot() const                        { if(stateChangedSinceLastSave) return true; return hasActMarkerChanged(); }
+	void resetChangedSinceLastSaveState()                           { stateChangedSinceLastSave = false; saveUnconfirmed = false; }
+
+	// the markers are written in background, they count as changed until the write is confirmed
+	void resetChangedForPendingSave()                               { stateChangedSinceLastSave = false; saveUnconfirmed = true; }
+	void confirmPendingSave()                                       { saveUnconfirmed = false; }
 
 	const ExtraImageData* getExtraImageData() const;
 
@@ -82,8 +87,10 @@ private:
 	SloMarkerBase* actSloMarker = nullptr;
 	int actSloMarkerId = -1;
 	bool stateChangedSinceLastSave = false;
+	bool saveUnconfirmed           = false;
 
 	bool hasActMarkerChanged() const;
+	void limitUndoMemory();
 
 	ExtraSeriesData* extraSeriesData = nullptr;
 
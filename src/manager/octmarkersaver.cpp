@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "octmarkersaver.h"
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+
+#include <oct_cpp_framework/platform_helper/filename_unicode.h>
+
+#include "octmarkerio.h"
+#include "octmarkerjournal.h"
+
+
+OctMarkerSaveJob::OctMarkerSaveJob(const QString& octFilename, const std::string& markersFilename, OctMarkerFileformat format, bool compress, boost::property_tree::ptree* saveTree, bool ownsTree)
+: octFilename    (octFilename    )
+, markersFilename(markersFilename)
+, format         (format         )
+, compress       (compress       )
+, saveTree       (saveTree       )
+, ownsTree       (ownsTree       )
+{
+}
+
+OctMarkerSaveJob::OctMarkerSaveJob(const QString& octFilename, const std::string& markersFilename, std::string&& journalRecords)
+: octFilename    (octFilename    )
+, markersFilename(markersFilename)
+, format         (OctMarkerFileformat::Unknown)
+, journalRecords (std::move(journalRecords))
+{
+}
+
+OctMarkerSaveJob::~OctMarkerSaveJob()
+{
+	if(ownsTree)
+		delete saveTree;
+}
+
+
+void OctMarkerSaveJob::write()
+{
+	try
+	{
+		if(isJournal())
+			success = OctMarkerJournal::append(OctMarkerJournal::getJournalPath(boost::filesystem::path(filenameConv(markersFilename))), journalRecords);
+		else
+			success = OctMarkerIO::writeSaveTree(*saveTree, markersFilename, format, compress);
+		if(!success)
+			error = QString("can't write %1").arg(QString::fromStdString(markersFilename));
+	}
+	catch(boost::exception& e)
+	{
+		error = QString::fromStdString(boost::diagnostic_information(e));
+	}
+	catch(std::exception& e)
+	{
+		error = QString::fromStdString(e.what());
+	}
+	catch(const char* str)
+	{
+		error = str;
+	}
+	catch(...)
+	{
+		error = QString("Unknow error in file %1 line %2").arg(__FILE__).arg(__LINE__);
+	}
+
+	OctMarkerIO::markFileWritten(markersFilename); // also after a failed write, the file can be changed
+}
+
+bool OctMarkerSaveJob::isForFile(const QString& filename) const
+{
+	return octFilename == filename || QString::fromStdString(markersFilename) == filename;
+}
+
+
+
+OctMarkerSaver::~OctMarkerSaver()
+{
+	QStringList errors;
+	waitForAll(errors);
+}
+
+
+void OctMarkerSaver::save(const QString& octFilename, const std::string& markersFilename, OctMarkerFileformat format, bool compress, boost::property_tree::ptree* saveTree)
+{
+	addSaveJob(new OctMarkerSaveJob(octFilename, markersFilename, format, compress, saveTree, true));
+}
+
+
+void OctMarkerSaver::saveLent(const QString& octFilename, const std::string& markersFilename, OctMarkerFileformat format, bool compress, boost::property_tree::ptree* saveTree)
+{
+	addSaveJob(new OctMarkerSaveJob(octFilename, markersFilename, format, compress, saveTree, false));
+}
+
+
+void OctMarkerSaver::addSaveJob(OctMarkerSaveJob* job)
+{
+	bool replaced = false;
+	std::list<OctMarkerSaveJob*>::iterator it = pendingJobs.begin();
+	while(it != pendingJobs.end())
+	{
+		if((*it)->markersFilename != job->markersFilename)
+		{
+			++it;
+			continue;
+		}
+
+		if(!(*it)->ownsTree)
+			emit(lentTreeWritten((*it)->saveTree, false));
+		delete *it; // the newer snapshot contains all changes
+		if(replaced)
+			it = pendingJobs.erase(it);
+		else
+		{
+			*it = job;
+			replaced = true;
+			++it;
+		}
+	}
+	if(replaced)
+		return;
+
+	pendingJobs.push_back(job);
+	if(!saveThread)
+		startNextJob();
+}
+
+
+void OctMarkerSaver::appendJournal(const QString& octFilename, const std::string& markersFilename, std::string&& records)
+{
+	for(std::list<OctMarkerSaveJob*>::reverse_iterator it = pendingJobs.rbegin(); it != pendingJobs.rend(); ++it)
+	{
+		if((*it)->markersFilename != markersFilename)
+			continue;
+
+		if((*it)->isJournal())
+		{
+			(*it)->journalRecords.append(records);
+			return;
+		}
+		break;
+	}
+
+	pendingJobs.push_back(new OctMarkerSaveJob(octFilename, markersFilename, std::move(records)));
+	if(!saveThread)
+		startNextJob();
+}
+
+
+void OctMarkerSaver::startNextJob()
+{
+	if(saveThread || pendingJobs.empty())
+		return;
+
+	OctMarkerSaveJob* job = pendingJobs.front();
+	pendingJobs.pop_front();
+
+	saveThread = new OctMarkerSaveThread(job);
+	connect(saveThread, &OctMarkerSaveThread::finished, this, &OctMarkerSaver::saveThreadFinished);
+	saveThread->start(QThread::LowPriority);
+}
+
+
+void OctMarkerSaver::finishRunningJob(QStringList* errors)
+{
+	if(!saveThread)
+		return;
+
+	OctMarkerSaveThread* thread = saveThread;
+	saveThread = nullptr;
+
+	thread->wait();
+	OctMarkerSaveJob* job = thread->getJob();
+
+	if(!job->ownsTree)
+		emit(lentTreeWritten(job->saveTree, job->success));
+
+	if(job->success)
+		emit(markersSaved(job->octFilename, QString::fromStdString(job->markersFilename)));
+	else if(errors)
+		errors->append(job->error);
+	else
+		emit(saveFailed(QString::fromStdString(job->markersFilename), job->error));
+
+	delete job;
+	delete thread;
+}
+
+
+void OctMarkerSaver::saveThreadFinished()
+{
+	if(!saveThread || !saveThread->isFinished())
+		return; // already handled by a wait function
+
+	finishRunningJob();
+	startNextJob();
+}
+
+
+bool OctMarkerSaver::hasJobForFile(const QString& filename) const
+{
+	if(saveThread && saveThread->getJob()->isForFile(filename))
+		return true;
+
+	for(const OctMarkerSaveJob* job : pendingJobs)
+		if(job->isForFile(filename))
+			return true;
+	return false;
+}
+
+
+void OctMarkerSaver::waitForFile(const QString& filename)
+{
+	while(hasJobForFile(filename))
+	{
+		finishRunningJob();
+		startNextJob();
+	}
+}
+
+
+OctMarkerSaveJob* OctMarkerSaver::getJobForTree(const boost::property_tree::ptree* saveTree) const
+{
+	if(!saveTree)
+		return nullptr;
+
+	if(saveThread && saveThread->getJob()->saveTree == saveTree)
+		return saveThread->getJob();
+
+	for(OctMarkerSaveJob* job : pendingJobs)
+		if(job->saveTree == saveTree)
+			return job;
+	return nullptr;
+}
+
+
+void OctMarkerSaver::waitForTree(const boost::property_tree::ptree* saveTree)
+{
+	while(getJobForTree(saveTree))
+	{
+		finishRunningJob();
+		startNextJob();
+	}
+}
+
+
+void OctMarkerSaver::releaseTree(boost::property_tree::ptree* saveTree)
+{
+	OctMarkerSaveJob* job = getJobForTree(saveTree);
+	if(job)
+		job->ownsTree = true;
+	else
+		delete saveTree;
+}
+
+
+bool OctMarkerSaver::waitForAll(QStringList& errors)
+{
+	const int oldErrors = errors.size();
+	while(saveThread || !pendingJobs.empty())
+	{
+		finishRunningJob(&errors);
+		startNextJob();
+	}
+	return errors.size() == oldErrors;
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <list>
+#include <string>
+
+#include <QObject>
+#include <QThread>
+#include <QString>
+#include <QStringList>
+
+#include <boost/property_tree/ptree_fwd.hpp>
+
+#include <globaldefinitions.h>
+
+
+/**
+ * a marker tree snapshot, which is written to a file, or records for the journal of the marker file
+ * a lent tree (ownsTree false) is given back to the caller after the write
+ */
+class OctMarkerSaveJob
+{
+public:
+	OctMarkerSaveJob(const QString& octFilename, const std::string& markersFilename, OctMarkerFileformat format, bool compress, boost::property_tree::ptree* saveTree, bool ownsTree);
+	OctMarkerSaveJob(const QString& octFilename, const std::string& markersFilename, std::string&& journalRecords);
+	~OctMarkerSaveJob();
+
+	OctMarkerSaveJob(const OctMarkerSaveJob&)            = delete;
+	OctMarkerSaveJob& operator=(const OctMarkerSaveJob&) = delete;
+
+	const QString                      octFilename;
+	const std::string                  markersFilename;
+	const OctMarkerFileformat          format;
+	const bool                         compress = false;
+	boost::property_tree::ptree*       saveTree = nullptr;
+	bool                               ownsTree = true;
+	std::string                        journalRecords;
+
+	bool    success = false;
+	QString error;
+
+	void write();
+	bool isForFile(const QString& filename) const;
+	bool isJournal() const                                          { return saveTree == nullptr; }
+};
+
+
+class OctMarkerSaveThread : public QThread
+{
+	Q_OBJECT
+
+	OctMarkerSaveJob* job = nullptr;
+public:
+	explicit OctMarkerSaveThread(OctMarkerSaveJob* job) : job(job)  {}
+
+	OctMarkerSaveJob* getJob()                                      { return job; }
+
+protected:
+	void run() override                                             { job->write(); }
+};
+
+
+/**
+ * writes the marker files in a background thread, one after another
+ */
+class OctMarkerSaver : public QObject
+{
+	Q_OBJECT
+public:
+	OctMarkerSaver() = default;
+	~OctMarkerSaver();
+
+	/**
+	 * takes the ownership of saveTree, not started saves and journal records of the same file are replaced
+	 */
+	void save(const QString& octFilename, const std::string& markersFilename, OctMarkerFileformat format, bool compress, boost::property_tree::ptree* saveTree);
+
+	/**
+	 * like save, but the caller keeps the ownership of saveTree and must not change it until lentTreeWritten
+	 * (also emitted in the wait functions), releaseTree hands the ownership over instead
+	 */
+	void saveLent(const QString& octFilename, const std::string& markersFilename, OctMarkerFileformat format, bool compress, boost::property_tree::ptree* saveTree);
+
+	/**
+	 * blocks until the lent saveTree is written
+	 */
+	void waitForTree(const boost::property_tree::ptree* saveTree);
+
+	/**
+	 * the saver takes the ownership of the lent saveTree, it is deleted after the write
+	 */
+	void releaseTree(boost::property_tree::ptree* saveTree);
+
+	/**
+	 * appends records to the journal of the marker file, after the pending saves of the file
+	 */
+	void appendJournal(const QString& octFilename, const std::string& markersFilename, std::string&& records);
+
+	/**
+	 * blocks until all saves of the file (oct or marker file) are written
+	 */
+	void waitForFile(const QString& filename);
+
+	/**
+	 * blocks until all saves are written, the errors are returned instead of emitted
+	 */
+	bool waitForAll(QStringList& errors);
+
+	bool isSaving() const                                           { return saveThread != nullptr || !pendingJobs.empty(); }
+	bool isSavingFile(const QString& filename) const                { return hasJobForFile(filename); }
+	bool isSavingTree(const boost::property_tree::ptree* saveTree) const
+	                                                                { return getJobForTree(saveTree) != nullptr; }
+
+signals:
+	void markersSaved(const QString& octFilename, const QString& markersFilename);
+	void saveFailed(const QString& markersFilename, const QString& error);
+	void lentTreeWritten(const boost::property_tree::ptree* saveTree, bool success);
+
+private slots:
+	void saveThreadFinished();
+
+private:
+	OctMarkerSaveThread* saveThread = nullptr;
+	std::list<OctMarkerSaveJob*> pendingJobs;
+
+	void addSaveJob(OctMarkerSaveJob* job);
+	void startNextJob();
+	void finishRunningJob(QStringList* errors = nullptr);
+	bool hasJobForFile(const QString& filename) const;
+	OctMarkerSaveJob* getJobForTree(const boost::property_tree::ptree* saveTree) const;
+};
@@ -81,6 +81,8 @@ BScanIntervalMarker::BScanIntervalMarker(OctMarkerManager* markerManager)
 	}
 
 	actCollection = markersCollectionsData.begin();
+
+	connect(&OctDataManager::getInstance(), &OctDataManager::distanceMapReady, this, &BScanIntervalMarker::distanceMapReady);
 }
 
 BScanIntervalMarker::~BScanIntervalMarker()
@@ -342,6 +344,7 @@ void BScanIntervalMarker::generateSloMap()
 
 	OctDataManager& manager = OctDataManager::getInstance();
 	const SloBScanDistanceMap* distMap = manager.getSeriesSLODistanceMap();
+	sloMapPending = !distMap;
 	if(distMap && actCollectionValid())
 	{
 		SloIntervallMap tm;
@@ -697,3 +700,9 @@ void BScanIntervalMarker::autoGenerateSloMap()
 	if(ProgramOptions::intervallMarkSloMapAuteGenerate())
 		generateSloMap();
 }
+
+void BScanIntervalMarker::distanceMapReady()
+{
+	if(sloMapPending)
+		generateSloMap();
+}
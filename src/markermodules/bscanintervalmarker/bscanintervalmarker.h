@@ -166,6 +166,7 @@ private:
 
 
 	cv::Mat* sloOverlayImage = nullptr;
+	bool     sloMapPending   = false; // requested before the distance map was ready
 
 	MarkerMap nullMarkerMap; // TODO
 
@@ -189,6 +190,7 @@ private:
 
 	void generateSloMap();
 	void autoGenerateSloMap();
+	void distanceMapReady();
 };
 
 #endif // BSCANQUALITYMARKER_H
@@ -26,6 +26,7 @@
 #include<octdata/datastruct/bscan.h>
 
 #include<data_structure/slobscandistancemap.h>
+#include<data_structure/slointerpolationoperator.h>
 
 
 SloIntervallMap::SloIntervallMap()
@@ -41,82 +42,38 @@ SloIntervallMap::~SloIntervallMap()
 
 void SloIntervallMap::createMap(const SloBScanDistanceMap& distanceMap, const std::vector<BScanIntervalMarker::MarkerMap>& lines, const OctData::Series* series)
 {
-	const SloBScanDistanceMap::PreCalcDataMatrix* distMatrix = distanceMap.getDataMatrix();
+	const SloInterpolationOperator* interpolation = distanceMap.getInterpolationOperator();
 
-	if(!distMatrix)
+	if(!interpolation)
 		return;
 
-	const std::size_t sizeX = distMatrix->getSizeX();
-	const std::size_t sizeY = distMatrix->getSizeY();
+	fillColorValues(*interpolation, lines, series);
 
-	fillCache(lines, series);
+	sloMap->create(static_cast<int>(interpolation->getSizeY()), static_cast<int>(interpolation->getSizeX()), CV_8UC4);
 
-	sloMap->create(static_cast<int>(sizeX), static_cast<int>(sizeY), CV_8UC4);
-
-	for(std::size_t y = 0; y < sizeY; ++y)
-	{
-		uint8_t* destPtr = sloMap->ptr<uint8_t>(static_cast<int>(y));
-		const SloBScanDistanceMap::PreCalcDataMatrix::value_type* srcPtr = distMatrix->scanLine(y);
-
-		for(std::size_t x = 0; x < sizeX; ++x)
-		{
-			if(srcPtr->init)
-			{
-				const Color& c = getColor(srcPtr->bscan1.bscan, srcPtr->bscan1.ascan);
-
-				destPtr[0] = c.b;
-				destPtr[1] = c.g;
-				destPtr[2] = c.r;
-				destPtr[3] = c.a;
-			}
-			else
-			{
-				destPtr[0] = 0;
-				destPtr[1] = 0;
-				destPtr[2] = 0;
-				destPtr[3] = 0;
-			}
-
-			destPtr += 4;
-			++srcPtr;
-		}
-	}
-}
-
-const SloIntervallMap::Color& SloIntervallMap::getColor(std::size_t bscan, std::size_t ascan) const
-{
-	try
-	{
-		return colorCache.at(bscan).at(ascan);
-	}
-	catch(const std::out_of_range&)
-	{
-		static Color invalidIndex;
-		return invalidIndex;
-	}
+	interpolation->gatherNearest(colorValues.data(), [this](std::size_t y) { return reinterpret_cast<Color*>(sloMap->ptr<uint8_t>(static_cast<int>(y))); });
 }
 
 
-
-void SloIntervallMap::fillCache(const std::vector<BScanIntervalMarker::MarkerMap>& lines, const OctData::Series* series)
+void SloIntervallMap::fillColorValues(const SloInterpolationOperator& interpolation, const std::vector<BScanIntervalMarker::MarkerMap>& lines, const OctData::Series* series)
 {
+	colorValues.assign(interpolation.getValueCount(), Color());
+
 	if(!series)
 		return;
 
-	const std::size_t numBscans = std::min(series->bscanCount(), lines.size());
+	const std::size_t numBscans = std::min(std::min(series->bscanCount(), lines.size()), interpolation.getNumBScans());
 
-	colorCache.resize(numBscans);
 	for(std::size_t i = 0; i < numBscans; ++i)
 	{
 		const OctData::BScan* bscan = series->getBScan(i);
 		if(!bscan)
 			continue;
 
-		BScanIntervalMarker::MarkerMap markerMap = lines[i];
-		std::size_t bscanWidth = static_cast<std::size_t>(bscan->getWidth());
+		const BScanIntervalMarker::MarkerMap& markerMap = lines[i];
+		std::size_t bscanWidth = std::min(static_cast<std::size_t>(bscan->getWidth()), interpolation.getNumAScans(i));
 
-		std::vector<Color>& colorLine = colorCache[i];
-		colorLine.resize(bscanWidth);
+		Color* const colorLine = colorValues.data() + interpolation.getValueIndex(i, 0);
 
 		for(const BScanIntervalMarker::MarkerMap::interval_mapping_type pair : markerMap)
 		{
@@ -27,6 +27,7 @@ namespace cv { class Mat; }
 namespace OctData { class Series; }
 
 class SloBScanDistanceMap;
+class SloInterpolationOperator;
 
 class SloIntervallMap
 {
@@ -46,20 +47,22 @@ public:
 	const cv::Mat& getSloMap() const { return *sloMap; }
 
 private:
+	// same layout as a CV_8UC4 (BGRA) pixel
 	struct Color
 	{
 		Color() = default;
-		Color(uint8_t r, uint8_t g, uint8_t b, uint8_t a) : r(r), g(g), b(b), a(a) {}
-		uint8_t r = 0;
-		uint8_t g = 0;
+		Color(uint8_t r, uint8_t g, uint8_t b, uint8_t a) : b(b), g(g), r(r), a(a) {}
 		uint8_t b = 0;
+		uint8_t g = 0;
+		uint8_t r = 0;
 		uint8_t a = 0;
 	};
+	static_assert(sizeof(Color) == 4, "Color has to match a CV_8UC4 pixel");
 
-	void fillCache(const std::vector<BScanIntervalMarker::MarkerMap>& lines, const OctData::Series* series);
-	const Color& getColor(std::size_t bscan, std::size_t ascan) const;
+	// color of every a-scan in value order of the interpolation operator
+	void fillColorValues(const SloInterpolationOperator& interpolation, const std::vector<BScanIntervalMarker::MarkerMap>& lines, const OctData::Series* series);
 
-	std::vector<std::vector<Color>> colorCache;
+	std::vector<Color> colorValues;
 	cv::Mat* sloMap = nullptr;
 };
 
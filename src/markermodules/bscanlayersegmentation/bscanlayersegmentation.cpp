@@ -77,6 +77,7 @@ BScanLayerSegmentation::BScanLayerSegmentation(OctMarkerManager* markerManager)
 , editMethodSpline(new EditSpline(this))
 , editMethodPen   (new EditPen   (this))
 , thicknesMapImage(new cv::Mat)
+, thicknessMap    (new ThicknessMap)
 {
 	name = tr("Layer Segmentation");
 	id   = "LayerSegmentation";
@@ -89,6 +90,7 @@ BScanLayerSegmentation::BScanLayerSegmentation(OctMarkerManager* markerManager)
 	widgetPtr2WGLayerSeg = new WGLayerSeg(this);
 
 	connect(&ProgramOptions::layerSegThicknessmapBlend, &OptionBool::valueChanged, this, &BScanLayerSegmentation::generateThicknessmap);
+	connect(&OctDataManager::getInstance(), &OctDataManager::distanceMapReady    , this, &BScanLayerSegmentation::generateThicknessmap);
 
 	connect(&ProgramOptions::layerSegActiveLineColor, &OptionColor::valueChanged, this, &BScanLayerSegmentation::requestFullUpdate);
 	connect(&ProgramOptions::layerSegPassivLineColor, &OptionColor::valueChanged, this, &BScanLayerSegmentation::requestFullUpdate);
@@ -104,6 +106,7 @@ BScanLayerSegmentation::~BScanLayerSegmentation()
 	delete editMethodPen   ;
 
 	delete thicknesMapImage;
+	delete thicknessMap;
 // 	delete thicknessMapLegend; // TODO
 	delete legendWG;
 }
@@ -200,6 +203,7 @@ void BScanLayerSegmentation::newSeriesLoaded(const OctData::Series* series, boos
 {
 	BscanMarkerBase::newSeriesLoaded(series, ptree);
 	*thicknesMapImage = cv::Mat();
+	thicknessMap->resetThicknessMapCache();
 	resetMarkers(series);
 	loadState(ptree);
 }
@@ -228,9 +232,14 @@ void BScanLayerSegmentation::resetMarkers(std::size_t bscanNr)
 	if(!bscan)
 		return;
 
-	const std::size_t bscanWidth = static_cast<std::size_t>(bscan->getWidth());
+	resetSegData(segData, *bscan);
+}
+
+void BScanLayerSegmentation::resetSegData(BScanSegData& segData, const OctData::BScan& bscan)
+{
+	const std::size_t bscanWidth = static_cast<std::size_t>(bscan.getWidth());
 
-	segData.lines  = bscan->getSegmentLines();
+	segData.lines  = bscan.getSegmentLines();
 	segData.filled = true;
 
 	for(OctData::Segmentationlines::SegmentlineType type : OctData::Segmentationlines::getSegmentlineTypes())
@@ -329,6 +338,7 @@ void BScanLayerSegmentation::modifiedSegPart(std::size_t bscan, OctData::Segment
 		return;
 
 	lines[bscan].lineModified[static_cast<std::size_t>(segLine)] = true;
+	lines[bscan].changedSinceSaveState = true;
 	OctData::Segmentationlines::Segmentline& line = lines[bscan].lines.getSegmentLine(segLine);
 
 	if(line.size() <= start)
@@ -336,7 +346,8 @@ void BScanLayerSegmentation::modifiedSegPart(std::size_t bscan, OctData::Segment
 
 	const std::size_t maxCpoy = std::min(segPart.size(), line.size() - start);
 	std::copy(segPart.begin(), segPart.begin() + maxCpoy, line.begin() + start);
-	changeActBScan = true;
+	if(!updateThicknessmapBScan(bscan, segLine))
+		changeActBScan = true;
 
 	if(updateMethode)
 	{
@@ -350,6 +361,22 @@ void BScanLayerSegmentation::modifiedSegPart(std::size_t bscan, OctData::Segment
 }
 
 
+bool BScanLayerSegmentation::updateThicknessmapBScan(std::size_t bscan, OctData::Segmentationlines::SegmentlineType segLine)
+{
+	if(segLine != thicknessmapConfig.upperLayer && segLine != thicknessmapConfig.lowerLayer)
+		return true;
+
+	const SloBScanDistanceMap* distMap = OctDataManager::getInstance().getSeriesSLODistanceMap();
+	if(!ProgramOptions::layerSegSloMapsAutoUpdate() || !showThicknessmap || !distMap
+	|| !thicknessMap->updateBScan(*distMap, lines, bscan))
+	{
+		thicknessMap->resetThicknessMapCache(); // the map is outdated now, the next update has to recreate it
+		return false;
+	}
+
+	requestSloOverlayUpdate();
+	return true;
+}
 
 
 bool BScanLayerSegmentation::keyPressEvent(QKeyEvent* event, BScanMarkerWidget* widget)
@@ -414,12 +441,22 @@ void BScanLayerSegmentation::setThicknessmapConfig(const ThicknessmapTemplates::
 
 
 	showThicknessmap = true;
-	generateThicknessmap();
+
+	// only the colors changed: the cached thickness image is recolored without a new interpolation
+	if(thicknessmapConfig.colormap && thicknessMap->recolor(thicknessmapConfig.upperLayer, thicknessmapConfig.lowerLayer, *thicknessmapConfig.colormap))
+	{
+		thicknessMapLegend->setColormap(thicknessmapConfig.colormap);
+		requestSloOverlayUpdate();
+	}
+	else
+		generateThicknessmap();
 }
 
 
 void BScanLayerSegmentation::generateThicknessmap()
 {
+	thicknessMap->resetThicknessMapCache();
+
 	if(thicknessmapConfig.colormap && showThicknessmap)
 	{
 // 		QElapsedTimer timer;
@@ -432,9 +469,8 @@ void BScanLayerSegmentation::generateThicknessmap()
 		{
 			double factor = bscan->getScaleFactor().getZ()*1000; // milli meter -> micro meter
 
-			ThicknessMap tm;
-			tm.createMap(*distMap, lines, thicknessmapConfig.upperLayer, thicknessmapConfig.lowerLayer, factor, *thicknessmapConfig.colormap);
-			*thicknesMapImage = tm.getThicknessMap();
+			thicknessMap->createMap(*distMap, lines, thicknessmapConfig.upperLayer, thicknessmapConfig.lowerLayer, factor, *thicknessmapConfig.colormap);
+			*thicknesMapImage = thicknessMap->getThicknessMap();
 			requestSloOverlayUpdate();
 
 // 			std::cout << "Creating thickness map took " << timer.elapsed() << " milliseconds" << std::endl;
@@ -470,6 +506,7 @@ void BScanLayerSegmentation::copySegLinesFromOctData(const std::size_t bScanNr)
 		return;
 
 	resetMarkers(bScanNr);
+	lines[bScanNr].changedSinceSaveState = true;
 
 	if(bScanNr == getActBScanNr())
 	{
@@ -543,12 +580,42 @@ void BScanLayerSegmentation::loadState(boost::property_tree::ptree& markerTree)
 
 	BscanMarkerBase::loadState(markerTree);
 	BScanLayerSegPTree::parsePTree(markerTree, this);
+	fullSaveState = true;
 }
 
 void BScanLayerSegmentation::saveState(boost::property_tree::ptree& markerTree)
 {
 	BscanMarkerBase::saveState(markerTree);
-	BScanLayerSegPTree::fillPTree(markerTree, this);
+
+	const BScanLayerSegPTree::LineEncoding encoding = static_cast<BScanLayerSegPTree::LineEncoding>(ProgramOptions::layerSegLineEncoding());
+
+	lastSavedBScans.clear();
+	lastSaveStateFull = fullSaveState;
+	if(fullSaveState)
+		BScanLayerSegPTree::fillPTree(markerTree, this, encoding);
+
+	for(std::size_t bscanNr = 0; bscanNr < lines.size(); ++bscanNr)
+	{
+		BScanSegData& bscanData = lines[bscanNr];
+		if(!bscanData.changedSinceSaveState)
+			continue;
+
+		if(!fullSaveState)
+		{
+			BScanLayerSegPTree::fillPTree(markerTree, bscanNr, bscanData, encoding);
+			lastSavedBScans.push_back(bscanNr);
+		}
+		bscanData.changedSinceSaveState = false;
+	}
+	fullSaveState = false;
+}
+
+bool BScanLayerSegmentation::getLastSavedBScans(std::vector<std::size_t>& bscans) const
+{
+	if(lastSaveStateFull)
+		return false;
+	bscans = lastSavedBScans;
+	return true;
 }
 
 bool BScanLayerSegmentation::saveSegmentation2Bin(const std::string& filename)
@@ -560,7 +627,11 @@ bool BScanLayerSegmentation::saveSegmentation2Bin(const std::string& filename)
 
 std::size_t BScanLayerSegmentation::getMaxBscanWidth() const // TODO: Codedopplung mit IntervalMarker
 {
-	const OctData::Series* series = getSeries();
+	return getMaxBscanWidth(getSeries());
+}
+
+std::size_t BScanLayerSegmentation::getMaxBscanWidth(const OctData::Series* series)
+{
 	if(!series)
 		return 0;
 
@@ -35,6 +35,7 @@ class EditBase;
 class EditSpline;
 class EditPen;
 class Colormap;
+class ThicknessMap;
 class ThicknessmapLegend;
 
 class BScanLayerSegmentation : public BscanMarkerBase
@@ -52,6 +53,7 @@ public:
 		std::array<bool, std::tuple_size<OctData::Segmentationlines::SegLinesTypeList>::value> lineModified;
 		std::array<bool, std::tuple_size<OctData::Segmentationlines::SegLinesTypeList>::value> lineLoaded;
 		bool filled = false;
+		bool changedSinceSaveState = false;
 	};
 
 	class ThicknessmapConfig
@@ -85,6 +87,7 @@ public:
 
 	virtual void saveState(boost::property_tree::ptree& markerTree)  override;
 	virtual void loadState(boost::property_tree::ptree& markerTree)  override;
+	virtual bool getLastSavedBScans(std::vector<std::size_t>& bscans) const override;
 
 
 	virtual void setActBScan(std::size_t bscan) override;
@@ -105,6 +108,9 @@ public:
 	bool saveSegmentation2Bin(const std::string& filename);
 	void copyAllSegLinesFromOctData();
 
+	static void resetSegData(BScanSegData& segData, const OctData::BScan& bscan);
+	static std::size_t getMaxBscanWidth(const OctData::Series* series);
+
 	void setIconsToSimple(int size);
 
 	bool isSegmentationLinesVisible()                         const { return showSegmentationlines; }
@@ -144,7 +150,12 @@ private:
 	bool showThicknessmap      = true;
 	bool changeActBScan        = false;
 
+	bool fullSaveState     = true; // the tree is written completely on the next saveState, e.g. after loadState
+	bool lastSaveStateFull = true;
+	std::vector<std::size_t> lastSavedBScans;
+
 	cv::Mat* thicknesMapImage = nullptr;
+	ThicknessMap* thicknessMap = nullptr;
 
 	void copySegLinesFromOctDataWhenNotFilled();
 	void copySegLinesFromOctDataWhenNotFilled(std::size_t bscan);
@@ -156,6 +167,7 @@ private:
 
 	void rangeModified(std::size_t ascanBegin, std::size_t ascanEnd);
 	void modifiedSegPart(std::size_t bscan, OctData::Segmentationlines::SegmentlineType segLine, std::size_t start, const std::vector<double>& segPart, bool updateMethode);
+	bool updateThicknessmapBScan(std::size_t bscan, OctData::Segmentationlines::SegmentlineType segLine);
 	void updateEditLine();
 
 	std::vector<double> getSegPart(const std::vector<double>& segLine, std::size_t ascanBegin, std::size_t ascanEnd);
@@ -20,7 +20,6 @@
 
 #include"bscanlayersegmentation.h"
 
-#include<sstream>
 #include<iostream>
 
 #include <boost/property_tree/ptree.hpp>
@@ -28,11 +27,9 @@
 
 namespace bpt = boost::property_tree;
 
-#include<boost/spirit/include/qi.hpp>
-namespace qi = boost::spirit::qi;
-
 #include<octdata/datastruct/segmentationlines.h>
 #include <helper/ptreehelper.h>
+#include <data_structure/seglinecodec.h>
 
 
 
@@ -47,47 +44,27 @@ namespace
 		return true;
 	}
 
-	template<typename T>
-	std::vector<T> fillToVector(const bpt::ptree& pt)
+	// "Version" 2 only while encoded lines are stored, a tree with text lines stays readable by older versions
+	void updateVersion(bpt::ptree& ptree)
 	{
-		std::vector<T> r;
-
-		boost::optional<std::string> s = pt.get_value_optional<std::string>();
-		if(s)
+		for(const std::pair<const std::string, bpt::ptree>& bscanPair : ptree)
 		{
-			std::string::const_iterator f(s->begin()), l(s->end());
-			/*bool ok = */qi::parse(f,l,qi::double_ % ' ',r);
+			if(bscanPair.first == "BScan" && bscanPair.second.get_child_optional(SegLineCodec::encodedLinesNode))
+			{
+				ptree.put("Version", SegLineCodec::encodedVersion);
+				return;
+			}
 		}
-	    return r;
-	}
-
-	template<typename T>
-	void fillFromVector(bpt::ptree& pt, const std::vector<T>& vec)
-	{
-		pt.clear();
-
-		std::stringstream sstream;
-		for(const T& val : vec)
-			sstream << val << ' ';
-
-		pt.put_value(sstream.str());
+		ptree.erase("Version");
 	}
 
-}
-
 
-void BScanLayerSegPTree::fillPTree(boost::property_tree::ptree& ptree, const BScanLayerSegmentation* markerManager)
-{
-	ptree.clear(); // TODO
-
-	std::size_t bscan = 0;
-	for(const BScanLayerSegmentation::BScanSegData& bscanData : markerManager->lines)
+	void fillBScanNode(PTreeHelper::NodeCreator& bscanNode, const BScanLayerSegmentation::BScanSegData& bscanData, BScanLayerSegPTree::LineEncoding encoding)
 	{
 		const OctData::Segmentationlines& lines = bscanData.lines;
 
-		PTreeHelper::NodeCreator bscanNode("BScan", ptree);
-		bscanNode.setId(bscan);
-		PTreeHelper::NodeCreator linesNode("Lines", bscanNode);
+		PTreeHelper::NodeCreator linesNode    (SegLineCodec::linesNodeName(encoding), bscanNode);
+		PTreeHelper::NodeCreator textLinesNode(SegLineCodec::textLinesNode          , bscanNode); // lines the encoding can't hold
 
 		for(OctData::Segmentationlines::SegmentlineType type : OctData::Segmentationlines::getSegmentlineTypes())
 		{
@@ -102,38 +79,27 @@ void BScanLayerSegPTree::fillPTree(boost::property_tree::ptree& ptree, const BSc
 
 			if(!emptySegLine(line))
 			{
-				bpt::ptree& lineNode = PTreeHelper::get_put(linesNode.getNode(), name);
-				fillFromVector(lineNode, line);
+				std::string encoded;
+				PTreeHelper::NodeCreator* destNode = &linesNode;
+				if(!SegLineCodec::encode(line, encoding, encoded))
+				{
+					SegLineCodec::encode(line, BScanLayerSegPTree::LineEncoding::Text, encoded);
+					destNode = &textLinesNode;
+				}
+
+				bpt::ptree& lineNode = PTreeHelper::get_put(destNode->getNode(), name);
+				lineNode.clear();
+				lineNode.data().swap(encoded);
 			}
 		}
-
-		++bscan;
 	}
-}
 
-bool BScanLayerSegPTree::parsePTree(const boost::property_tree::ptree& ptree, BScanLayerSegmentation* markerManager)
-{
-
-	for(const std::pair<const std::string, const bpt::ptree>& bscanPair : ptree)
+	bool parseLinesNode(boost::optional<const bpt::ptree&> linesNode, BScanLayerSegmentation::BScanSegData& bscanData)
 	{
-		if(bscanPair.first != "BScan")
-			continue;
-
-		const bpt::ptree& bscanNode = bscanPair.second;
-		boost::optional<const bpt::ptree&> idNode = bscanNode.get_child_optional("ID");
-		if(!idNode)
-			continue;
-
-		int bscanId = idNode->get_value<int>(-1);
-		if(bscanId < 0 || static_cast<std::size_t>(bscanId) >= markerManager->lines.size())
-			continue;
-
-		boost::optional<const bpt::ptree&> linesNode = bscanNode.get_child_optional("Lines");
 		if(!linesNode)
-			continue;
-
-		BScanLayerSegmentation::BScanSegData& bscanData = markerManager->lines[bscanId];
+			return true;
 
+		bool result = true;
 		for(const std::pair<const std::string, const bpt::ptree>& segLinesNodePair : *linesNode)
 		{
 			const std::string& name = segLinesNodePair.first;
@@ -158,10 +124,97 @@ bool BScanLayerSegPTree::parsePTree(const boost::property_tree::ptree& ptree, BS
 				continue;
 			}
 
-			bscanData.lines.getSegmentLine(actType) = fillToVector<double>(segLinesNodePair.second);
+			std::vector<double> line;
+			if(!SegLineCodec::decode(segLinesNodePair.second.data(), line))
+			{
+				std::cerr << "invalid segmentation line: " << name << '\n';
+				result = false;
+				continue;
+			}
+
+			bscanData.lines.getSegmentLine(actType) = std::move(line);
 			bscanData.lineLoaded[static_cast<std::size_t>(actType)] = true;
 		}
+		return result;
+	}
+
+}
+
+
+void BScanLayerSegPTree::fillPTree(boost::property_tree::ptree& ptree, const BScanLayerSegmentation* markerManager, LineEncoding encoding)
+{
+	fillPTree(ptree, markerManager->lines, encoding);
+}
+
+bool BScanLayerSegPTree::parsePTree(const boost::property_tree::ptree& ptree, BScanLayerSegmentation* markerManager)
+{
+	return parsePTree(ptree, markerManager->lines);
+}
+
+
+void BScanLayerSegPTree::fillPTree(boost::property_tree::ptree& ptree, const std::vector<BScanLayerSegmentation::BScanSegData>& lines, LineEncoding encoding)
+{
+	ptree.clear(); // TODO
+
+	std::size_t bscan = 0;
+	for(const BScanLayerSegmentation::BScanSegData& bscanData : lines)
+	{
+		PTreeHelper::NodeCreator bscanNode("BScan", ptree);
+		bscanNode.setId(bscan);
+		fillBScanNode(bscanNode, bscanData, encoding);
+
+		++bscan;
+	}
+	updateVersion(ptree);
+}
+
+void BScanLayerSegPTree::fillPTree(boost::property_tree::ptree& ptree, std::size_t bscanNr, const BScanLayerSegmentation::BScanSegData& bscanData, LineEncoding encoding)
+{
+	const int bscanId = static_cast<int>(bscanNr);
+	bpt::ptree::iterator it = ptree.begin();
+	while(it != ptree.end())
+	{
+		if(it->first == "BScan" && it->second.get<int>("ID", -1) == bscanId)
+			it = ptree.erase(it);
+		else
+			++it;
+	}
+
+	PTreeHelper::NodeCreator bscanNode("BScan", ptree);
+	bscanNode.setId(bscanNr);
+	fillBScanNode(bscanNode, bscanData, encoding);
+	updateVersion(ptree);
+}
+
+bool BScanLayerSegPTree::parsePTree(const boost::property_tree::ptree& ptree, std::vector<BScanLayerSegmentation::BScanSegData>& lines)
+{
+	if(ptree.get<int>("Version", 0) > SegLineCodec::encodedVersion)
+	{
+		std::cerr << "unsupported layer segmentation version: " << ptree.get<int>("Version", 0) << '\n';
+		return false;
+	}
+
+	bool result = true;
+	for(const std::pair<const std::string, const bpt::ptree>& bscanPair : ptree)
+	{
+		if(bscanPair.first != "BScan")
+			continue;
+
+		const bpt::ptree& bscanNode = bscanPair.second;
+		boost::optional<const bpt::ptree&> idNode = bscanNode.get_child_optional("ID");
+		if(!idNode)
+			continue;
+
+		int bscanId = idNode->get_value<int>(-1);
+		if(bscanId < 0 || static_cast<std::size_t>(bscanId) >= lines.size())
+			continue;
+
+		BScanLayerSegmentation::BScanSegData& bscanData = lines[bscanId];
+		if(!parseLinesNode(bscanNode.get_child_optional(SegLineCodec::textLinesNode   ), bscanData))
+			result = false;
+		if(!parseLinesNode(bscanNode.get_child_optional(SegLineCodec::encodedLinesNode), bscanData))
+			result = false;
 	}
 
-	return true;
+	return result;
 }
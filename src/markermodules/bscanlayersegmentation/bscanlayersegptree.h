@@ -21,13 +21,23 @@
 
 #include <boost/property_tree/ptree_fwd.hpp>
 
-class BScanLayerSegmentation;
+#include"bscanlayersegmentation.h"
+#include<data_structure/seglinecodec.h>
 
 class BScanLayerSegPTree
 {
 public:
+	// encoded lines are stored in "EncodedLines" and marked by the module node "Version" 2, newer versions are refused
+	typedef SegLineCodec::Encoding LineEncoding;
+
 	static bool parsePTree(const boost::property_tree::ptree& ptree,       BScanLayerSegmentation* markerManager);
-	static void fillPTree (      boost::property_tree::ptree& ptree, const BScanLayerSegmentation* markerManager);
+	static void fillPTree (      boost::property_tree::ptree& ptree, const BScanLayerSegmentation* markerManager, LineEncoding encoding = LineEncoding::Text);
+
+	static bool parsePTree(const boost::property_tree::ptree& ptree,       std::vector<BScanLayerSegmentation::BScanSegData>& lines);
+	static void fillPTree (      boost::property_tree::ptree& ptree, const std::vector<BScanLayerSegmentation::BScanSegData>& lines, LineEncoding encoding = LineEncoding::Text);
+
+	// replaces the node of one b-scan
+	static void fillPTree (      boost::property_tree::ptree& ptree, std::size_t bscanNr, const BScanLayerSegmentation::BScanSegData& bscanData, LineEncoding encoding = LineEncoding::Text);
 };
 
 #endif // BSCANLAYERSEGPTREE_H
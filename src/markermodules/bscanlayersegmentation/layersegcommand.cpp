@@ -68,3 +68,8 @@ bool LayerSegCommand::redo()
 	parent->modifiedSegPart(bscanNr, type, startPos, newPart);
 	return true;
 }
+
+std::size_t LayerSegCommand::getMemorySize() const
+{
+	return sizeof(LayerSegCommand) + (newPart.capacity() + oldPart.capacity())*sizeof(double);
+}
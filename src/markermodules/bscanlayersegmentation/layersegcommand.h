@@ -46,6 +46,8 @@ public:
 	virtual void apply() override;
 	virtual bool undo()  override;
 	virtual bool redo()  override;
+
+	virtual std::size_t getMemorySize() const override;
 };
 
 #endif // LAYERSEGCOMMAND_H
@@ -28,11 +28,13 @@
 
 bool LayerSegmentationIO::saveSegmentation2Bin(const BScanLayerSegmentation& marker, const std::string& filename)
 {
+	return saveSegmentation2Bin(marker.lines, marker.getMaxBscanWidth(), filename);
+}
 
-	const std::vector<BScanLayerSegmentation::BScanSegData>& lines = marker.lines;
-
-	const int numBscans     = static_cast<int>(lines.size()             );
-	const int maxBscanWidth = static_cast<int>(marker.getMaxBscanWidth());
+bool LayerSegmentationIO::saveSegmentation2Bin(const std::vector<BScanLayerSegmentation::BScanSegData>& lines, std::size_t maxWidth, const std::string& filename)
+{
+	const int numBscans     = static_cast<int>(lines.size());
+	const int maxBscanWidth = static_cast<int>(maxWidth    );
 
 	std::map<const char*, cv::Mat> segmentationMats;
 
@@ -21,12 +21,13 @@
 
 #include<string>
 
-class BScanLayerSegmentation;
+#include"bscanlayersegmentation.h"
 
 class LayerSegmentationIO
 {
 public:
 	static bool saveSegmentation2Bin(const BScanLayerSegmentation& marker, const std::string& filename);
+	static bool saveSegmentation2Bin(const std::vector<BScanLayerSegmentation::BScanSegData>& lines, std::size_t maxBscanWidth, const std::string& filename);
 };
 
 #endif // LAYERSEGMENTATIONIO_H
@@ -21,20 +21,15 @@
 
 #define _USE_MATH_DEFINES
 
-#include<map>
 #include<limits>
 #include<cmath>
+#include<algorithm>
 
 #include<opencv/cv.hpp>
 
-#include<octdata/datastruct/series.h>
-#include<octdata/datastruct/bscan.h>
-#include<octdata/datastruct/sloimage.h>
+#include<helper/parallelfor.h>
 
-#include<helper/convertcolorspace.h>
-
-#include<data_structure/matrx.h>
-#include<data_structure/point2d.h>
+#include<data_structure/slointerpolationoperator.h>
 #include<data_structure/programoptions.h>
 
 #include"colormaphsv.h"
@@ -43,10 +38,17 @@
 using Segmentline         = OctData::Segmentationlines::Segmentline;
 using SegmentlineDataType = OctData::Segmentationlines::SegmentlineDataType;
 
+namespace
+{
+	constexpr std::size_t colorLUTSize   = 4096;
+	constexpr std::size_t colorBlockSize = 256;
+}
+
 
 
 ThicknessMap::ThicknessMap()
 : thicknessMap(new cv::Mat)
+, sloThickness(new cv::Mat)
 {
 }
 
@@ -55,6 +57,7 @@ ThicknessMap::ThicknessMap()
 ThicknessMap::~ThicknessMap()
 {
 	delete thicknessMap;
+	delete sloThickness;
 }
 
 
@@ -66,152 +69,142 @@ void ThicknessMap::createMap(const SloBScanDistanceMap& distMap
                            , double scaleFactor
                            , const Colormap& colormap)
 {
-	const SloBScanDistanceMap::PreCalcDataMatrix* distMatrix = distMap.getDataMatrix();
+	resetThicknessMapCache();
 
-	if(!distMatrix)
+	interpolation = distMap.getInterpolationOperator();
+	if(!interpolation)
 		return;
+	interpolationGeneration = interpolation->getGeneration();
 
-	bool blendColor = ProgramOptions::layerSegThicknessmapBlend();
+	this->t1            = t1;
+	this->t2            = t2;
+	this->scaleFactor   = scaleFactor;
+	blendColor          = ProgramOptions::layerSegThicknessmapBlend();
 
-	const std::size_t sizeX = distMatrix->getSizeX();
-	const std::size_t sizeY = distMatrix->getSizeY();
+	const std::size_t sizeX = interpolation->getSizeX();
+	const std::size_t sizeY = interpolation->getSizeY();
 
-	fillLineVec(lines, t1, t2);
+	fillThicknessValues(lines);
+	createColorLUT(colormap);
 
+	sloThickness->create(static_cast<int>(sizeY), static_cast<int>(sizeX), CV_32FC1);
 	thicknessMap->create(static_cast<int>(sizeY), static_cast<int>(sizeX), CV_8UC4);
 
-	for(std::size_t y = 0; y < sizeY; ++y)
+	parallelFor(sizeY, [&](std::size_t y)
 	{
-		uint8_t* destPtr = thicknessMap->ptr<uint8_t>(static_cast<int>(y));
-		const SloBScanDistanceMap::PreCalcDataMatrix::value_type* srcPtr = distMatrix->scanLine(y);
-
-		for(std::size_t x = 0; x < sizeX; ++x)
-		{
-			if(srcPtr->init)
-			{
-				double value;
-				if(blendColor) value = getMixValue(*srcPtr);
-				else           value = getSingleValue(*srcPtr);
-
-				if(value < 0.)
-				{
-					destPtr[0] = 0;
-					destPtr[1] = 0;
-					destPtr[2] = 0;
-					destPtr[3] = 0;
-				}
-				else
-				{
-					double mixThickness = value*scaleFactor;
-
-					colormap.getColor(mixThickness, destPtr[2], destPtr[1], destPtr[0]);
-					destPtr[3] = 255;
-				}
-
-			}
-			else
-			{
-				destPtr[0] = 0;
-				destPtr[1] = 0;
-				destPtr[2] = 0;
-				destPtr[3] = 0;
-			}
-
-			destPtr += 4;
-			++srcPtr;
-		}
-
-	}
-}
-
-double ThicknessMap::getSingleValue(const SloBScanDistanceMap::PixelInfo& pinfo) const
-{
-	const SloBScanDistanceMap::InfoBScanDist& bInfo1 = pinfo.bscan1;
-	const double height = getValue(bInfo1);
-	if(std::isnan(height))
-		return -1;
-	return height;
+		calcSloThickness(y, 0, sizeX);
+		colorize        (y, 0, sizeX);
+	});
 }
 
 
-double ThicknessMap::getMixValue(const SloBScanDistanceMap::PixelInfo& pinfo) const
+bool ThicknessMap::updateBScan(const SloBScanDistanceMap& distMap
+                             , const std::vector<BScanLayerSegmentation::BScanSegData>& lines
+                             , std::size_t bscanNr)
 {
-	const SloBScanDistanceMap::InfoBScanDist& bInfo1 = pinfo.bscan1;
-	const SloBScanDistanceMap::InfoBScanDist& bInfo2 = pinfo.bscan2;
-
-	const double h1 = getValue(bInfo1);
-	if(std::isnan(h1) || h1 < 0)
-		return -1;
+	const SloInterpolationOperator* actInterpolation = distMap.getInterpolationOperator();
+	if(interpolationGeneration == 0 || !actInterpolation || actInterpolation->getGeneration() != interpolationGeneration || bscanNr >= lines.size())
+		return false;
+	interpolation = actInterpolation;
 
-	if(bInfo1.distance == 0)
-		return h1;
+	if(bscanNr >= interpolation->getNumBScans())
+		return true;
 
-	const double h2 = getValue(bInfo2);
-	if(std::isnan(h2) || h2 < 0)
-		return h1;
+	fillThicknessBScan(lines[bscanNr], bscanNr);
 
-	const double l = bInfo1.distance + bInfo2.distance;
-	if(l == 0)
-		return h1;
-
-	const double w1 = bInfo2.distance/l;
-	const double w2 = bInfo1.distance/l;
+	const SloInterpolationOperator::PixelRun* const runsEnd = interpolation->getPixelRunsEnd(bscanNr);
+	for(const SloInterpolationOperator::PixelRun* run = interpolation->getPixelRunsBegin(bscanNr); run != runsEnd; ++run)
+	{
+		calcSloThickness(run->y, run->xBegin, run->xEnd);
+		colorize        (run->y, run->xBegin, run->xEnd);
+	}
+	return true;
+}
 
-	const double result = h1*w1 + h2*w2;
 
-	return result;
+void ThicknessMap::calcSloThickness(std::size_t y, std::size_t xBegin, std::size_t xEnd)
+{
+	float* const dest = sloThickness->ptr<float>(static_cast<int>(y));
+	if(blendColor) interpolation->interpolate  (thicknessValues.data(), y, xBegin, xEnd, dest);
+	else           interpolation->gatherNearest(thicknessValues.data(), y, xBegin, xEnd, dest);
 }
 
 
-inline double ThicknessMap::getValue(const SloBScanDistanceMap::InfoBScanDist& info) const
+bool ThicknessMap::recolor(OctData::Segmentationlines::SegmentlineType t1
+                         , OctData::Segmentationlines::SegmentlineType t2
+                         , const Colormap& colormap)
 {
-	const std::size_t ascan = info.ascan;
-	const std::size_t bscan = info.bscan;
+	if(interpolationGeneration == 0 || t1 != this->t1 || t2 != this->t2)
+		return false;
 
-	if(ascan >= thicknessMatrix.getSizeX() || bscan >= thicknessMatrix.getSizeY())
-		return std::numeric_limits<double>::quiet_NaN();
+	createColorLUT(colormap);
 
-	return thicknessMatrix(ascan, bscan);
+	const std::size_t sizeX = static_cast<std::size_t>(sloThickness->cols);
+	parallelFor(static_cast<std::size_t>(sloThickness->rows), [&](std::size_t y)
+	{
+		colorize(y, 0, sizeX);
+	});
+	return true;
 }
 
 
-
-void ThicknessMap::initThicknessMatrix(const std::vector<BScanLayerSegmentation::BScanSegData>& lines, OctData::Segmentationlines::SegmentlineType t1, OctData::Segmentationlines::SegmentlineType t2)
+void ThicknessMap::createColorLUT(const Colormap& colormap)
 {
-	const std::size_t numBscans = lines.size();
-	std::size_t maxAscanNum = 0;
+	const double maxValue = colormap.getMaxValue();
+	const double step     = maxValue > 0 ? maxValue/static_cast<double>(colorLUTSize - 1) : 0;
 
-	for(const BScanLayerSegmentation::BScanSegData& segData : lines)
-	{
-		const OctData::Segmentationlines::Segmentline* l1 = nullptr;
-		const OctData::Segmentationlines::Segmentline* l2 = nullptr;
-		if(segData.filled)
-		{
-			l1 = &(segData.lines.getSegmentLine(t1));
-			l2 = &(segData.lines.getSegmentLine(t2));
+	colorLUTMaxValue = static_cast<float>(maxValue);
+	colorLUTScale    = maxValue > 0 ? static_cast<float>(1./step) : 0.f;
 
-			const std::size_t numAscans = std::min(l1->size(), l2->size());
-			if(numAscans > maxAscanNum)
-				maxAscanNum = numAscans;
-		}
+	colorLUT.assign(colorLUTSize + 2, Color());
+	for(std::size_t i = 0; i < colorLUTSize; ++i)
+	{
+		Color& color = colorLUT[i];
+		colormap.getColor(static_cast<double>(i)*step, color.r, color.g, color.b);
+		color.a = 255;
 	}
 
-	thicknessMatrix.resize(maxAscanNum, numBscans);
+	Color& colorAbove = colorLUT[colorLUTSize];
+	colormap.getColor(maxValue + 1, colorAbove.r, colorAbove.g, colorAbove.b);
+	colorAbove.a = 255;
 }
 
-void ThicknessMap::fillLineVec(const std::vector<BScanLayerSegmentation::BScanSegData>& lines
-                             , OctData::Segmentationlines::SegmentlineType t1
-                             , OctData::Segmentationlines::SegmentlineType t2)
+
+void ThicknessMap::colorize(std::size_t y, std::size_t xBegin, std::size_t xEnd)
 {
-	initThicknessMatrix(lines, t1, t2);
-	std::size_t nrBscan = 0;
-	for(const BScanLayerSegmentation::BScanSegData& segData : lines)
+	const float* const thicknessLine = sloThickness->ptr<float>(static_cast<int>(y));
+	Color*       const destLine      = thicknessMap->ptr<Color>(static_cast<int>(y));
+	const Color* const lut           = colorLUT.data();
+
+	const float    maxValue   = colorLUTMaxValue;
+	const float    scale      = colorLUTScale;
+	const uint32_t maxIndex   = static_cast<uint32_t>(colorLUTSize - 1);
+	const uint16_t aboveIndex = static_cast<uint16_t>(colorLUTSize    );
+	const uint16_t nanIndex   = static_cast<uint16_t>(colorLUTSize + 1);
+
+	// quantize a block without branches, then gather the colors of the block
+	uint16_t indices[colorBlockSize];
+	for(std::size_t blockBegin = xBegin; blockBegin < xEnd; blockBegin += colorBlockSize)
 	{
-		fillThicknessBscan(segData, nrBscan, t1, t2);
-		++nrBscan;
+		const std::size_t blockLength = std::min(colorBlockSize, xEnd - blockBegin);
+		const float* const thickness = thicknessLine + blockBegin;
+
+		for(std::size_t i = 0; i < blockLength; ++i)
+		{
+			const float    value   = thickness[i];
+			const bool     inRange = value <= maxValue; // false for NaN
+			const float    clamped = inRange ? std::max(value, 0.f) : 0.f;
+			const uint32_t index   = std::min(static_cast<uint32_t>(clamped*scale + 0.5f), maxIndex);
+			indices[i] = inRange ? static_cast<uint16_t>(index) : (value == value ? aboveIndex : nanIndex);
+		}
+
+		Color* const dest = destLine + blockBegin;
+		for(std::size_t i = 0; i < blockLength; ++i)
+			dest[i] = lut[indices[i]];
 	}
 }
 
+
 namespace
 {
 	double getValue(const double* const line, std::size_t index)
@@ -223,40 +216,44 @@ namespace
 	}
 }
 
-void ThicknessMap::fillThicknessBscan(const BScanLayerSegmentation::BScanSegData& bscanData, const std::size_t bscanNr, OctData::Segmentationlines::SegmentlineType t1, OctData::Segmentationlines::SegmentlineType t2)
+void ThicknessMap::fillThicknessValues(const std::vector<BScanLayerSegmentation::BScanSegData>& lines)
 {
-	double* const scanline = thicknessMatrix.scanLine(bscanNr);
-	const std::size_t maxAscanNum = thicknessMatrix.getSizeX();
+	thicknessValues.assign(interpolation->getValueCount(), std::numeric_limits<float>::quiet_NaN());
+
+	const std::size_t numBscans = std::min(lines.size(), interpolation->getNumBScans());
+	for(std::size_t bscanNr = 0; bscanNr < numBscans; ++bscanNr)
+		fillThicknessBScan(lines[bscanNr], bscanNr);
+}
 
-	std::size_t filledAscans = 0;
-	if(bscanData.filled)
+
+void ThicknessMap::fillThicknessBScan(const BScanLayerSegmentation::BScanSegData& bscanData, std::size_t bscanNr)
+{
+	const std::size_t numAscansOperator = interpolation->getNumAScans(bscanNr);
+	float* const values = thicknessValues.data() + interpolation->getValueIndex(bscanNr, 0);
+	std::fill(values, values + numAscansOperator, std::numeric_limits<float>::quiet_NaN());
+
+	if(!bscanData.filled)
+		return;
+
+	const Segmentline& l1 = bscanData.lines.getSegmentLine(t1);
+	const Segmentline& l2 = bscanData.lines.getSegmentLine(t2);
+
+	const std::size_t numAscans = std::min(std::min(l1.size(), l2.size()), numAscansOperator);
+
+	const double* const l1data = l1.data();
+	const double* const l2data = l2.data();
+
+	for(std::size_t i = 0; i < numAscans; ++i)
 	{
-		const OctData::Segmentationlines::Segmentline* l1 = &(bscanData.lines.getSegmentLine(t1));
-		const OctData::Segmentationlines::Segmentline* l2 = &(bscanData.lines.getSegmentLine(t2));
-		if(l1 && l2)
-		{
-			const std::size_t numAscans = std::min(std::min(l1->size(), l2->size()), maxAscanNum);
-
-			const double* const l1data = l1->data();
-			const double* const l2data = l2->data();
-
-			for(std::size_t i = 0; i < numAscans; ++i)
-			{
-				const double v1 = ::getValue(l1data, i);
-				const double v2 = ::getValue(l2data, i);
-				if(std::isnan(v1) || std::isnan(v2))
-					scanline[i] = std::numeric_limits<double>::quiet_NaN();
-				else
-					scanline[i] = v2 - v1;
-			}
-			filledAscans = numAscans;
-		}
+		const double thickness = ::getValue(l2data, i) - ::getValue(l1data, i);
+		if(thickness >= 0) // false for NaN
+			values[i] = static_cast<float>(thickness*scaleFactor);
 	}
-	for(std::size_t i = filledAscans; i < maxAscanNum; ++i)
-		scanline[i] = std::numeric_limits<double>::quiet_NaN();
 }
 
 
 void ThicknessMap::resetThicknessMapCache()
 {
+	interpolation           = nullptr;
+	interpolationGeneration = 0;
 }
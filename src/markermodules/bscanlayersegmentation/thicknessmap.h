@@ -20,16 +20,16 @@
 #define THICKNESSMAP_H
 
 #include<vector>
+#include<cstdint>
 
 #include "bscanlayersegmentation.h"
 
-#include<data_structure/matrx.h>
 #include<data_structure/slobscandistancemap.h>
-#include<limits>
 
 #include<octdata/datastruct/segmentationlines.h>
 
 class Colormap;
+class SloInterpolationOperator;
 namespace cv { class Mat; }
 
 class ThicknessMap
@@ -52,29 +52,61 @@ public:
 	             , double scaleFactor
                  , const Colormap& colormap);
 
+	/**
+	 * recalculates only the slo pixels which refer to an a-scan of the b-scan, with the parameters of the last createMap
+	 * returns false if the map was not created from this distance map, then a new createMap is necessary
+	 */
+	bool updateBScan(const SloBScanDistanceMap& distanceMap
+	               , const std::vector<BScanLayerSegmentation::BScanSegData>& lines
+	               , std::size_t bscanNr);
+
+	/**
+	 * colors the cached thickness image again with a changed colormap or changed color limits
+	 * returns false if there is no thickness image of the layers t1 and t2, then a new createMap is necessary
+	 */
+	bool recolor(OctData::Segmentationlines::SegmentlineType t1
+	           , OctData::Segmentationlines::SegmentlineType t2
+	           , const Colormap& colormap);
+
 	const cv::Mat& getThicknessMap() const { return *thicknessMap; }
 
 private:
 	cv::Mat* thicknessMap = nullptr;
-
-	double getSingleValue(const SloBScanDistanceMap::PixelInfo& pinfo) const;
-	double getMixValue(const SloBScanDistanceMap::PixelInfo& pinfo) const;
-	double getValue(const SloBScanDistanceMap::InfoBScanDist& info) const;
-
-	void fillLineVec(const std::vector<BScanLayerSegmentation::BScanSegData>& lines
-	               , OctData::Segmentationlines::SegmentlineType t1
-	               , OctData::Segmentationlines::SegmentlineType t2);
-
-	void fillThicknessBscan(const BScanLayerSegmentation::BScanSegData& bscan
-	                      , const std::size_t bscanNr
-	                      , OctData::Segmentationlines::SegmentlineType t1
-	                      , OctData::Segmentationlines::SegmentlineType t2);
-
-	void initThicknessMatrix(const std::vector<BScanLayerSegmentation::BScanSegData>& lines
-	                       , OctData::Segmentationlines::SegmentlineType t1
-	                       , OctData::Segmentationlines::SegmentlineType t2);
-
-	Matrix<double> thicknessMatrix;
+	cv::Mat* sloThickness = nullptr;
+
+	// same layout as a CV_8UC4 (BGRA) pixel
+	struct Color
+	{
+		uint8_t b = 0;
+		uint8_t g = 0;
+		uint8_t r = 0;
+		uint8_t a = 0;
+	};
+	static_assert(sizeof(Color) == 4, "Color has to match a CV_8UC4 pixel");
+
+	// parameters of the last createMap
+	const SloInterpolationOperator* interpolation = nullptr;
+	std::size_t interpolationGeneration = 0; // 0: no cached map, compared instead of the pointer of an operator which can be deleted
+	OctData::Segmentationlines::SegmentlineType t1;
+	OctData::Segmentationlines::SegmentlineType t2;
+	double scaleFactor = 1;
+	bool blendColor = false;
+
+	// thickness of every a-scan in value order of the interpolation operator, NaN for unknown or negative thickness
+	std::vector<float> thicknessValues;
+
+	// colors of equidistant thickness steps in [0, colorLUTMaxValue], followed by the color above colorLUTMaxValue and the transparent color for NaN
+	std::vector<Color> colorLUT;
+	float colorLUTMaxValue = 0;
+	float colorLUTScale    = 0;
+
+	void createColorLUT(const Colormap& colormap);
+
+	void fillThicknessValues(const std::vector<BScanLayerSegmentation::BScanSegData>& lines);
+	void fillThicknessBScan(const BScanLayerSegmentation::BScanSegData& bscanData, std::size_t bscanNr);
+
+	void calcSloThickness(std::size_t y, std::size_t xBegin, std::size_t xEnd);
+	void colorize        (std::size_t y, std::size_t xBegin, std::size_t xEnd);
 };
 
 #endif // THICKNESSMAP_H
@@ -174,11 +174,19 @@ bool BscanMarkerBase::drawSLOOverlayImage(const cv::Mat& sloImage, cv::Mat& outS
 void BscanMarkerBase::addUndoCommand(MarkerCommand* command)
 {
 	clearRedo();
-	undoList.push_back(command);
+	pushUndoCommand(command);
 
 	undoRedoChanged();
 }
 
+void BscanMarkerBase::pushUndoCommand(MarkerCommand* command)
+{
+	const std::size_t memorySize = command->getMemorySize();
+	undoList.push_back(command);
+	undoMemorySizes.push_back(memorySize);
+	undoMemorySize += memorySize;
+}
+
 void BscanMarkerBase::callRedoStep()
 {
 	if(redoList.size() == 0)
@@ -191,7 +199,7 @@ void BscanMarkerBase::callRedoStep()
 	if(!command->redo())
 		return;
 
-	undoList.push_back(command);
+	pushUndoCommand(command);
 	redoList.pop_back();
 
 	undoRedoChanged();
@@ -211,6 +219,8 @@ void BscanMarkerBase::callUndoStep()
 
 	redoList.push_back(command);
 	undoList.pop_back();
+	undoMemorySize -= undoMemorySizes.back();
+	undoMemorySizes.pop_back();
 
 	undoRedoChanged();
 }
@@ -221,6 +231,8 @@ void BscanMarkerBase::clearUndoRedo()
 	for(MarkerCommand* command : undoList)
 		delete command;
 	undoList.clear();
+	undoMemorySizes.clear();
+	undoMemorySize = 0;
 
 	undoRedoChanged();
 }
@@ -232,6 +244,18 @@ void BscanMarkerBase::clearRedo()
 	redoList.clear();
 }
 
+bool BscanMarkerBase::removeOldestUndoCommand()
+{
+	if(undoList.empty())
+		return false;
+
+	delete undoList.front();
+	undoList.erase(undoList.begin());
+	undoMemorySize -= undoMemorySizes.front();
+	undoMemorySizes.erase(undoMemorySizes.begin());
+	return true;
+}
+
 bool BscanMarkerBase::checkBScan(MarkerCommand* command)
 {
 	int bscan = command->getBScan();
@@ -106,6 +106,9 @@ public:
 	
 	virtual void activate(bool);
 	virtual void saveState(boost::property_tree::ptree&)            {}
+	// incremental save: the b-scans ("BScan" nodes with "ID"), which the last saveState has rewritten, false: the whole subtree was written
+	virtual bool getLastSavedBScans(std::vector<std::size_t>&) const
+	                                                                { return false; }
 	virtual void loadState(boost::property_tree::ptree&)            { clearUndoRedo(); }
 	
 	virtual void newSeriesLoaded(const OctData::Series*, boost::property_tree::ptree&)
@@ -114,6 +117,10 @@ public:
 	std::size_t numUndoSteps()                                const { return undoList.size(); }
 	std::size_t numRedoSteps()                                const { return redoList.size(); }
 
+	std::size_t getUndoMemorySize()                           const { return undoMemorySize; } // redo steps are not counted, they are removed with the next change
+	const MarkerCommand* getOldestUndoCommand()               const { return undoList.empty() ? nullptr : undoList.front(); }
+	bool removeOldestUndoCommand();
+
 
 	std::size_t getActBScanNr() const;
 
@@ -156,6 +163,10 @@ protected:
 	std::vector<MarkerCommand*> redoList;
 
 private:
+	std::vector<std::size_t> undoMemorySizes; // of the undo steps, when they were added (the size of a command can change with undo and redo)
+	std::size_t undoMemorySize = 0;
+
+	void pushUndoCommand(MarkerCommand* command);
 	void clearRedo();
 	bool checkBScan(MarkerCommand* command);
 };
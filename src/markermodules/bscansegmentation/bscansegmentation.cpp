@@ -883,17 +883,38 @@ void BScanSegmentation::createUndoStep()
 {
 	if(actMat && segments.size() > actMatNr)
 	{
+		SimpleCvMatCompress& actSegment = *(segments[actMatNr]);
+
+		// store and re-encode only the changed region if the size is unchanged
+		int diffX;
+		int diffY;
+		SimpleCvMatCompress diff;
+		if(actSegment.createXorDiff(*actMat, diffX, diffY, diff))
+		{
+			if(diff.getRows() == 0)
+				return;
+
+			stateChangedSinceLastSave = true;
+
+			const int endRow = diffY + diff.getRows();
+			FreeFormSegCommand* command = new FreeFormSegCommand(*this, diffX, diffY, std::move(diff));
+			addUndoCommand(command);
+
+			actSegment.patchRows(*actMat, diffY, endRow);
+			return;
+		}
+
 		SimpleCvMatCompress newMat;
 		newMat.readFromMat(*actMat);
 
-		if((*segments[actMatNr]) != newMat)
+		if(actSegment != newMat)
 		{
 			stateChangedSinceLastSave = true;
 
-			FreeFormSegCommand* command = new FreeFormSegCommand(*this, *(segments[actMatNr]));
+			FreeFormSegCommand* command = new FreeFormSegCommand(*this, actSegment);
 			addUndoCommand(command);
 
-			*(segments[actMatNr]) = newMat;
+			actSegment = newMat;
 		}
 	}
 }
@@ -918,6 +939,20 @@ bool BScanSegmentation::swapActMat(SimpleCvMatCompress& otherMat)
 }
 
 
+bool BScanSegmentation::applyActMatDiff(int x, int y, const SimpleCvMatCompress& diff)
+{
+	if(!actMat || segments.size() <= actMatNr)
+		return false;
+
+	if(!segments[actMatNr]->applyXorDiff(*actMat, x, y, diff))
+		return false;
+
+	updateAreaImage(QRect(x, y, diff.getCols(), diff.getRows()));
+	requestFullUpdate();
+	return true;
+}
+
+
 bool BScanSegmentation::hasActMatChanged() const
 {
 	if(actMat && segments.size() > actMatNr)
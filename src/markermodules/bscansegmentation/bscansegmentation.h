@@ -148,6 +148,7 @@ public:
 
 	BScanSegmentationMarker::LocalMethod getLocalMethod() const     { return localMethod; }
 	bool swapActMat(SimpleCvMatCompress& otherMat);
+	bool applyActMatDiff(int x, int y, const SimpleCvMatCompress& diff);
 
 	void createUndoStep();
 
@@ -40,6 +40,8 @@ namespace bpt = boost::property_tree;
 #include "bscansegmentation.h"
 
 #include <data_structure/simplecvmatcompress.h>
+#include <helper/base64.h>
+#include <data_structure/programoptions.h>
 
 
 
@@ -68,8 +70,16 @@ bool BScanSegmentationPtree::parsePTree(const boost::property_tree::ptree& ptree
 			if(!compressedMat)
 				continue;
 
-			boost::optional<const bpt::ptree&> matCompressNode = bscanNode.get_child_optional("matCompress");
-			if(matCompressNode)
+			boost::optional<const bpt::ptree&> matCompressBinNode = bscanNode.get_child_optional("matCompressBin");
+			boost::optional<const bpt::ptree&> matCompressNode    = bscanNode.get_child_optional("matCompress");
+			if(matCompressBinNode)
+			{
+				const std::string& encoded = matCompressBinNode->data();
+				std::string binary;
+				if(Base64::decode(encoded.data(), encoded.size(), binary))
+					compressedMat->readBinary(binary.data(), binary.size());
+			}
+			else if(matCompressNode)
 			{
 				std::string serializationString = matCompressNode->get_value<std::string>("");
 
@@ -96,6 +106,9 @@ bool BScanSegmentationPtree::parsePTree(const boost::property_tree::ptree& ptree
 
 void BScanSegmentationPtree::fillPTree(boost::property_tree::ptree& markerTree, const BScanSegmentation* markerManager)
 {
+	// "matCompressBin" is not read by older versions
+	const bool binaryStorage = ProgramOptions::freeFormedSegmetationBinaryStorage();
+
 	markerTree.erase("ILM");
 	bpt::ptree& ilmTree = markerTree.put("ILM", std::string());
 
@@ -109,15 +122,27 @@ void BScanSegmentationPtree::fillPTree(boost::property_tree::ptree& markerTree,
 			if(compressedMat->isEmpty(BScanSegmentationMarker::paintArea0Value))
 				continue;
 
-			std::stringstream ofs;
-			boost::archive::text_oarchive oa(ofs);
-			// write class instance to archive
-			oa << *compressedMat;
-
 			std::string nodeName = "BScan";
 			bpt::ptree& bscanNode = ilmTree.add(nodeName, "");
 			bscanNode.add("ID", boost::lexical_cast<std::string>(bscan));
-			bscanNode.put("matCompress", ofs.str());
+
+			if(binaryStorage)
+			{
+				std::string binary;
+				compressedMat->writeBinary(binary);
+
+				std::string& encoded = bscanNode.put("matCompressBin", std::string()).data();
+				Base64::encode(binary.data(), binary.size(), encoded);
+			}
+			else
+			{
+				std::stringstream ofs;
+				boost::archive::text_oarchive oa(ofs);
+				// write class instance to archive
+				oa << *compressedMat;
+
+				bscanNode.put("matCompress", ofs.str());
+			}
 		}
 	}
 }
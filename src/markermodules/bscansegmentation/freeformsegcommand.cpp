@@ -19,6 +19,8 @@
 
 #include "freeformsegcommand.h"
 
+#include<utility>
+
 #include<data_structure/simplecvmatcompress.h>
 
 #include"bscansegmentation.h"
@@ -32,6 +34,18 @@ FreeFormSegCommand::FreeFormSegCommand(BScanSegmentation& parent, const SimpleCv
 }
 
 
+FreeFormSegCommand::FreeFormSegCommand(BScanSegmentation& parent, int x, int y, SimpleCvMatCompress&& diff)
+: parent(parent)
+, segmentationMat(new SimpleCvMatCompress(std::move(diff)))
+, bscanNr(parent.getActBScanNr())
+, isDiff(true)
+, diffX(x)
+, diffY(y)
+{
+	MarkerCommand::bscan = static_cast<int>(bscanNr);
+}
+
+
 FreeFormSegCommand::~FreeFormSegCommand()
 {
 	delete segmentationMat;
@@ -43,12 +57,24 @@ void FreeFormSegCommand::apply()
 
 }
 
-bool FreeFormSegCommand::undo()
+bool FreeFormSegCommand::swapState()
 {
+	if(isDiff)
+		return parent.applyActMatDiff(diffX, diffY, *segmentationMat);
 	return parent.swapActMat(*segmentationMat);
 }
 
+bool FreeFormSegCommand::undo()
+{
+	return swapState();
+}
+
 bool FreeFormSegCommand::redo()
 {
-	return parent.swapActMat(*segmentationMat);
+	return swapState();
+}
+
+std::size_t FreeFormSegCommand::getMemorySize() const
+{
+	return sizeof(FreeFormSegCommand) + segmentationMat->getMemorySize();
 }
@@ -29,12 +29,21 @@ class SimpleCvMatCompress;
 class FreeFormSegCommand : public MarkerCommand
 {
 	BScanSegmentation& parent;
-	SimpleCvMatCompress* segmentationMat;
+	SimpleCvMatCompress* segmentationMat;   // full state or xor diff
 
 	std::size_t bscanNr;
 
+	bool isDiff = false;
+	int  diffX  = 0;
+	int  diffY  = 0;
+
+	bool swapState();
+
 public:
+	// stores the complete old state
 	FreeFormSegCommand(BScanSegmentation& parent, const SimpleCvMatCompress& mat);
+	// stores only the xor diff between old and new state of the rect (x, y, diff size)
+	FreeFormSegCommand(BScanSegmentation& parent, int x, int y, SimpleCvMatCompress&& diff);
 	~FreeFormSegCommand();
 
 	FreeFormSegCommand(const FreeFormSegCommand &other)            = delete;
@@ -44,6 +53,8 @@ public:
 	virtual void apply();
 	virtual bool undo();
 	virtual bool redo();
+
+	virtual std::size_t getMemorySize() const override;
 };
 
 #endif // FREEFORMSEGCOMMAND_H
@@ -19,8 +19,10 @@
 #include "octfilesmodel.h"
 
 #include <manager/octdatamanager.h>
+#include <data_structure/programoptions.h>
 
 #include <QMessageBox>
+#include <QStringList>
 #include <boost/exception/diagnostic_information.hpp>
 
 
@@ -65,7 +67,9 @@ QVariant OctFilesModel::headerData(int section, Qt::Orientation orientation, int
 bool OctFilesModel::loadFile(QString filename)
 {
 	loadedFilePos = addFile(filename);
-	return openFile(filename);
+	bool result = openFile(filename);
+	updatePrefetch();
+	return result;
 }
 
 
@@ -98,6 +102,7 @@ void OctFilesModel::loadNextFile()
 		openFile(filelist[requestFilePost]->getFilename());
 		loadedFilePos = requestFilePost;
 		fileIdLoaded(index(loadedFilePos));
+		updatePrefetch();
 	}
 }
 
@@ -109,10 +114,26 @@ void OctFilesModel::loadPreviousFile()
 		--loadedFilePos;
 		openFile(filelist[loadedFilePos]->getFilename());
 		fileIdLoaded(index(loadedFilePos));
+		updatePrefetch();
 	}
 }
 
 
+void OctFilesModel::updatePrefetch()
+{
+	QStringList prefetchFiles;
+
+	std::size_t nextPos = static_cast<std::size_t>(loadedFilePos + 1);
+	if(nextPos < filelist.size())
+		prefetchFiles << filelist[nextPos]->getFilename();
+
+	if(ProgramOptions::prefetchPreviousFile() && loadedFilePos > 0)
+		prefetchFiles << filelist[static_cast<std::size_t>(loadedFilePos - 1)]->getFilename();
+
+	OctDataManager::getInstance().setPrefetchFiles(prefetchFiles);
+}
+
+
 
 
 
@@ -129,6 +150,7 @@ void OctFilesModel::slotClicked(QModelIndex index)
 	loadedFilePos = row;
 	OctFileUnloaded* file = filelist.at(static_cast<std::size_t>(row));
 	openFile(file->getFilename());
+	updatePrefetch();
 }
 
 void OctFilesModel::slotDoubleClicked(QModelIndex index)
@@ -46,6 +46,7 @@ class OctFilesModel : public QAbstractListModel
 	virtual ~OctFilesModel();
 
 	bool openFile(const QString& filename);
+	void updatePrefetch();
 
 	int loadedFilePos = 0;
 
@@ -36,6 +36,14 @@ void PrepareProgrammOptions::prepareProgrammOptions()
 
 	QAction* autoSaveOctMarkers = ProgramOptions::autoSaveOctMarkers.getAction();
 	autoSaveOctMarkers->setText(tr("Autosave markers"));
+	QAction* autoSaveMarkersJournal = ProgramOptions::autoSaveMarkersJournal.getAction();
+	autoSaveMarkersJournal->setText(tr("Autosave only changes (journal)"));
+
+	QAction* compressOctMarkers = ProgramOptions::compressOctMarkers.getAction();
+	compressOctMarkers->setText(tr("Compress marker files (gzip)"));
+
+	ProgramOptions::markerJournalMaxSize   .setDescriptions(tr("Journal size (MB)"), tr("the journal is written into the marker file when it grows beyond this size, 0 writes every autosave into the marker file"));
+	ProgramOptions::autoSaveMarkersInterval.setDescriptions(tr("Autosave interval (min)"), tr("save the markers periodically in background, 0 saves only on file change"));
 
 
 	QAction* fillEpmtyPixelWhite = ProgramOptions::fillEmptyPixelWhite.getAction();
@@ -44,12 +52,21 @@ void PrepareProgrammOptions::prepareProgrammOptions()
 	QAction* holdOCTRawData      = ProgramOptions::holdOCTRawData     .getAction();
 	QAction* readBScans          = ProgramOptions::readBScans         .getAction();
 	QAction* saveOctBinFlat      = ProgramOptions::saveOctBinFlat     .getAction();
+	QAction* progressiveLoading  = ProgramOptions::progressiveLoading .getAction();
 	fillEpmtyPixelWhite->setText(tr("Fill empty pixels white"));
 	registerBScans     ->setText(tr("register BScans"));
 	loadRotateSlo      ->setText(tr("rotate SLO"));
 	holdOCTRawData     ->setText(tr("hold OCT raw data"));
 	readBScans         ->setText(tr("read BScans from OCT data"));
 	saveOctBinFlat     ->setText(tr("save in octbin flat format"));
+	progressiveLoading ->setText(tr("show SLO before BScans are loaded"));
+
+	ProgramOptions::prefetchMaxMemory.setDescriptions(tr("Prefetch memory (MB)"), tr("memory limit for the prefetched files, 0 disables the prefetch"));
+	ProgramOptions::prefetchPreviousFile.getAction()->setText(tr("prefetch previous file"));
+	ProgramOptions::octCacheMaxMemory.setDescriptions(tr("Cache memory (MB)"), tr("memory limit for the recently opened files, 0 disables the cache"));
+	ProgramOptions::distanceMapCacheMaxSize  .setDescriptions(tr("Distance map cache (MB)"), tr("disk space for the SLO distance maps of the opened series, 0 disables the cache"));
+	ProgramOptions::distanceMapCacheDirectory.setDescriptions(tr("Distance map cache directory"), tr("directory for the SLO distance maps, empty uses the cache location of the user"));
+	ProgramOptions::undoMaxMemory    .setDescriptions(tr("Undo memory (MB)"), tr("memory limit for the undo steps of all markers, the oldest steps are removed first, 0 disables the limit"));
 
 	QAction* bscanAutoFitImage = ProgramOptions::bscanAutoFitImage.getAction();
 	bscanAutoFitImage->setText(tr("B-scan auto fit"));
@@ -106,6 +123,7 @@ void PrepareProgrammOptions::prepareProgrammOptions()
 
 	ProgramOptions::layerSegSloMapsAutoUpdate .setDescriptions(tr("Slo maps auto update"), tr("Generate slo maps after bscan change"));
 	ProgramOptions::layerSegHighlightSegLine  .setDescriptions(tr("Highlight segmentation line"), tr("Highlight segmentation line from buttons"));
+	ProgramOptions::layerSegLineEncoding      .setDescriptions(tr("Line encoding"), tr("Encoding of the segmentation lines in the marker file, older versions ignore encoded lines and remove them when they save the file"));
 
 	/*
 	 *  Free form segmentation spezific options
@@ -113,5 +131,6 @@ void PrepareProgrammOptions::prepareProgrammOptions()
 
 	ProgramOptions::freeFormedSegmetationShowArea.setDescriptions(tr("color segmentation area"), tr("Fill the area inside from the segmentation"));
 	ProgramOptions::freeFormedSegmetationShowArea.getAction()->setIcon(QIcon(":/icons/typicons/image.svgz"));
+	ProgramOptions::freeFormedSegmetationBinaryStorage.setDescriptions(tr("Binary storage in marker file"), tr("Store the segmentation binary encoded, older versions ignore it and remove it when they save the file"));
 
 }
@@ -265,7 +265,14 @@ void BScanMarkerWidget::paintEvent(QPaintEvent* event)
 	const OctData::BScan * actBScan = markerManger  .getActBScan();
 	
 	if(!series || !actBScan)
+	{
+		if(octdataManager.isPreview())
+		{
+			QPainter painter(this);
+			painter.drawText(rect(), Qt::AlignCenter, tr("B-scans are loading ..."));
+		}
 		return;
+	}
 
 	QPainter segPainter(this);
 	paintSegmentations(segPainter, getImageScaleFactor());
@@ -360,7 +367,11 @@ void BScanMarkerWidget::imageChanged()
 		updateAspectRatio();
 	}
 	else
+	{
+		if(OctDataManager::getInstance().isPreview())
+			showImage(cv::Mat());
 		update();
+	}
 }
 
 void BScanMarkerWidget::leaveEvent(QEvent* event)
@@ -18,6 +18,8 @@
 
 #include "octmarkermainwindow.h"
 
+#include <stdexcept>
+
 #include <QMenu>
 #include <QMenuBar>
 #include <QMessageBox>
@@ -50,6 +52,7 @@
 #include <manager/octdatamanager.h>
 #include <manager/octmarkerio.h>
 #include <markermodules/bscanmarkerbase.h>
+#include <markermodules/bscanlayersegmentation/bscanlayersegptree.h>
 
 #include <model/octfilesmodel.h>
 #include <model/octdatamodel.h>
@@ -351,7 +354,25 @@ void OCTMarkerMainWindow::setupMenu()
 	layerSegmentOptionsMenu->addAction(ProgramOptions::layerSegFindPointMaxAbsError.getInputDialogAction());
 	layerSegmentOptionsMenu->addAction(ProgramOptions::layerSegFindPointRemoveTol  .getInputDialogAction());
 
+	QMenu* layerSegLineEncodingMenu = new QMenu(this);
+	layerSegLineEncodingMenu->setTitle(tr("Line encoding in marker file"));
+	layerSegmentOptionsMenu->addMenu(layerSegLineEncodingMenu);
+
+	QActionGroup* layerSegLineEncodingGroup = new QActionGroup(this);
+	static SendInt lineEncodingText (static_cast<int>(BScanLayerSegPTree::LineEncoding::Text));
+	addMenuProgramOptionGroup(tr("Text (compatible)"), ProgramOptions::layerSegLineEncoding, layerSegLineEncodingMenu, lineEncodingText , layerSegLineEncodingGroup, this);
+	static SendInt lineEncodingFloat(static_cast<int>(BScanLayerSegPTree::LineEncoding::Float32));
+	addMenuProgramOptionGroup(tr("Float32 (base64)" ), ProgramOptions::layerSegLineEncoding, layerSegLineEncodingMenu, lineEncodingFloat, layerSegLineEncodingGroup, this);
+	static SendInt lineEncodingFixed(static_cast<int>(BScanLayerSegPTree::LineEncoding::FixedPoint));
+	addMenuProgramOptionGroup(tr("Fixed point 1/100 px (base64)"), ProgramOptions::layerSegLineEncoding, layerSegLineEncodingMenu, lineEncodingFixed, layerSegLineEncodingGroup, this);
+
 	optionsMenu->addMenu(layerSegmentOptionsMenu);
+
+	QMenu* freeFormedSegOptionsMenu = new QMenu(this);
+	freeFormedSegOptionsMenu->setTitle(tr("Free formed segmentation"));
+	freeFormedSegOptionsMenu->addAction(ProgramOptions::freeFormedSegmetationBinaryStorage.getAction());
+
+	optionsMenu->addMenu(freeFormedSegOptionsMenu);
 	optionsMenu->addSeparator();
 
 
@@ -362,6 +383,12 @@ void OCTMarkerMainWindow::setupMenu()
 	optionsLoadOctMenu->addAction(ProgramOptions::fillEmptyPixelWhite.getAction());
 	optionsLoadOctMenu->addAction(ProgramOptions::registerBScans     .getAction());
 	optionsLoadOctMenu->addAction(ProgramOptions::readBScans         .getAction());
+	optionsLoadOctMenu->addAction(ProgramOptions::progressiveLoading .getAction());
+	optionsLoadOctMenu->addAction(ProgramOptions::prefetchPreviousFile.getAction());
+	optionsLoadOctMenu->addAction(ProgramOptions::prefetchMaxMemory  .getInputDialogAction());
+	optionsLoadOctMenu->addAction(ProgramOptions::octCacheMaxMemory  .getInputDialogAction());
+	optionsLoadOctMenu->addAction(ProgramOptions::distanceMapCacheMaxSize  .getInputDialogAction());
+	optionsLoadOctMenu->addAction(ProgramOptions::distanceMapCacheDirectory.getInputDialogAction());
 	optionsLoadOctMenu->addAction(ProgramOptions::loadRotateSlo      .getAction());
 	optionsLoadOctMenu->addAction(ProgramOptions::holdOCTRawData     .getAction());
 
@@ -381,9 +408,13 @@ void OCTMarkerMainWindow::setupMenu()
 
 
 	optionsMenu->addAction(ProgramOptions::saveOctBinFlat     .getAction());
+	optionsMenu->addAction(ProgramOptions::undoMaxMemory      .getInputDialogAction());
 	optionsMenu->addSeparator();
 
 	optionsMenu->addAction(ProgramOptions::autoSaveOctMarkers.getAction());
+	optionsMenu->addAction(ProgramOptions::autoSaveMarkersInterval.getInputDialogAction());
+	optionsMenu->addAction(ProgramOptions::autoSaveMarkersJournal.getAction());
+	optionsMenu->addAction(ProgramOptions::markerJournalMaxSize.getInputDialogAction());
 
 
 	QMenu* optionsMenuMarkersFileFormat = new QMenu(this);
@@ -397,6 +428,10 @@ void OCTMarkerMainWindow::setupMenu()
 	addMenuProgramOptionGroup(tr("JSON"), ProgramOptions::defaultFileformatOctMarkers, optionsMenuMarkersFileFormat, markerFFjson  , markersFileFormatGroup, this);
 	static SendInt markerFFinfo(OctMarkerIO::fileformat2Int(OctMarkerFileformat::INFO));
 	addMenuProgramOptionGroup(tr("INFO"), ProgramOptions::defaultFileformatOctMarkers, optionsMenuMarkersFileFormat, markerFFinfo  , markersFileFormatGroup, this);
+	static SendInt markerFFbin(OctMarkerIO::fileformat2Int(OctMarkerFileformat::Binary));
+	addMenuProgramOptionGroup(tr("Binary"), ProgramOptions::defaultFileformatOctMarkers, optionsMenuMarkersFileFormat, markerFFbin, markersFileFormatGroup, this);
+	optionsMenuMarkersFileFormat->addSeparator();
+	optionsMenuMarkersFileFormat->addAction(ProgramOptions::compressOctMarkers.getAction());
 
 	optionsMenu->addSeparator();
 	optionsMenu->addAction(ProgramOptions::getResetAction());
@@ -497,6 +532,8 @@ void OCTMarkerMainWindow::setupStatusBar()
 	OctDataManager& octDataManager = OctDataManager::getInstance();
 	connect(&octDataManager, &OctDataManager::loadFileSignal  , this, &OCTMarkerMainWindow::loadFileStatusSlot);
 	connect(&octDataManager, &OctDataManager::loadFileProgress, this, &OCTMarkerMainWindow::loadFileProgress  );
+	connect(&octDataManager, &OctDataManager::loadBScansSignal, this, &OCTMarkerMainWindow::loadBScansStatusSlot);
+	connect(&octDataManager, &OctDataManager::markersSaveFailed, this, &OCTMarkerMainWindow::markersSaveFailedSlot);
 
 	loadProgressBar = new QProgressBar;
 	loadProgressBar->setFixedWidth(200);
@@ -757,11 +794,13 @@ void OCTMarkerMainWindow::setMarkersStringList(QStringList& filters)
 	const char* josnExt = OctMarkerIO::getFileExtension(OctMarkerFileformat::Json);
 	const char*  xmlExt = OctMarkerIO::getFileExtension(OctMarkerFileformat::XML);
 	const char* infoExt = OctMarkerIO::getFileExtension(OctMarkerFileformat::INFO);
+	const char*  binExt = OctMarkerIO::getFileExtension(OctMarkerFileformat::Binary);
 	
-	filters << tr("OCT Markers")+QString(" (*.%1 *.%2 *.%3)").arg(josnExt).arg(xmlExt).arg(infoExt);
+	filters << tr("OCT Markers")+QString(" (*.%1 *.%2 *.%3 *.%4)").arg(josnExt).arg(xmlExt).arg(infoExt).arg(binExt);
 	filters << tr("OCT Markers Json file")+QString(" (*.%1)").arg(josnExt);
 	filters << tr("OCT Markers XML file" )+QString(" (*.%1)").arg(xmlExt);
 	filters << tr("OCT Markers INFO file")+QString(" (*.%1)").arg(infoExt);
+	filters << tr("OCT Markers binary file")+QString(" (*.%1)").arg(binExt);
 }
 
 namespace
@@ -772,7 +811,7 @@ namespace
 		OCTMarkerMainWindow::setMarkersStringList(filters);
 		int index = filters.indexOf(filter);
 		
-		static const OctMarkerFileformat formats[] = {OctMarkerFileformat::Json, OctMarkerFileformat::XML, OctMarkerFileformat::INFO};
+		static const OctMarkerFileformat formats[] = {OctMarkerFileformat::Json, OctMarkerFileformat::XML, OctMarkerFileformat::INFO, OctMarkerFileformat::Binary};
 		
 		if(index == 0)
 		   return OctMarkerFileformat::Auto;
@@ -921,9 +960,19 @@ void OCTMarkerMainWindow::closeEvent(QCloseEvent* e)
 	// save Markers
 	std::function<void ()> saveFun = [&]()
 	{
-		OctDataManager::getInstance().saveMarkersDefault();
-		if(!OctDataManager::getInstance().checkAndAskSaveBeforContinue())
+		OctDataManager& manager = OctDataManager::getInstance();
+		manager.saveMarkersDefault();
+
+		// the markers count as unsaved until the background save is written
+		QString saveError;
+		if(!manager.waitForMarkerSaves(saveError))
+			throw std::runtime_error(saveError.toStdString());
+
+		if(!manager.checkAndAskSaveBeforContinue())
 			return e->ignore();
+
+		if(!manager.waitForMarkerSaves(saveError))
+			throw std::runtime_error(saveError.toStdString());
 	};
 
 	std::string errorStr;
@@ -975,11 +1024,27 @@ void OCTMarkerMainWindow::loadFileStatusSlot(bool loading)
 }
 
 
+void OCTMarkerMainWindow::loadBScansStatusSlot(bool loading)
+{
+	// the window stays usable, the slo is already shown
+	loadProgressBar->setVisible(loading);
+	if(loading)
+		statusBar()->showMessage(tr("loading B-scans ..."));
+	else
+		statusBar()->clearMessage();
+}
+
+
 void OCTMarkerMainWindow::loadFileProgress(double frac)
 {
 	loadProgressBar->setValue(static_cast<int>(frac*100));
 }
 
+void OCTMarkerMainWindow::markersSaveFailedSlot(const QString& filename, const QString& error)
+{
+	QMessageBox::critical(this, tr("Error on save"), tr("Save of %1 fail with message: %2").arg(filename).arg(error), QMessageBox::Ok);
+}
+
 
 void OCTMarkerMainWindow::screenshot()
 {
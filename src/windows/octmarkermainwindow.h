@@ -100,9 +100,11 @@ private slots:
 	void updateWindowTitle();
 
 	void loadFileStatusSlot(bool loading);
+	void loadBScansStatusSlot(bool loading);
 	void loadFileProgress(double frac);
 
 	void triggerSaveMarkersDefaultCatchErrors();
+	void markersSaveFailedSlot(const QString& filename, const QString& error);
 
 public slots:
 	virtual void showLoadImageDialog();
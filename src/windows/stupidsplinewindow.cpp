@@ -78,6 +78,8 @@ StupidSplineWindow::StupidSplineWindow()
 	OctDataManager& octDataManager = OctDataManager::getInstance();
 	connect(&octDataManager, &OctDataManager::loadFileSignal  , this, &StupidSplineWindow::loadFileStatusSlot);
 	connect(&octDataManager, &OctDataManager::loadFileProgress, this, &StupidSplineWindow::loadFileProgress  );
+	connect(&octDataManager, &OctDataManager::loadBScansSignal, this, &StupidSplineWindow::loadBScansStatusSlot);
+	connect(&octDataManager, &OctDataManager::markersSaveFailed, this, &StupidSplineWindow::markersSaveFailedSlot);
 	connect(&octDataManager, static_cast<void(OctDataManager::*)()>(&OctDataManager::octFileChanged), this, &StupidSplineWindow::updateWindowTitle );
 
 
@@ -251,12 +253,24 @@ void StupidSplineWindow::loadFileStatusSlot(bool loading)
 }
 
 
+void StupidSplineWindow::loadBScansStatusSlot(bool loading)
+{
+	if(!loading)
+		copyLayerSegmentationFromOCTData();
+}
+
+
 void StupidSplineWindow::loadFileProgress(double frac)
 {
 	if(progressDialog)
 		progressDialog->setValue(static_cast<int>(frac*100));
 }
 
+void StupidSplineWindow::markersSaveFailedSlot(const QString& filename, const QString& error)
+{
+	QMessageBox::critical(this, tr("Error on save"), tr("Save of %1 fail with message: %2").arg(filename).arg(error), QMessageBox::Ok);
+}
+
 
 
 bool StupidSplineWindow::loadFile(const QString& filename)
@@ -86,7 +86,9 @@ private slots:
 	void saveAndClose();
 
 	void loadFileStatusSlot(bool loading);
+	void loadBScansStatusSlot(bool loading);
 	void loadFileProgress(double frac);
+	void markersSaveFailedSlot(const QString& filename, const QString& error);
 
 	void setProgramOptions();
 };
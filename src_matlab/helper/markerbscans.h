@@ -0,0 +1,121 @@
+#pragma once
+
+#include "mex.h"
+
+#include <manager/octmarkerio.h>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+
+// shared single pass decoding of the "BScan" nodes of a marker module
+namespace MarkerBScans
+{
+	struct BScanNode
+	{
+		int id;                                                     // -1 without valid "ID"
+		const boost::property_tree::ptree* node;
+	};
+
+
+	// calls func(i) for i in [0, count) with a small pool of threads, no mex calls in func
+	template<typename Func>
+	void parallelFor(std::size_t count, Func func)
+	{
+		const std::size_t numThreads = std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), count);
+
+		std::atomic<std::size_t> nextIndex(0);
+		auto worker = [&]()
+		{
+			for(std::size_t i = nextIndex++; i < count; i = nextIndex++)
+				func(i);
+		};
+
+		std::vector<std::thread> threads;
+		for(std::size_t i = 1; i < numThreads; ++i)
+			threads.emplace_back(worker);
+		worker();
+
+		for(std::thread& thread : threads)
+			thread.join();
+	}
+
+
+	inline std::string getString(const mxArray* array)
+	{
+		mxChar* strPtr = (mxChar*) mxGetPr(array);
+		std::size_t strLength = mxGetN(array);
+		return std::string(strPtr, strPtr+strLength);
+	}
+
+
+	// loads the default marker file of the oct file, binary files only read the module section
+	inline bool loadMarkers(const std::string& octFilename, const std::string& moduleId, boost::property_tree::ptree& markerTree)
+	{
+		OctMarkerIO markerIO(&markerTree);
+		markerIO.setSectionFilter({moduleId});
+		return markerIO.loadDefaultMarker(octFilename);
+	}
+
+
+	// all "BScan" children in file order
+	inline std::vector<BScanNode> getBScanNodes(const boost::property_tree::ptree& parent)
+	{
+		std::vector<BScanNode> nodes;
+		for(const std::pair<const std::string, boost::property_tree::ptree>& nodePair : parent)
+		{
+			if(nodePair.first != "BScan")
+				continue;
+
+			BScanNode bscanNode;
+			bscanNode.id   = nodePair.second.get<int>("ID", -1);
+			bscanNode.node = &nodePair.second;
+			nodes.push_back(bscanNode);
+		}
+		return nodes;
+	}
+
+
+	// number of bscans in the output (largest id + 1), the ids come from the file and
+	// are limited to protect the output size against broken files
+	inline std::size_t getNumBScans(const std::vector<BScanNode>& nodes)
+	{
+		const std::size_t maxNumBScans = std::max<std::size_t>(1024, nodes.size()*8);
+
+		std::size_t numBScans = 0;
+		for(const BScanNode& node : nodes)
+		{
+			if(node.id < 0)
+				continue;
+			if(static_cast<std::size_t>(node.id) >= maxNumBScans)
+				throw "bscan id out of range";
+			numBScans = std::max(numBScans, static_cast<std::size_t>(node.id) + 1);
+		}
+		return numBScans;
+	}
+
+
+	// index of name in names, appended if missing
+	inline std::size_t getNameIndex(std::vector<std::string>& names, const std::string& name)
+	{
+		const std::vector<std::string>::const_iterator it = std::find(names.begin(), names.end(), name);
+		if(it != names.end())
+			return static_cast<std::size_t>(it - names.begin());
+		names.push_back(name);
+		return names.size() - 1;
+	}
+
+
+	inline mxArray* createCellString(const std::vector<std::string>& strings)
+	{
+		mxArray* cell = mxCreateCellMatrix(strings.size(), 1);
+		for(std::size_t i = 0; i < strings.size(); ++i)
+			mxSetCell(cell, i, mxCreateString(strings[i].c_str()));
+		return cell;
+	}
+}
@@ -0,0 +1,168 @@
+#include "mex.h"
+
+#include "helper/matlab_helper.h"
+#include "helper/matlab_types.h"
+#include "helper/markerbscans.h"
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <atomic>
+
+namespace bpt = boost::property_tree;
+
+
+namespace
+{
+	struct Intervall
+	{
+		int         start;
+		int         end;
+		std::string intervallClass;
+	};
+
+	const int maxIntervallEnd = 1 << 16;                            // limits the output width for broken files
+
+	void extractIntervalls(const bpt::ptree& nodeBscan, std::vector<Intervall>& intervalls)
+	{
+		for(const std::pair<const std::string, bpt::ptree>& intervallNodePair : nodeBscan)
+		{
+			if(intervallNodePair.first != "Intervall")
+				continue;
+
+			const bpt::ptree& intervallNode = intervallNodePair.second;
+
+			Intervall intervall;
+			intervall.start          = intervallNode.get_child("Start").get_value<int>();
+			intervall.end            = intervallNode.get_child("End"  ).get_value<int>();
+			intervall.intervallClass = intervallNode.get_child("Class").get_value<std::string>();
+			if(intervall.start < 0 || intervall.end < intervall.start)
+				continue;
+			if(intervall.end >= maxIntervallEnd)
+				throw "intervall end out of range";
+
+			intervalls.push_back(intervall);
+		}
+	}
+}
+
+
+// [field, classNames] = read_intervals(filename, collection)
+// field(bscan, x) is the 1-based index in classNames, 0 for no marker
+void mexFunction(int            nlhs  ,
+                 mxArray*       plhs[],
+                 int            nrhs  ,
+                 const mxArray* prhs[]
+                 )
+{
+	if(nrhs != 2)
+	{
+		mexErrMsgIdAndTxt("MATLAB:mexcpp:nargin", "MEXCPP requires 2 input arguments");
+		return;
+	}
+	if(nlhs > 2)
+	{
+		mexErrMsgIdAndTxt("MATLAB:mexcpp:nargout", "MEXCPP requires max two output arguments.");
+		return;
+	}
+
+	if(!mxIsChar(prhs[0]) || !mxIsChar(prhs[1]))
+	{
+		mexErrMsgIdAndTxt("MATLAB:mexcpp:nargin", "requires filename and marker collection");
+		return;
+	}
+	const std::string filename   = MarkerBScans::getString(prhs[0]);
+	const std::string collection = MarkerBScans::getString(prhs[1]);
+
+
+	bpt::ptree octmarkerTree;
+	if(!MarkerBScans::loadMarkers(filename, "IntervalMarker", octmarkerTree))
+	{
+		mexErrMsgIdAndTxt("MATLAB:mexcpp:nargin", "can't open marker file for %s", filename.c_str());
+		return;
+	}
+
+	mxArray* resultMat = nullptr;
+	std::vector<std::string> classNames;
+
+	try
+	{
+		const bpt::ptree& nodeIntervals = octmarkerTree.get_child("Patient.Study.Series.IntervalMarker");
+		const bpt::ptree& nodeCollection = nodeIntervals.get_child(bpt::ptree::path_type(collection, '\0'));
+
+		const std::vector<MarkerBScans::BScanNode> bscanNodes = MarkerBScans::getBScanNodes(nodeCollection);
+
+		// decode every bscan once
+		std::vector<std::vector<Intervall>> bscanIntervalls(bscanNodes.size());
+		std::atomic<bool>                   decodeError(false);
+		MarkerBScans::parallelFor(bscanNodes.size(), [&](std::size_t i)
+		{
+			if(bscanNodes[i].id < 0)
+				return;
+			try
+			{
+				extractIntervalls(*bscanNodes[i].node, bscanIntervalls[i]);
+			}
+			catch(...)
+			{
+				decodeError = true;
+			}
+		});
+		if(decodeError)
+			throw "decode error";
+
+		// output size and class index of every intervall
+		const mwSize numBscans = MarkerBScans::getNumBScans(bscanNodes);
+		mwSize       width     = 0;
+		std::vector<std::vector<uint8_t>> classIndices(bscanNodes.size());
+		for(std::size_t i = 0; i < bscanNodes.size(); ++i)
+		{
+			if(bscanNodes[i].id < 0)
+				continue;
+
+			for(const Intervall& intervall : bscanIntervalls[i])
+			{
+				const std::size_t classIndex = MarkerBScans::getNameIndex(classNames, intervall.intervallClass) + 1;
+				if(classIndex > 255)
+					throw "too many interval classes";
+
+				classIndices[i].push_back(static_cast<uint8_t>(classIndex));
+				width = std::max(width, static_cast<mwSize>(intervall.end) + 1);
+			}
+		}
+
+		// create output mat
+		const mwSize dims[] = {numBscans, width};
+		const mwSize dimNum = sizeof(dims)/sizeof(dims[0]);
+		resultMat = mxCreateNumericArray(dimNum, dims, MatlabType<uint8_t>::classID, mxREAL);
+		uint8_t* dataPtr = reinterpret_cast<uint8_t*>(mxGetPr(resultMat));
+		std::memset(dataPtr, 0, numBscans*width);
+
+		// fill output mat in file order, like the marker manager later intervalls overwrite earlier ones
+		for(std::size_t i = 0; i < bscanNodes.size(); ++i)
+		{
+			if(bscanNodes[i].id < 0)
+				continue;
+
+			uint8_t* bscanPtr = dataPtr + bscanNodes[i].id;
+			const std::vector<Intervall>& intervalls = bscanIntervalls[i];
+			for(std::size_t j = 0; j < intervalls.size(); ++j)
+			{
+				const uint8_t classIndex = classIndices[i][j];
+				for(int x = intervalls[j].start; x <= intervalls[j].end; ++x)
+					bscanPtr[static_cast<std::size_t>(x)*numBscans] = classIndex;
+			}
+		}
+	}
+	catch(...)
+	{
+		mexErrMsgIdAndTxt("MATLAB:mexcpp:nargin", "Error while reading file");
+		return;
+	}
+
+	plhs[0] = resultMat;
+	if(nlhs > 1)
+		plhs[1] = MarkerBScans::createCellString(classNames);
+}
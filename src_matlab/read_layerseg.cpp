@@ -0,0 +1,172 @@
+#include "mex.h"
+
+#include "helper/matlab_helper.h"
+#include "helper/matlab_types.h"
+#include "helper/markerbscans.h"
+
+#include <data_structure/seglinecodec.h>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <vector>
+#include <string>
+#include <limits>
+#include <cmath>
+#include <atomic>
+
+namespace bpt = boost::property_tree;
+
+
+namespace
+{
+	struct BScanLines
+	{
+		std::vector<std::string>         names;
+		std::vector<std::vector<double>> lines;
+	};
+
+	void extractLines(const bpt::ptree& nodeBscan, const char* nodeName, BScanLines& bscanLines)
+	{
+		boost::optional<const bpt::ptree&> linesNode = nodeBscan.get_child_optional(nodeName);
+		if(!linesNode)
+			return;
+
+		for(const std::pair<const std::string, bpt::ptree>& linePair : *linesNode)
+		{
+			std::vector<double> line;
+			if(!SegLineCodec::decode(linePair.second.data(), line))
+				throw "invalid segmentation line";
+
+			bscanLines.names.push_back(linePair.first);
+			bscanLines.lines.push_back(std::move(line));
+		}
+	}
+
+	// values without a segmentation are stored as big numbers
+	float toMatlabValue(double value)
+	{
+		if(!std::isfinite(value) || value >= 1e8)
+			return std::numeric_limits<float>::quiet_NaN();
+		return static_cast<float>(value);
+	}
+}
+
+
+// [seg, lineNames] = read_layerseg(filename)
+// seg(bscan, x, line) as single, NaN for missing values
+void mexFunction(int            nlhs  ,
+                 mxArray*       plhs[],
+                 int            nrhs  ,
+                 const mxArray* prhs[]
+                 )
+{
+	if(nrhs != 1)
+	{
+		mexErrMsgIdAndTxt("MATLAB:mexcpp:nargin", "MEXCPP requires 1 input arguments");
+		return;
+	}
+	if(nlhs > 2)
+	{
+		mexErrMsgIdAndTxt("MATLAB:mexcpp:nargout", "MEXCPP requires max two output arguments.");
+		return;
+	}
+
+	if(!mxIsChar(prhs[0]))
+	{
+		mexErrMsgIdAndTxt("MATLAB:mexcpp:nargin", "requires filename");
+		return;
+	}
+	const std::string filename = MarkerBScans::getString(prhs[0]);
+
+
+	bpt::ptree octmarkerTree;
+	if(!MarkerBScans::loadMarkers(filename, "LayerSegmentation", octmarkerTree))
+	{
+		mexErrMsgIdAndTxt("MATLAB:mexcpp:nargin", "can't open marker file for %s", filename.c_str());
+		return;
+	}
+
+	mxArray* resultMat = nullptr;
+	std::vector<std::string> lineNames;
+
+	try
+	{
+		const bpt::ptree& nodeLayerSeg = octmarkerTree.get_child("Patient.Study.Series.LayerSegmentation");
+		if(nodeLayerSeg.get<int>("Version", 0) > SegLineCodec::encodedVersion)
+			throw "unsupported version";
+
+		const std::vector<MarkerBScans::BScanNode> bscanNodes = MarkerBScans::getBScanNodes(nodeLayerSeg);
+
+		// decode every bscan once
+		std::vector<BScanLines> bscanLines(bscanNodes.size());
+		std::atomic<bool>       decodeError(false);
+		MarkerBScans::parallelFor(bscanNodes.size(), [&](std::size_t i)
+		{
+			if(bscanNodes[i].id < 0)
+				return;
+			try
+			{
+				extractLines(*bscanNodes[i].node, SegLineCodec::textLinesNode   , bscanLines[i]);
+				extractLines(*bscanNodes[i].node, SegLineCodec::encodedLinesNode, bscanLines[i]);
+			}
+			catch(...)
+			{
+				decodeError = true;
+			}
+		});
+		if(decodeError)
+			throw "decode error";
+
+		// output size and the output line index of every decoded line
+		const mwSize numBscans = MarkerBScans::getNumBScans(bscanNodes);
+		mwSize       width     = 0;
+		std::vector<std::vector<std::size_t>> lineIndices(bscanNodes.size());
+		for(std::size_t i = 0; i < bscanNodes.size(); ++i)
+		{
+			if(bscanNodes[i].id < 0)
+				continue;
+
+			const BScanLines& actLines = bscanLines[i];
+			for(std::size_t l = 0; l < actLines.names.size(); ++l)
+			{
+				lineIndices[i].push_back(MarkerBScans::getNameIndex(lineNames, actLines.names[l]));
+				width = std::max(width, static_cast<mwSize>(actLines.lines[l].size()));
+			}
+		}
+		const mwSize numLines = lineNames.size();
+
+		// create output mat
+		const mwSize dims[] = {numBscans, width, numLines};
+		const mwSize dimNum = sizeof(dims)/sizeof(dims[0]);
+		resultMat = mxCreateNumericArray(dimNum, dims, MatlabType<float>::classID, mxREAL);
+		float* dataPtr = reinterpret_cast<float*>(mxGetPr(resultMat));
+		std::fill(dataPtr, dataPtr + numBscans*width*numLines, std::numeric_limits<float>::quiet_NaN());
+
+		// fill output mat in file order, a later node with the same id overwrites the earlier lines
+		// (serial, neighbouring bscans share cache lines in this layout)
+		for(std::size_t i = 0; i < bscanNodes.size(); ++i)
+		{
+			if(bscanNodes[i].id < 0)
+				continue;
+
+			const std::size_t bscan = static_cast<std::size_t>(bscanNodes[i].id);
+			const BScanLines& actLines = bscanLines[i];
+			for(std::size_t l = 0; l < actLines.lines.size(); ++l)
+			{
+				const std::vector<double>& line = actLines.lines[l];
+				float* linePtr = dataPtr + bscan + lineIndices[i][l]*numBscans*width;
+				for(std::size_t x = 0; x < line.size(); ++x)
+					linePtr[x*numBscans] = toMatlabValue(line[x]);
+			}
+		}
+	}
+	catch(...)
+	{
+		mexErrMsgIdAndTxt("MATLAB:mexcpp:nargin", "Error while reading file");
+		return;
+	}
+
+	plhs[0] = resultMat;
+	if(nlhs > 1)
+		plhs[1] = MarkerBScans::createCellString(lineNames);
+}
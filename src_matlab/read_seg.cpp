@@ -2,9 +2,11 @@
 
 #include "helper/matlab_helper.h"
 #include "helper/matlab_types.h"
+#include "helper/markerbscans.h"
 
 #include <manager/octmarkerio.h>
 #include <data_structure/simplematcompress.h>
+#include <helper/base64.h>
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
@@ -14,6 +16,8 @@
 
 #include <iostream>
 #include <sstream>
+#include <vector>
+#include <atomic>
 
 namespace bpt = boost::property_tree;
 
@@ -22,6 +26,16 @@ namespace bpt = boost::property_tree;
 
 bool extractMatCompress(const bpt::ptree& nodeBscan, SimpleMatCompress& compressedMat)
 {
+	boost::optional<const bpt::ptree&> matCompressBinNodeOptional = nodeBscan.get_child_optional("matCompressBin");
+	if(matCompressBinNodeOptional)
+	{
+		const std::string& encoded = matCompressBinNodeOptional->data();
+		std::string binary;
+		if(!Base64::decode(encoded.data(), encoded.size(), binary))
+			return false;
+		return compressedMat.readBinary(binary.data(), binary.size());
+	}
+
 	boost::optional<const bpt::ptree&> matCompressNodeOptional = nodeBscan.get_child_optional("matCompress");
 	if(!matCompressNodeOptional)
 		return false;
@@ -63,17 +77,11 @@ void mexFunction(int            nlhs  ,
 		mexErrMsgIdAndTxt("MATLAB:mexcpp:nargin", "requires filename");
 		return;
 	}
-	// Filename
-	mxChar* fnPtr = (mxChar*) mxGetPr(prhs[0]);
-	std::size_t fnLength = mxGetN(prhs[0]);
-	std::string filename(fnPtr, fnPtr+fnLength);
+	const std::string filename = MarkerBScans::getString(prhs[0]);
 
 
 	bpt::ptree octmarkerTree;
-	SimpleMatCompress compressedMat;
-
-	OctMarkerIO markerIO(&octmarkerTree);
-	if(!markerIO.loadDefaultMarker(filename))
+	if(!MarkerBScans::loadMarkers(filename, "SegmentationMarker", octmarkerTree))
 	{
 		mexErrMsgIdAndTxt("MATLAB:mexcpp:nargin", "can't open marker file for %s", filename.c_str());
 		return;
@@ -86,29 +94,47 @@ void mexFunction(int            nlhs  ,
 		bpt::ptree& nodeSeries = octmarkerTree.get_child("Patient.Study.Series"  );
 		bpt::ptree& nodeILM    = nodeSeries   .get_child("SegmentationMarker.ILM");
 
-		mwSize numBscans = 0;
-		mwSize rows = 0;
-		mwSize cols = 0;
+		const std::vector<MarkerBScans::BScanNode> bscanNodes = MarkerBScans::getBScanNodes(nodeILM);
 
-		// count BScans
-		for(const std::pair<const std::string, bpt::ptree>& nodeBscanPair : nodeILM)
+		// decode every bscan once
+		std::vector<SimpleMatCompress> compressedMats(bscanNodes.size());
+		std::vector<char>              validMats     (bscanNodes.size(), 0);
+		std::atomic<bool>              decodeError(false);
+		MarkerBScans::parallelFor(bscanNodes.size(), [&](std::size_t i)
 		{
-			if(nodeBscanPair.first != "BScan")
-				continue;
+			try
+			{
+				validMats[i] = extractMatCompress(*bscanNodes[i].node, compressedMats[i]) ? 1 : 0;
+			}
+			catch(...)
+			{
+				decodeError = true;
+			}
+		});
+		if(decodeError)
+			throw "decode error";
 
-			if(!extractMatCompress(nodeBscanPair.second, compressedMat))
+		// size from the first bscan, bscans with other sizes are skipped
+		mwSize rows = 0;
+		mwSize cols = 0;
+		std::vector<std::size_t> outputBScans;
+		for(std::size_t i = 0; i < compressedMats.size(); ++i)
+		{
+			if(!validMats[i])
 				continue;
 
-			if(numBscans == 0)
+			const SimpleMatCompress& compressedMat = compressedMats[i];
+			if(outputBScans.empty())
 			{
 				rows = compressedMat.getRows();
 				cols = compressedMat.getCols();
 			}
-			else if(rows != compressedMat.getRows() || cols != compressedMat.getCols())
+			else if(rows != static_cast<mwSize>(compressedMat.getRows()) || cols != static_cast<mwSize>(compressedMat.getCols()))
 				continue;
 
-			++numBscans;
+			outputBScans.push_back(i);
 		}
+		const mwSize numBscans = outputBScans.size();
 
 		// create output mat
 		const mwSize dims[] = {cols, rows, numBscans};
@@ -116,23 +142,11 @@ void mexFunction(int            nlhs  ,
 		resultMat = mxCreateNumericArray(dimNum, dims, MatlabType<uint8_t>::classID, mxREAL);
 		uint8_t* dataPtr = reinterpret_cast<uint8_t*>(mxGetPr(resultMat));
 
-		// fill output mat
-		for(const std::pair<const std::string, bpt::ptree>& nodeBscanPair : nodeILM)
+		// fill output mat, every bscan in its own slice
+		MarkerBScans::parallelFor(outputBScans.size(), [&](std::size_t slice)
 		{
-			if(nodeBscanPair.first != "BScan")
-				continue;
-
-			if(!extractMatCompress(nodeBscanPair.second, compressedMat))
-				continue;
-
-			if(rows != compressedMat.getRows() || cols != compressedMat.getCols())
-				continue;
-
-			compressedMat.writeToMat(dataPtr, rows, cols);
-			dataPtr += rows*cols;
-		}
-
-
+			compressedMats[outputBScans[slice]].writeToMat(dataPtr + slice*rows*cols, static_cast<int>(rows), static_cast<int>(cols));
+		});
 	}
 	catch(...)
 	{
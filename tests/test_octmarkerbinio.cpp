@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string>
+#include <sstream>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <manager/octmarkerbinio.h>
+
+#include "testhelper.h"
+
+namespace bpt = boost::property_tree;
+
+
+namespace
+{
+	bpt::ptree createMarkerTree()
+	{
+		bpt::ptree tree;
+		tree.put("OctMarker.Version", 1);
+
+		bpt::ptree& series = tree.add("OctMarker.Markers.Patient.Study.Series", "");
+		series.put("ID", 3);
+		series.put("SeriesUID", "1.2.840.113619");
+
+		bpt::ptree& layerSeg = series.add("LayerSegmentation", "");
+		for(int bscan = 0; bscan < 4; ++bscan)
+		{
+			bpt::ptree& bscanNode = layerSeg.add("BScan", "");
+			bscanNode.put("ID", bscan);
+			bscanNode.put("Lines.ILM", "1.5 2.25 -3 100000000 0.1 ");
+			bscanNode.put("Lines.BM" , "17 18 19 20 ");
+		}
+
+		bpt::ptree& intervals = series.add("IntervalMarker", "");
+		intervals.put("Intervals.Marker", "22 serialization::archive 16 0 0 1 2 3");
+		intervals.put("Empty", "");
+		return tree;
+	}
+
+	std::string writeTree(const bpt::ptree& tree)
+	{
+		std::ostringstream stream;
+		OctMarkerBinIO::write(stream, tree);
+		return stream.str();
+	}
+
+
+	void testRoundTrip()
+	{
+		const bpt::ptree tree = createMarkerTree();
+		const std::string data = writeTree(tree);
+
+		bpt::ptree readTree;
+		TEST_CHECK(OctMarkerBinIO::read(data.data(), data.size(), readTree));
+		TEST_CHECK(readTree == tree);
+	}
+
+	void testSectionFilter()
+	{
+		const std::string data = writeTree(createMarkerTree());
+
+		const std::vector<std::string> sections{"LayerSegmentation"};
+		bpt::ptree readTree;
+		TEST_CHECK(OctMarkerBinIO::read(data.data(), data.size(), readTree, &sections));
+
+		const bpt::ptree& series = readTree.get_child("OctMarker.Markers.Patient.Study.Series");
+		TEST_CHECK(series.get_child_optional("LayerSegmentation"));
+		TEST_CHECK(!series.get_child_optional("IntervalMarker.Intervals"));
+	}
+
+	void testTruncated()
+	{
+		const std::string data = writeTree(createMarkerTree());
+		for(std::size_t size = 0; size < data.size(); ++size)
+		{
+			bpt::ptree readTree;
+			TEST_CHECK(!OctMarkerBinIO::read(data.data(), size, readTree));
+		}
+	}
+
+	void testCorrupt()
+	{
+		// every changed byte must be rejected or give some tree, but never crash or hang
+		const std::string data = writeTree(createMarkerTree());
+		for(std::size_t pos = 0; pos < data.size(); ++pos)
+		{
+			for(int value : {0x00, 0x7f, 0x80, 0xff})
+			{
+				std::string corrupt = data;
+				corrupt[pos] = static_cast<char>(value);
+
+				bpt::ptree readTree;
+				OctMarkerBinIO::read(corrupt.data(), corrupt.size(), readTree);
+			}
+		}
+
+		bpt::ptree readTree;
+		const std::string noMarkerFile = "OctMarker.Version 1";
+		TEST_CHECK(!OctMarkerBinIO::read(noMarkerFile.data(), noMarkerFile.size(), readTree));
+	}
+}
+
+
+int main()
+{
+	testRoundTrip();
+	testSectionFilter();
+	testTruncated();
+	testCorrupt();
+	return testResult();
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string>
+#include <iterator>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <manager/octmarkerjournal.h>
+
+#include "testhelper.h"
+
+namespace bpt = boost::property_tree;
+namespace bfs = boost::filesystem;
+
+
+namespace
+{
+	typedef OctMarkerJournal::PathElement PathElement;
+
+	OctMarkerJournal::NodePath bscanPath(int bscan)
+	{
+		return {PathElement("Patient", 1), PathElement("Study", 1), PathElement("Series", 1), PathElement("LayerSegmentation"), PathElement("BScan", bscan)};
+	}
+
+	bpt::ptree createMarkerTree()
+	{
+		bpt::ptree tree;
+		tree.put("Patient.ID", 1);
+		tree.put("Patient.Study.ID", 1);
+		tree.put("Patient.Study.Series.ID", 1);
+
+		bpt::ptree& layerSeg = tree.put_child("Patient.Study.Series.LayerSegmentation", bpt::ptree());
+		for(int bscan = 0; bscan < 3; ++bscan)
+		{
+			bpt::ptree& bscanNode = layerSeg.add_child("BScan", bpt::ptree());
+			bscanNode.put("ID", bscan);
+			bscanNode.put("Lines.ILM", std::to_string(bscan) + " 1 2 3 ");
+		}
+		return tree;
+	}
+
+	const bpt::ptree* findBScan(const bpt::ptree& tree, int bscan)
+	{
+		boost::optional<const bpt::ptree&> layerSeg = tree.get_child_optional("Patient.Study.Series.LayerSegmentation");
+		if(!layerSeg)
+			return nullptr;
+		for(const bpt::ptree::value_type& pair : *layerSeg)
+			if(pair.first == "BScan" && pair.second.get<int>("ID", -1) == bscan)
+				return &pair.second;
+		return nullptr;
+	}
+
+	std::string readFile(const bfs::path& path)
+	{
+		bfs::ifstream stream(path, std::ios::binary);
+		return std::string((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+	}
+
+	void writeFile(const bfs::path& path, const std::string& content)
+	{
+		bfs::ofstream stream(path, std::ios::binary | std::ios::trunc);
+		stream.write(content.data(), static_cast<std::streamsize>(content.size()));
+	}
+
+
+	void testReplay(const bfs::path& journalPath)
+	{
+		bpt::ptree tree = createMarkerTree();
+		tree.get_child("Patient.Study.Series.LayerSegmentation").front().second.put("Lines.ILM", "changed ");
+
+		// remove b-scan 2
+		bpt::ptree& layerSeg = tree.get_child("Patient.Study.Series.LayerSegmentation");
+		layerSeg.erase(std::prev(layerSeg.end()));
+
+		std::string records;
+		OctMarkerJournal::addRecord(records, tree, bscanPath(0));
+		OctMarkerJournal::addRecord(records, tree, bscanPath(2));
+		TEST_CHECK(OctMarkerJournal::append(journalPath, records));
+
+		bpt::ptree replayTree = createMarkerTree();
+		bool complete = false;
+		TEST_CHECK(OctMarkerJournal::apply(journalPath, replayTree, complete) == 2);
+		TEST_CHECK(complete);
+
+		const bpt::ptree* bscan0 = findBScan(replayTree, 0);
+		TEST_CHECK(bscan0 && bscan0->get<std::string>("Lines.ILM") == "changed ");
+		TEST_CHECK(findBScan(replayTree, 1) != nullptr);
+		TEST_CHECK(findBScan(replayTree, 2) == nullptr);
+	}
+
+	void testTornRecord(const bfs::path& journalPath)
+	{
+		const std::string content = readFile(journalPath);
+		std::string lastRecord;
+		OctMarkerJournal::addRecord(lastRecord, createMarkerTree(), bscanPath(2));
+
+		// every cut through the last record keeps the records before it
+		for(std::size_t cut = 1; cut < lastRecord.size(); ++cut)
+		{
+			writeFile(journalPath, content + lastRecord.substr(0, cut));
+
+			bpt::ptree replayTree = createMarkerTree();
+			bool complete = true;
+			TEST_CHECK(OctMarkerJournal::apply(journalPath, replayTree, complete) == 2);
+			TEST_CHECK(!complete);
+			TEST_CHECK(findBScan(replayTree, 2) == nullptr);
+		}
+
+		writeFile(journalPath, content + lastRecord);
+		bpt::ptree replayTree = createMarkerTree();
+		bool complete = false;
+		TEST_CHECK(OctMarkerJournal::apply(journalPath, replayTree, complete) == 3);
+		TEST_CHECK(complete);
+		TEST_CHECK(findBScan(replayTree, 2) != nullptr);
+	}
+
+	void testDamagedRecord(const bfs::path& journalPath)
+	{
+		const std::string content = readFile(journalPath);
+
+		// flipped byte in the payload of the last record, the checksum does not match
+		std::string damaged = content;
+		damaged[damaged.size() - 3] = static_cast<char>(damaged[damaged.size() - 3] ^ 0x55);
+		writeFile(journalPath, damaged);
+
+		bpt::ptree replayTree = createMarkerTree();
+		bool complete = true;
+		TEST_CHECK(OctMarkerJournal::apply(journalPath, replayTree, complete) == 2);
+		TEST_CHECK(!complete);
+
+		// wrong magic, nothing is applied
+		damaged = content;
+		damaged[0] = 'X';
+		writeFile(journalPath, damaged);
+		TEST_CHECK(OctMarkerJournal::apply(journalPath, replayTree, complete) == 0);
+		TEST_CHECK(!complete);
+	}
+}
+
+
+int main()
+{
+	const bfs::path journalPath = bfs::temp_directory_path() / bfs::unique_path("octmarker-test-%%%%-%%%%.journal");
+
+	testReplay(journalPath);
+	testTornRecord(journalPath);
+	testDamagedRecord(journalPath);
+
+	bfs::remove(journalPath);
+	return testResult();
+}
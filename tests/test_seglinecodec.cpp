@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <data_structure/seglinecodec.h>
+
+#include "testhelper.h"
+
+using SegLineCodec::Encoding;
+
+
+namespace
+{
+	bool sameValues(const std::vector<double>& a, const std::vector<double>& b, double tolerance)
+	{
+		if(a.size() != b.size())
+			return false;
+		for(std::size_t i = 0; i < a.size(); ++i)
+		{
+			if(std::isnan(a[i]) || std::isnan(b[i]))
+			{
+				if(std::isnan(a[i]) != std::isnan(b[i]))
+					return false;
+			}
+			else if(std::abs(a[i] - b[i]) > tolerance)
+				return false;
+		}
+		return true;
+	}
+
+
+	void testRoundTrip()
+	{
+		const double nan = std::numeric_limits<double>::quiet_NaN();
+		const std::vector<double> line{1.5, 2.25, nan, 100000000., -3., 0., 496.37};
+
+		std::string str;
+		std::vector<double> decoded;
+
+		TEST_CHECK(SegLineCodec::encode(line, Encoding::Text, str));
+		TEST_CHECK(SegLineCodec::decode(str, decoded));
+		TEST_CHECK(sameValues(line, decoded, 1e-6));
+
+		TEST_CHECK(SegLineCodec::encode(line, Encoding::Float32, str));
+		TEST_CHECK(str.compare(0, 4, "f32:") == 0);
+		TEST_CHECK(SegLineCodec::decode(str, decoded));
+		TEST_CHECK(sameValues(line, decoded, 1e-6*100000000.));
+
+		TEST_CHECK(SegLineCodec::encode(line, Encoding::FixedPoint, str));
+		TEST_CHECK(str.compare(0, 5, "q100:") == 0);
+		TEST_CHECK(SegLineCodec::decode(str, decoded));
+		TEST_CHECK(sameValues(line, decoded, 0.005 + 1e-9));
+
+		for(Encoding encoding : {Encoding::Text, Encoding::Float32, Encoding::FixedPoint})
+		{
+			TEST_CHECK(SegLineCodec::encode(std::vector<double>(), encoding, str));
+			TEST_CHECK(SegLineCodec::decode(str, decoded));
+			TEST_CHECK(decoded.empty());
+		}
+	}
+
+	void testEncodeRange()
+	{
+		std::string str;
+		const double inf = std::numeric_limits<double>::infinity();
+
+		TEST_CHECK(!SegLineCodec::encode({inf  }, Encoding::FixedPoint, str));
+		TEST_CHECK(!SegLineCodec::encode({1e20 }, Encoding::FixedPoint, str));
+		TEST_CHECK(!SegLineCodec::encode({1e300}, Encoding::Float32   , str));
+		TEST_CHECK( SegLineCodec::encode({inf  }, Encoding::Float32   , str));
+	}
+
+	void testRejectBadInput()
+	{
+		const char* const badLines[] =
+		{
+			"q100:AAAA",                  // no count
+			"q100:2:AAAA",                // count does not match the three values
+			"q100:4:AAAA",
+			"q100:1:AA!A",                // invalid base64
+			"q100:1://///////////w==",    // varint out of range
+			"f32:1:AAAA",                 // too few bytes
+			"f32:2:AAAA",
+			"f32:99999999999:AAAA",
+			"1 2 x",                      // trailing text
+			"1 2 3x",
+		};
+
+		for(const char* bad : badLines)
+		{
+			std::vector<double> decoded{1., 2.};
+			TEST_CHECK(!SegLineCodec::decode(bad, decoded));
+			TEST_CHECK(decoded.empty());
+		}
+
+		std::vector<double> decoded;
+		TEST_CHECK(SegLineCodec::decode(" 1 2\n3 ", decoded));
+		TEST_CHECK(decoded.size() == 3);
+	}
+}
+
+
+int main()
+{
+	testRoundTrip();
+	testEncodeRange();
+	testRejectBadInput();
+	return testResult();
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdint>
+
+#include <opencv/cv.h>
+
+#include <data_structure/simplecvmatcompress.h>
+
+#include "testhelper.h"
+
+
+namespace
+{
+	const int rows = 40;
+	const int cols = 300;
+
+	cv::Mat createMat()
+	{
+		cv::Mat mat(rows, cols, cv::DataType<uint8_t>::type);
+		for(int row = 0; row < rows; ++row)
+			for(int col = 0; col < cols; ++col)
+				mat.at<uint8_t>(row, col) = static_cast<uint8_t>(row < 10 + col/20 ? 1 : 2);
+		return mat;
+	}
+
+	bool sameMat(const cv::Mat& a, const cv::Mat& b)
+	{
+		if(a.rows != b.rows || a.cols != b.cols)
+			return false;
+		for(int row = 0; row < a.rows; ++row)
+			for(int col = 0; col < a.cols; ++col)
+				if(a.at<uint8_t>(row, col) != b.at<uint8_t>(row, col))
+					return false;
+		return true;
+	}
+
+
+	void testUndoRedo()
+	{
+		const cv::Mat oldMat = createMat();
+		cv::Mat newMat = oldMat.clone();
+		newMat.at<uint8_t>(12, 31) = 7;
+		newMat.at<uint8_t>(20, 200) = 0;
+		newMat.at<uint8_t>(15, 100) = 3;
+
+		SimpleCvMatCompress compress;
+		compress.readFromMat(oldMat);
+
+		// the diff covers the bounding rect of the changes
+		int x = -1;
+		int y = -1;
+		SimpleCvMatCompress diff;
+		TEST_CHECK(compress.createXorDiff(newMat, x, y, diff));
+		TEST_CHECK(x == 31 && y == 12);
+		TEST_CHECK(diff.getCols() == 200 - 31 + 1 && diff.getRows() == 20 - 12 + 1);
+
+		// redo: old state to new state
+		cv::Mat actMat = oldMat.clone();
+		TEST_CHECK(compress.applyXorDiff(actMat, x, y, diff));
+		TEST_CHECK(sameMat(actMat, newMat));
+		TEST_CHECK(compress == newMat);
+
+		// undo: the same diff restores the old state
+		TEST_CHECK(compress.applyXorDiff(actMat, x, y, diff));
+		TEST_CHECK(sameMat(actMat, oldMat));
+		TEST_CHECK(compress == oldMat);
+	}
+
+	void testNoChange()
+	{
+		const cv::Mat mat = createMat();
+		SimpleCvMatCompress compress;
+		compress.readFromMat(mat);
+
+		int x = -1;
+		int y = -1;
+		SimpleCvMatCompress diff(3, 3, 1);
+		TEST_CHECK(compress.createXorDiff(mat, x, y, diff));
+		TEST_CHECK(diff.getRows() == 0 && diff.getCols() == 0);
+	}
+
+	void testInvalid()
+	{
+		cv::Mat mat = createMat();
+		SimpleCvMatCompress compress;
+		compress.readFromMat(mat);
+
+		int x;
+		int y;
+		SimpleCvMatCompress diff;
+		const cv::Mat smallMat(rows - 1, cols, cv::DataType<uint8_t>::type);
+		TEST_CHECK(!compress.createXorDiff(smallMat, x, y, diff));
+
+		// a diff outside of the mat changes nothing
+		const SimpleCvMatCompress bigDiff(5, 5, 1);
+		TEST_CHECK(!compress.applyXorDiff(mat, cols - 4, 0, bigDiff));
+		TEST_CHECK(!compress.applyXorDiff(mat, -1, 0, bigDiff));
+		TEST_CHECK(compress == createMat());
+		TEST_CHECK(sameMat(mat, createMat()));
+	}
+}
+
+
+int main()
+{
+	testUndoRedo();
+	testNoChange();
+	testInvalid();
+	return testResult();
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/archive/text_iarchive.hpp>
+
+#include <data_structure/simplematcompress.h>
+
+#include "testhelper.h"
+
+
+namespace
+{
+	const int rows = 37;
+	const int cols = 513; // not a multiple of the vector width
+
+	// segmentation like data: long runs with a few short ones
+	std::vector<uint8_t> createMat(uint32_t seed)
+	{
+		std::vector<uint8_t> mat(static_cast<std::size_t>(rows*cols));
+		uint8_t value = 0;
+		for(uint8_t& pixel : mat)
+		{
+			seed = seed*1664525u + 1013904223u;
+			if((seed >> 24) < 8)
+				value = static_cast<uint8_t>((seed >> 8) & 3);
+			pixel = value;
+		}
+		return mat;
+	}
+
+	std::vector<uint8_t> getRect(const std::vector<uint8_t>& mat, int x, int y, int width, int height)
+	{
+		std::vector<uint8_t> rect;
+		for(int row = y; row < y + height; ++row)
+			rect.insert(rect.end(), mat.begin() + row*cols + x, mat.begin() + row*cols + x + width);
+		return rect;
+	}
+
+
+	void testRoundTrip()
+	{
+		const std::vector<uint8_t> mat = createMat(1);
+
+		SimpleMatCompress compress;
+		TEST_CHECK(compress.readFromMat(mat.data(), rows, cols));
+		TEST_CHECK(compress.isEqual(mat.data(), rows, cols));
+
+		std::vector<uint8_t> decoded(mat.size());
+		TEST_CHECK(compress.writeToMat(decoded.data(), rows, cols));
+		TEST_CHECK(decoded == mat);
+		TEST_CHECK(!compress.writeToMat(decoded.data(), rows, cols+1));
+
+		std::vector<uint8_t> changed = mat;
+		changed.back() = static_cast<uint8_t>(changed.back() + 1);
+		TEST_CHECK(!compress.isEqual(changed.data(), rows, cols));
+
+		SimpleMatCompress uniform(rows, cols, 5);
+		TEST_CHECK(uniform.isEmpty(5));
+		TEST_CHECK(!compress.isEmpty(5));
+	}
+
+	void testWriteRect()
+	{
+		const std::vector<uint8_t> mat = createMat(2);
+		SimpleMatCompress compress;
+		compress.readFromMat(mat.data(), rows, cols);
+
+		const int rects[][4] = {{0, 0, cols, rows}, {0, 0, 1, 1}, {cols-1, rows-1, 1, 1}, {17, 3, 200, 9}, {100, 0, 1, rows}, {0, 20, cols, 1}};
+		for(const int* r : rects)
+		{
+			std::vector<uint8_t> rect(static_cast<std::size_t>(r[2]*r[3]));
+			TEST_CHECK(compress.writeRectToMat(rect.data(), r[2], r[0], r[1], r[2], r[3]));
+			TEST_CHECK(rect == getRect(mat, r[0], r[1], r[2], r[3]));
+		}
+
+		std::vector<uint8_t> rect(static_cast<std::size_t>(cols*rows));
+		TEST_CHECK(!compress.writeRectToMat(rect.data(), cols, 1, 0, cols, 1));
+		TEST_CHECK(!compress.writeRectToMat(rect.data(), cols, 0, rows, 1, 1));
+		TEST_CHECK(!compress.writeRectToMat(rect.data(), cols, -1, 0, 1, 1));
+	}
+
+	void testPatchRect()
+	{
+		std::vector<uint8_t> mat = createMat(3);
+		SimpleMatCompress compress;
+		compress.readFromMat(mat.data(), rows, cols);
+
+		const std::vector<uint8_t> other = createMat(4);
+		const int x = 50, y = 10, width = 300, height = 7;
+
+		// patch from a full size mat, the rect is read with the stride of the mat
+		TEST_CHECK(compress.patchRect(other.data() + y*cols + x, cols, x, y, width, height));
+		for(int row = y; row < y + height; ++row)
+			for(int col = x; col < x + width; ++col)
+				mat[static_cast<std::size_t>(row*cols + col)] = other[static_cast<std::size_t>(row*cols + col)];
+
+		TEST_CHECK(compress.isEqual(mat.data(), rows, cols));
+
+		SimpleMatCompress expected;
+		expected.readFromMat(mat.data(), rows, cols);
+		TEST_CHECK(compress == expected);
+
+		int firstRow = -1;
+		int endRow   = -1;
+		TEST_CHECK(compress.findChangedRows(mat.data(), rows, cols, firstRow, endRow));
+		TEST_CHECK(firstRow == endRow);
+
+		mat[static_cast<std::size_t>(5*cols + 7)] ^= 1;
+		mat[static_cast<std::size_t>(30*cols + cols-1)] ^= 1;
+		TEST_CHECK(compress.findChangedRows(mat.data(), rows, cols, firstRow, endRow));
+		TEST_CHECK(firstRow == 5 && endRow == 31);
+		TEST_CHECK(!compress.findChangedRows(mat.data(), rows-1, cols, firstRow, endRow));
+	}
+
+	void testSerialization()
+	{
+		const std::vector<uint8_t> mat = createMat(5);
+		SimpleMatCompress compress;
+		compress.readFromMat(mat.data(), rows, cols);
+
+		std::stringstream stream;
+		{
+			boost::archive::text_oarchive oa(stream);
+			oa << compress;
+		}
+		SimpleMatCompress loaded;
+		{
+			boost::archive::text_iarchive ia(stream);
+			ia >> loaded;
+		}
+		TEST_CHECK(loaded == compress);
+
+		// the row index is rebuilt by the load
+		std::vector<uint8_t> rect(10*4);
+		TEST_CHECK(loaded.writeRectToMat(rect.data(), 10, 400, 30, 10, 4));
+		TEST_CHECK(rect == getRect(mat, 400, 30, 10, 4));
+
+		std::string binary;
+		compress.writeBinary(binary);
+		SimpleMatCompress binLoaded;
+		TEST_CHECK(binLoaded.readBinary(binary.data(), binary.size()));
+		TEST_CHECK(binLoaded == compress);
+		TEST_CHECK(binLoaded.writeRectToMat(rect.data(), 10, 0, 0, 10, 4));
+		TEST_CHECK(rect == getRect(mat, 0, 0, 10, 4));
+		TEST_CHECK(!binLoaded.readBinary(binary.data(), binary.size() - 1));
+	}
+}
+
+
+int main()
+{
+	testRoundTrip();
+	testWriteRect();
+	testPatchRect();
+	testSerialization();
+	return testResult();
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cmath>
+#include <vector>
+
+#include <data_structure/slobscandistancemap.h>
+#include <data_structure/slointerpolationoperator.h>
+
+#include "testhelper.h"
+
+typedef SloBScanDistanceMap::InfoBScanDist     InfoBScanDist;
+typedef SloBScanDistanceMap::PreCalcDataMatrix PreCalcDataMatrix;
+
+
+namespace
+{
+	const std::size_t sizeX = 70; // more than one word of init bits
+	const std::size_t sizeY = 3;
+
+	/*
+	 * b-scan 0 has 4 a-scans, b-scan 1 has 5 a-scans
+	 * (0, 0): no a-scan
+	 * (1, 0): only b-scan 0, a-scan 2
+	 * (2, 0): b-scan 0, a-scan 3 at distance 1 and b-scan 1, a-scan 0 at distance 3
+	 * (3, 0): on b-scan 0, a-scan 3, the second b-scan is not used
+	 * (65, 2): b-scan 1, a-scan 4 at distance 1 and b-scan 0, a-scan 1 at distance 2
+	 */
+	void fillDistMatrix(PreCalcDataMatrix& distMatrix)
+	{
+		distMatrix.updateValue( 1, 0, InfoBScanDist(1.f, 0, 2));
+		distMatrix.updateValue( 2, 0, InfoBScanDist(3.f, 1, 0));
+		distMatrix.updateValue( 2, 0, InfoBScanDist(1.f, 0, 3));
+		distMatrix.updateValue( 3, 0, InfoBScanDist(0.f, 0, 3));
+		distMatrix.updateValue( 3, 0, InfoBScanDist(2.f, 1, 1));
+		distMatrix.updateValue(65, 2, InfoBScanDist(2.f, 0, 1));
+		distMatrix.updateValue(65, 2, InfoBScanDist(1.f, 1, 4));
+	}
+
+	std::vector<float> createValues(const SloInterpolationOperator& op)
+	{
+		std::vector<float> values(op.getValueCount());
+		for(std::size_t i = 0; i < values.size(); ++i)
+			values[i] = static_cast<float>(i*10);
+		return values;
+	}
+
+	bool near(float a, float b)                                     { return std::abs(a - b) < 1e-4f; }
+
+
+	void testValueIndex()
+	{
+		PreCalcDataMatrix distMatrix(sizeX, sizeY);
+		fillDistMatrix(distMatrix);
+		const SloInterpolationOperator op(distMatrix);
+
+		TEST_CHECK(op.getSizeX() == sizeX && op.getSizeY() == sizeY);
+		TEST_CHECK(op.getNumBScans() == 2);
+		TEST_CHECK(op.getNumAScans(0) == 4 && op.getNumAScans(1) == 5);
+		TEST_CHECK(op.getValueCount() == 10);
+		TEST_CHECK(op.getValueIndex(1, 2) == 6);
+		TEST_CHECK(op.getNoAScanIndex() == 9);
+	}
+
+	void testKernels()
+	{
+		PreCalcDataMatrix distMatrix(sizeX, sizeY);
+		fillDistMatrix(distMatrix);
+		const SloInterpolationOperator op(distMatrix);
+
+		std::vector<float> values = createValues(op);
+		const float noAScan = -1.f;
+		values[op.getNoAScanIndex()] = noAScan;
+
+		std::vector<float> row(sizeX);
+		op.gatherNearest(values.data(), 0, 0, sizeX, row.data());
+		TEST_CHECK(row[0] == noAScan);
+		TEST_CHECK(row[1] == values[op.getValueIndex(0, 2)]);
+		TEST_CHECK(row[2] == values[op.getValueIndex(0, 3)]);
+		TEST_CHECK(row[3] == values[op.getValueIndex(0, 3)]);
+		TEST_CHECK(row[4] == noAScan);
+
+		op.interpolate(values.data(), 0, 0, sizeX, row.data());
+		TEST_CHECK(row[0] == noAScan);
+		TEST_CHECK(near(row[1], values[op.getValueIndex(0, 2)]));
+		TEST_CHECK(near(row[2], 0.75f*values[op.getValueIndex(0, 3)] + 0.25f*values[op.getValueIndex(1, 0)]));
+		TEST_CHECK(near(row[3], values[op.getValueIndex(0, 3)]));
+
+		op.interpolate(values.data(), 2, 0, sizeX, row.data());
+		TEST_CHECK(near(row[65], 2.f/3.f*values[op.getValueIndex(1, 4)] + 1.f/3.f*values[op.getValueIndex(0, 1)]));
+		TEST_CHECK(row[64] == noAScan && row[66] == noAScan);
+
+		// a missing second value uses the nearest a-scan, a missing nearest value gives NaN
+		values[op.getValueIndex(1, 0)] = NAN;
+		values[op.getValueIndex(1, 4)] = NAN;
+		op.interpolate(values.data(), 0, 2, 3, row.data());
+		TEST_CHECK(near(row[2], values[op.getValueIndex(0, 3)]));
+		op.interpolate(values.data(), 2, 65, 66, row.data());
+		TEST_CHECK(std::isnan(row[65]));
+
+		// the full map through row pointers
+		std::vector<float> map(sizeX*sizeY);
+		op.gatherNearest(values.data(), [&map](std::size_t y) { return map.data() + y*sizeX; });
+		TEST_CHECK(map[1] == values[op.getValueIndex(0, 2)]);
+		TEST_CHECK(std::isnan(map[2*sizeX + 65]));
+	}
+
+	void testPixelRuns()
+	{
+		PreCalcDataMatrix distMatrix(sizeX, sizeY);
+		fillDistMatrix(distMatrix);
+		const SloInterpolationOperator op(distMatrix);
+
+		const SloInterpolationOperator::PixelRun* run = op.getPixelRunsBegin(0);
+		TEST_CHECK(op.getPixelRunsEnd(0) - run == 2);
+		TEST_CHECK(run[0].y == 0 && run[0].xBegin ==  1 && run[0].xEnd ==  4);
+		TEST_CHECK(run[1].y == 2 && run[1].xBegin == 65 && run[1].xEnd == 66);
+
+		run = op.getPixelRunsBegin(1);
+		TEST_CHECK(op.getPixelRunsEnd(1) - run == 2);
+		TEST_CHECK(run[0].y == 0 && run[0].xBegin ==  2 && run[0].xEnd ==  3);
+		TEST_CHECK(run[1].y == 2 && run[1].xBegin == 65 && run[1].xEnd == 66);
+	}
+
+	void testGeneration()
+	{
+		PreCalcDataMatrix distMatrix(sizeX, sizeY);
+		fillDistMatrix(distMatrix);
+
+		std::size_t lastGeneration = 0;
+		for(int i = 0; i < 3; ++i)
+		{
+			// a new operator can reuse the address of the deleted one, the generation differs
+			const SloInterpolationOperator* op = new SloInterpolationOperator(distMatrix);
+			TEST_CHECK(op->getGeneration() != lastGeneration);
+			lastGeneration = op->getGeneration();
+			delete op;
+		}
+	}
+}
+
+
+int main()
+{
+	testValueIndex();
+	testKernels();
+	testPixelRuns();
+	testGeneration();
+	return testResult();
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <iostream>
+
+// minimal checks for the test programs, a test returns testResult() from main
+namespace TestHelper
+{
+	inline int& failures()                                          { static int counter = 0; return counter; }
+}
+
+#define TEST_CHECK(cond) \
+	do { if(!(cond)) { std::cerr << __FILE__ << ':' << __LINE__ << ": check failed: " #cond "\n"; ++TestHelper::failures(); } } while(false)
+
+inline int testResult()
+{
+	if(TestHelper::failures() > 0)
+		std::cerr << TestHelper::failures() << " checks failed\n";
+	return TestHelper::failures() == 0 ? 0 : 1;
+}